@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui printsupport
+QT       += core gui printsupport concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -42,12 +42,21 @@ SOURCES += \
     cad/rectnestengine.cpp \
     cad/packpointnestengine.cpp \
     cad/continuenestengine.cpp \
+    cad/rotatedpiececache.cpp \
+    cad/piecepreprocessor.cpp \
+    cad/bestnesttypecache.cpp \
+    cad/packpointgrid.cpp \
     common/common.cpp \
     common/painter.cpp \
     common/customdocktitlebar.cpp \
     common/customwidget.cpp \
     common/GA.cpp \
     common/collisiondectect.cpp \
+    common/satkernel.cpp \
+    common/nofitpolygon.cpp \
+    common/fixedpoint.cpp \
+    common/occupancyraster.cpp \
+    common/polygonoffset.cpp \
     dxf/dxflib/dl_writer_ascii.cpp \
     dxf/dxflib/dl_dxf.cpp \
     dxf/dxffilter.cpp \
@@ -104,6 +113,10 @@ HEADERS += \
     cad/rectnestengine.h \
     cad/packpointnestengine.h \
     cad/continuenestengine.h \
+    cad/rotatedpiececache.h \
+    cad/piecepreprocessor.h \
+    cad/bestnesttypecache.h \
+    cad/packpointgrid.h \
     common/debug.h \
     common/common.h \
     common/painter.h \
@@ -113,6 +126,11 @@ HEADERS += \
     common/binarytree.h \
     common/ternarytree.h \
     common/collisiondectect.h \
+    common/satkernel.h \
+    common/nofitpolygon.h \
+    common/fixedpoint.h \
+    common/occupancyraster.h \
+    common/polygonoffset.h \
     common/quadtreenode.h \
     dxf/dxflib/dl_writer.h \
     dxf/dxflib/dl_writer_ascii.h \
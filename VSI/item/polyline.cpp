@@ -285,6 +285,7 @@ QRectF Polyline::getBoundingRect()
 Polyline *Polyline::copy()
 {
     Polyline *p = new Polyline(this);
+    p->setShapeType(getShapeType());  // 保留内孔等类型
     p->setPolyline(points, type, elevation, alpha, offset);
     p->setRLines(this->rLines);
     return p;
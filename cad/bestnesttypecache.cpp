@@ -0,0 +1,210 @@
+﻿#include "bestnesttypecache.h"
+#include "common.h"
+#include <QFile>
+#include <QStringList>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QDebug>
+#include <qnumeric.h>
+
+BestNestTypeCache::BestNestTypeCache() :
+    modified(false)
+{
+
+}
+
+/**
+ * @brief BestNestTypeCache::key
+ * 对零件几何与约束的文本表示取SHA-1，
+ * 坐标平移至外包矩形左上角后按精度取整，加0.0将-0统一为0。
+ * 左上角由顶点坐标取得，不像位置点那样经过取整，平移后的零件仍得到相同的键
+ * @param piece  待排零件
+ * @param taskList  该零件的分析任务
+ * @param angleTolerance  旋转角度优化精度
+ * @param maxAngleEvaluations  每个局部极小值细化时的最大求值次数
+ * @return 40位十六进制字符串
+ */
+QString BestNestTypeCache::key(const Piece &piece,
+                               const QVector<NestEngine::BestNestTypeTask> &taskList,
+                               const qreal angleTolerance,
+                               const int maxAngleEvaluations)
+{
+    QByteArray data;
+    QPointF origin = piece.getBoundingRect().topLeft();
+    auto appendPoints = [&](const QVector<QPointF> &points){
+        data.append('P');
+        foreach (QPointF point, points) {
+            QPointF p = pointPrecision(point - origin, PRECISION);
+            data.append(QByteArray::number(p.x() + 0.0, 'f', PRECISION)).append(',');
+            data.append(QByteArray::number(p.y() + 0.0, 'f', PRECISION)).append(';');
+        }
+    };
+    appendPoints(piece.getPointsList());  // 外轮廓
+    foreach (const QVector<QPointF> &hole, piece.getHolesList()) {  // 内孔
+        appendPoints(hole);
+    }
+
+    data.append('T');
+    foreach (const NestEngine::BestNestTypeTask &task, taskList) {
+        data.append(QByteArray::number(task.strategy)).append(',');
+        data.append(QByteArray::number(task.minAngle)).append(',');
+        data.append(QByteArray::number(task.maxAngle)).append(',');
+        data.append(QByteArray::number(task.maxWidth, 'g', 17)).append(',');
+        data.append(QByteArray::number(task.maxHeight, 'g', 17)).append(';');
+    }
+    data.append('A');
+    data.append(QByteArray::number(angleTolerance, 'g', 17)).append(',');
+    data.append(QByteArray::number(maxAngleEvaluations)).append(',');
+    data.append(QByteArray::number(PRECISION));
+
+    return QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex());
+}
+
+/**
+ * @brief BestNestTypeCache::load
+ * 文件不存在时返回false，不视为错误；
+ * 根节点或版本不符时清空缓存，之后保存会覆盖旧文件
+ * @param fileName  缓存文件
+ * @return 是否读取成功
+ */
+bool BestNestTypeCache::load(const QString &fileName)
+{
+    bestNestTypeMap.clear();
+    modified = false;
+    QFile file(fileName);
+    if(!file.exists()){
+        return false;
+    }
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        qDebug() << "最佳排版方式缓存文件无法正常打开：" << fileName;
+        return false;
+    }
+
+    QXmlStreamReader r(&file);
+    if(!r.readNextStartElement() || r.name() != "BESTNESTTYPECACHE"
+            || r.attributes().value("version").toInt() != BEST_NEST_TYPE_CACHE_VERSION){
+        qDebug() << "最佳排版方式缓存版本不符，已失效";
+        modified = true;
+        return false;
+    }
+    int invalidCount = 0;  // 非法记录个数
+    while(r.readNextStartElement()){
+        if(r.name() != "entry"){
+            r.skipCurrentElement();
+            continue;
+        }
+        QString key = r.attributes().value("key").toString();
+        QMap<QString, qreal> valueMap;  // 字段名-值
+        bool valid = key.length() == 40;  // SHA-1的十六进制长度
+        while(r.readNextStartElement()){
+            bool ok;
+            QString name = r.name().toString();
+            qreal value = r.readElementText().toDouble(&ok);
+            if(!ok || !qIsFinite(value)){
+                valid = false;
+            }
+            valueMap.insert(name, value);
+        }
+        QStringList nameList;
+        nameList << "nestType" << "alpha" << "xStep" << "pOffsetX" << "pOffsetY" << "yStep";
+        foreach (QString name, nameList) {
+            if(!valueMap.contains(name)){
+                valid = false;
+            }
+        }
+        int nestType = qRound(valueMap.value("nestType", -1));
+        if(nestType < NestEngine::NoNestType || nestType > NestEngine::OppositeDoubleRow){
+            valid = false;
+        }
+        if(!valid){
+            invalidCount++;
+            continue;
+        }
+        NestEngine::BestNestType bestNestType;
+        bestNestType.nestType = (NestEngine::NestType)nestType;
+        bestNestType.alpha = valueMap["alpha"];
+        bestNestType.xStep = valueMap["xStep"];
+        bestNestType.pOffset = QPointF(valueMap["pOffsetX"], valueMap["pOffsetY"]);
+        bestNestType.yStep = valueMap["yStep"];
+        bestNestTypeMap.insert(key, bestNestType);
+    }
+    if(r.hasError()){
+        qDebug() << "最佳排版方式缓存文件格式错误，已失效：" << r.errorString();
+        bestNestTypeMap.clear();
+        modified = true;
+        return false;
+    }
+    if(invalidCount > 0){  // 保存时去掉非法记录
+        qDebug() << "最佳排版方式缓存丢弃非法记录" << invalidCount << "条";
+        modified = true;
+    }
+    return true;
+}
+
+/**
+ * @brief BestNestTypeCache::save
+ * 浮点数按17位有效数字写入，读回后与计算结果完全一致
+ * @param fileName  缓存文件
+ * @return 是否写入成功
+ */
+bool BestNestTypeCache::save(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "最佳排版方式缓存文件无法正常写入：" << fileName;
+        return false;
+    }
+
+    QXmlStreamWriter w(&file);
+    w.setAutoFormattingIndent(8);
+    w.setAutoFormatting(true);
+    w.writeStartDocument();
+    w.writeStartElement("BESTNESTTYPECACHE");
+    w.writeAttribute("version", QString::number(BEST_NEST_TYPE_CACHE_VERSION));
+    QMap<QString, NestEngine::BestNestType>::const_iterator it;
+    for(it=bestNestTypeMap.constBegin(); it!=bestNestTypeMap.constEnd(); ++it){
+        const NestEngine::BestNestType &bestNestType = it.value();
+        w.writeStartElement("entry");
+        w.writeAttribute("key", it.key());
+        w.writeTextElement("nestType", QString::number(bestNestType.nestType));
+        w.writeTextElement("alpha", QString::number(bestNestType.alpha, 'g', 17));
+        w.writeTextElement("xStep", QString::number(bestNestType.xStep, 'g', 17));
+        w.writeTextElement("pOffsetX", QString::number(bestNestType.pOffset.x(), 'g', 17));
+        w.writeTextElement("pOffsetY", QString::number(bestNestType.pOffset.y(), 'g', 17));
+        w.writeTextElement("yStep", QString::number(bestNestType.yStep, 'g', 17));
+        w.writeEndElement();
+    }
+    w.writeEndElement();
+    w.writeEndDocument();
+
+    file.close();
+    modified = false;
+    return true;
+}
+
+bool BestNestTypeCache::value(const QString &key, NestEngine::BestNestType &bestNestType) const
+{
+    if(!bestNestTypeMap.contains(key)){
+        return false;
+    }
+    bestNestType = bestNestTypeMap.value(key);
+    return true;
+}
+
+void BestNestTypeCache::insert(const QString &key, const NestEngine::BestNestType &bestNestType)
+{
+    bestNestTypeMap.insert(key, bestNestType);
+    modified = true;
+}
+
+int BestNestTypeCache::size() const
+{
+    return bestNestTypeMap.size();
+}
+
+bool BestNestTypeCache::isModified() const
+{
+    return modified;
+}
@@ -0,0 +1,42 @@
+﻿#ifndef BESTNESTTYPECACHE_H
+#define BESTNESTTYPECACHE_H
+
+#include <QMap>
+#include <QString>
+#include "nestengine.h"
+
+#define BEST_NEST_TYPE_CACHE_XML "best_nest_type_cache.xml"  // 与sheet.xml位于同一目录
+#define BEST_NEST_TYPE_CACHE_VERSION 1  // 最佳排版方式分析算法的版本，算法改变时加1，旧缓存自动失效
+
+/**
+ * @brief The BestNestTypeCache class
+ * 最佳排版方式的磁盘缓存，键为零件几何与分析约束的哈希。
+ * 轮廓与内孔平移至外包矩形左上角后按精度取整，同一零件在不同位置得到相同的键；
+ * 旋转角度与偏移量都在零件自身的坐标系中表示，且搜索的角度区间与零件朝向有关，因此不对旋转归一化。
+ * 约束由分析任务列表(排版策略、角度区间、宽高限制)与角度优化参数给出。
+ * 文件记录算法版本，版本不一致或格式错误时丢弃整个文件，单条记录非法时只丢弃该条
+ */
+class BestNestTypeCache
+{
+public:
+    BestNestTypeCache();
+
+    static QString key(const Piece &piece,
+                       const QVector<NestEngine::BestNestTypeTask> &taskList,
+                       const qreal angleTolerance,
+                       const int maxAngleEvaluations);  // 计算缓存的键
+
+    bool load(const QString &fileName = BEST_NEST_TYPE_CACHE_XML);  // 读取缓存文件
+    bool save(const QString &fileName = BEST_NEST_TYPE_CACHE_XML);  // 写入缓存文件
+
+    bool value(const QString &key, NestEngine::BestNestType &bestNestType) const;  // 获取缓存的最佳排版方式，pieceID与rCOffset由调用者设置
+    void insert(const QString &key, const NestEngine::BestNestType &bestNestType);  // 插入最佳排版方式
+    int size() const;  // 缓存个数
+    bool isModified() const;  // 读取之后是否有改动
+
+private:
+    QMap<QString, NestEngine::BestNestType> bestNestTypeMap;  // 键-最佳排版方式
+    bool modified;  // 读取之后是否有改动
+};
+
+#endif // BESTNESTTYPECACHE_H
@@ -1,4 +1,6 @@
 ﻿#include "continuenestengine.h"
+#include <QSet>
+#include <limits>
 
 ContinueNestEngine::ContinueNestEngine(QObject *parent) :
     NestEngine(parent)
@@ -257,7 +259,7 @@ bool ContinueNestEngine::packPieceByLayoutRect(const int sheetID,
     qreal pairWidth, pairHeight, pieceWidth, pieceHeight, alpha1, alpha2, xStep;
     QPointF pos1, pos2;
 
-    Piece piece = pieceList[pieceType];  // 复制零件
+    Piece piece = getGapPiece(pieceList[pieceType]);  // 复制零件，外轮廓含零件间距的一半，各行按其外包矩形排列
     // qreal yStep = status.yStep;  // 记录yStep
     qDebug() << "to nest $" << pieceIndex << ", bestNestType: " << (int)bestNestType.nestType;
     status = initPairPieceStatus(layoutRect, piece, bestNestType);  // 初始化排版状态
@@ -272,7 +274,7 @@ bool ContinueNestEngine::packPieceByLayoutRect(const int sheetID,
                 (bestNestType.nestType & DoubleRow) != NoNestType ||
                 (bestNestType.nestType & OppositeDoubleRow) != NoNestType){
             // 代表矩形内放不下该零件，需要重新进行排版方式计算
-            Piece piece = pieceList[pieceType];  // 复制零件
+            Piece piece = getGapPiece(pieceList[pieceType]);  // 复制零件，步距包含零件间距
             qreal alpha, xStep;
             QPointF pOffset, rCOffset;
             qreal maxWidth = layoutRect.width();
@@ -498,7 +500,7 @@ bool ContinueNestEngine::packPieceByLayoutRect(const int sheetID,
                 }
                 foreach (int type, typeList) {
                     qDebug() << "type: " << type;
-                    Piece pTailLine = pieceList[type];  // 复制该零件
+                    Piece pTailLine = getGapPiece(pieceList[type]);  // 复制该零件，步距包含零件间距
                     qreal alphaTailLine, xStepTailLine;
                     QPointF pOffsetTailLine, rCOffsetTailLine;
                     NestType nestType = getPieceBestNestType(pTailLine, alphaTailLine,
@@ -693,11 +695,11 @@ bool ContinueNestEngine::packPieceByReferenceLine(const int sheetID,
 
                 // 向前一个零件靠接
                 Piece pieceTmp = piece;
-                qreal xOffset = pieceTmp.compactToOnHD(pieceLast, compactStep, compactAccuracy);
+                qreal xOffset = pieceTmp.compactToOnHD(pieceLast);
                 QPointF pos2Temp = singlePieceStatus.pos - QPointF(xOffset, 0);
                 QPointF pos1Temp = pos1;
-                // 检测与其他零件是否碰撞
-                if(collidesWithOtherPieces(sheetID, pieceTmp)){
+                // 检测与其他零件是否碰撞，按设置的碰撞检测方式(分离轴或临界多边形)
+                if(collidesWithNestedPieces(sheetID, pieceTmp, pieceType, singlePieceStatus.alpha, pos2Temp)){
                     QPointF offset = pos2Temp - pos1;
                     qreal xOffset1 = compactOnHD(sheetID, piece);
                     pos2Temp = singlePieceStatus.pos - QPointF(xOffset1, 0);
@@ -938,6 +940,56 @@ bool ContinueNestEngine::packTailPiece(const int sheetID,
     return false;
 }
 
+/**
+ * @brief ContinueNestEngine::packPiecesInHoles
+ * 将本次已排零件的内孔加入内孔四叉树，再按未排列表的顺序尝试将零件排入该材料上的内孔，
+ * 同类零件排不进时不再尝试该类的其余零件
+ * @param sheetID 材料ID
+ * @param nestedList 本次已排零件列表，位置已确定
+ * @param unnestedList 未排零件列表，排入内孔的零件从中删除
+ */
+void ContinueNestEngine::packPiecesInHoles(const int sheetID,
+                                           const QList<int> &nestedList,
+                                           QList<int> &unnestedList)
+{
+    foreach (int index, nestedList) {
+        insertNestedHoles(sheetID, index, getNestedPiece(index));  // 内孔加入内孔四叉树
+    }
+    if(!holeQuadTreeMap.contains(sheetID)){  // 该材料上没有内孔
+        return;
+    }
+    const int rotateNumber = 4;  // 内孔中尝试的旋转个数
+    QSet<int> failedTypes;  // 排不进内孔的零件类型
+    int i = 0;
+    while(i < unnestedList.length()){
+        int index = unnestedList.at(i);
+        NestPiece &nestPiece = nestPieceList[index];
+        if(failedTypes.contains(nestPiece.typeID)
+                || !packOnePieceInHoles(sheetID, nestPiece, rotateNumber, compactStep)){
+            failedTypes.insert(nestPiece.typeID);
+            i++;
+            continue;
+        }
+        qDebug() << "nested in hole *" << index;
+        nestedPieceIndexlist.append(index);  // 更新已排列表
+        nestSheetPieceMap[sheetID].append(index);  // 更新材料-零件索引
+        unnestedList.removeAt(i);  // 更新未排列表
+
+        nestedPieceCount++;  // 更新已排零件个数
+        int pro = (int)(((float)nestedPieceCount / unnestedPieceCount) * 100);
+        if(pro != progressPercent)
+        {
+            progressPercent = pro;
+            emit progress(pro);
+        }
+
+        // 将该对象加入四叉树中，其自身的内孔也可继续排放零件
+        const Piece &nestedPiece = getNestedPiece(index);
+        quadTreeMap[sheetID]->insert(new Object(index, nestedPiece.getBoundingRect()));
+        insertNestedHoles(sheetID, index, nestedPiece);
+    }
+}
+
 void ContinueNestEngine::packPieces(QVector<int> indexList)
 {
     // 零件排放未结束标志
@@ -996,6 +1048,9 @@ void ContinueNestEngine::packPieces(QVector<int> indexList)
                                                  sheetAvailable, sameRowPieceList,
                                                  nestedList, unnestedList, rectType,
                                                  layoutRect1, layoutRect2);
+                if(partInPart && !nestedList.isEmpty()){
+                    packPiecesInHoles(sheetID, nestedList, unnestedList);  // 本次已排零件位置已确定，将未排零件排入其内孔
+                }
 
                 if(!res){
                     // 该矩形内未能排放任何一个零件，则需要检查同行零件列表是否为空；
@@ -1155,14 +1210,14 @@ void ContinueNestEngine::packPieces(QVector<int> indexList)
     emit(nestFinished(nestPieceList));
 }
 
-bool ContinueNestEngine::packOnePiece(Piece piece, NestEngine::NestPiece &nestPiece)
+bool ContinueNestEngine::packOnePiece(const Piece &piece, NestEngine::NestPiece &nestPiece)
 {
     Q_UNUSED(piece);
     Q_UNUSED(nestPiece);
     return true;
 }
 
-bool ContinueNestEngine::packOnePieceOnSheet(Piece piece, int sheetID, NestEngine::NestPiece &nestPiece)
+bool ContinueNestEngine::packOnePieceOnSheet(const Piece &piece, int sheetID, NestEngine::NestPiece &nestPiece)
 {
     Q_UNUSED(piece);
     Q_UNUSED(sheetID);
@@ -1177,84 +1232,69 @@ bool ContinueNestEngine::compact(int sheetID, NestEngine::NestPiece &nestPiece)
     return true;
 }
 
-qreal ContinueNestEngine::compactOnHD(int sheetID, Piece piece)
+qreal ContinueNestEngine::compactOnHD(int sheetID, const Piece &piece)
 {
     //qDebug() << "水平方向靠接算法";
-    QPointF pos = piece.getPosition();
-    QPointF posOld = pos;  // 记录之前的位置
-    //qDebug() << "origin position: " << pos;
-    // 重力方向靠接
-    qreal stepX = compactStep;
-    while(stepX > compactAccuracy){
-        QPointF posTemp = pos;
-        QPointF forwardPos(posTemp.rx()-stepX, posTemp.ry());  // 重力反方向移动
-        //qDebug() << "move to" << forwardPos;
-        piece.moveTo(forwardPos);  // 将零件移至前进位置
-        if(piece.getBoundingRect().left() < sheetList[sheetID].layoutRect().left()){
-            //qDebug() << "超出材料范围";
-            stepX /= 2;
-            continue;
-        }
-        if(collidesWithOtherPieces(sheetID, piece)){
-            // 往下移
-            ///qDebug() << "collides with others";
-            stepX /= 2;
-            continue;
-        }
-        pos.setX(pos.rx() - stepX);
+    QRectF rect = piece.getBoundingRect();
+    qreal maxStep = rect.left() - sheetList[sheetID].layoutRect().left();  // 不超出材料范围
+    if(maxStep <= 0 || collidesWithOtherPieces(sheetID, piece)){
+        return 0;
     }
-    //qDebug() << "now position: " << pos;
-    piece.moveTo(pos);
-    qreal step = posOld.rx() - pos.rx();
+    // 零件向左扫过的区域
+    QRectF sweepRect(rect.left() - maxStep, rect.top(), rect.width() + maxStep, rect.height());
+    qreal step = slideDistanceToOtherPieces(sheetID, piece, QPointF(-1, 0), sweepRect);
+    step = qMin(step, maxStep);
     return step;
 }
 
-qreal ContinueNestEngine::compactOnVD(int sheetID, Piece piece)
+qreal ContinueNestEngine::compactOnVD(int sheetID, const Piece &piece)
 {
     //qDebug() << "垂直方向靠接算法";
-    QPointF pos = piece.getPosition();
-    QPointF posOld = pos;  // 记录之前的位置
-    //qDebug() << "origin position: " << pos;
-    // 重力方向靠接
-    qreal stepY = compactStep;
-    while(stepY > compactAccuracy){
-        QPointF posTemp = pos;
-        QPointF forwardPos(posTemp.rx(), posTemp.ry()-stepY);  // 重力反方向移动
-        //qDebug() << "move to" << forwardPos;
-        piece.moveTo(forwardPos);  // 将零件移至前进位置
-        if(collidesWithOtherPieces(sheetID, piece)){
-            // 往下移
-            ///qDebug() << "collides with others";
-            stepY /= 2;
-            continue;
-        }
-        pos.setY(pos.ry() - stepY);
+    QRectF rect = piece.getBoundingRect();
+    if(collidesWithOtherPieces(sheetID, piece)){
+        return 0;
     }
-    //qDebug() << "now position: " << pos;
-    qreal step = posOld.ry() - pos.ry();
+    // 零件向上扫过的区域，没有碰到其他零件时靠接至材料边缘
+    qreal maxStep = rect.top() - sheetList[sheetID].layoutRect().top();
+    QRectF sweepRect(rect.left(), rect.top() - qMax(maxStep, qreal(0)), rect.width(), rect.height() + qMax(maxStep, qreal(0)));
+    qreal step = slideDistanceToOtherPieces(sheetID, piece, QPointF(0, -1), sweepRect);
+    if(step == std::numeric_limits<qreal>::max()){
+        step = qMax(maxStep, qreal(0));
+    }
+    //qDebug() << "now position: " << QPointF(pos.rx(), pos.ry() - step);
     return step;
 }
 
-bool ContinueNestEngine::collidesWithOtherPieces(int sheetID, Piece piece)
+bool ContinueNestEngine::collidesWithOtherPieces(int sheetID, const Piece &piece)
 {
-    // 判断两两零件是否碰撞, 优化方案：使用四叉树进行管理
-    std::list<Object *> resObjects =
-            quadTreeMap[sheetID]->retrieve(new Object(piece.getBoundingRect()));
-    for(auto &t:resObjects){
-        int id = t->id;
-        int typeID = nestPieceList[id].typeID;
-        Piece pieceNested = pieceList[typeID];
-        pieceNested.moveTo(nestPieceList[id].position);
-        if(!isStripSheet){
-            pieceNested.rotate(nestPieceList[id].position, nestPieceList[id].alpha);
-        } else{
-            bool flag = nestPieceList[id].alpha == 0 ? true : false;
-            pieceNested.rotateByReferenceLine(nestPieceList[id].position, flag);
-        }
-        if(pieceNested.collidesWithPiece(piece)){
-            return true;
-        }
-        collisionCount++;
+    // 判断两两零件是否碰撞, 使用四叉树进行管理，已排零件使用缓存的形状批量检测
+    return collidesWithNestedPieceList(sheetID, piece);
+}
+
+/**
+ * @brief ContinueNestEngine::isNFPCollisionSupported
+ * 条形材料排版时零件按参考线旋转，临界多边形同样由placeNestedPiece变换得到，
+ * 角度(0/180)即参考线方向，因此两种排版方式都可以使用临界多边形检测
+ * @return
+ */
+bool ContinueNestEngine::isNFPCollisionSupported() const
+{
+    return true;
+}
+
+/**
+ * @brief ContinueNestEngine::placeNestedPiece
+ * 条形材料排版时零件按参考线旋转
+ * @param piece 零件
+ * @param nestPiece 排版零件
+ */
+void ContinueNestEngine::placeNestedPiece(Piece &piece, const NestEngine::NestPiece &nestPiece)
+{
+    if(!isStripSheet){
+        NestEngine::placeNestedPiece(piece, nestPiece);  // 旋转后的零件取自缓存
+        return;
     }
-    return false;
+    piece.moveTo(nestPiece.position);
+    bool flag = nestPiece.alpha == 0 ? true : false;
+    piece.rotateByReferenceLine(nestPiece.position, flag);
 }
@@ -75,13 +75,19 @@ public:
                        QRectF &layoutRect1,
                        int &packFlag, bool isStripSheet);  // 排放尾只
 
+    void packPiecesInHoles(const int sheetID,
+                           const QList<int> &nestedList,
+                           QList<int> &unnestedList);  // 将未排零件排入已排零件的内孔
+
     void packPieces(QVector<int> indexList) Q_DECL_OVERRIDE;  // 排版算法
-    bool packOnePiece(Piece piece, NestEngine::NestPiece &nestPiece) Q_DECL_OVERRIDE;  // 排放单个零件
-    bool packOnePieceOnSheet(Piece piece, int sheetID, NestEngine::NestPiece &nestPiece) Q_DECL_OVERRIDE;  // 在给定材料上排放单个零件
+    bool packOnePiece(const Piece &piece, NestEngine::NestPiece &nestPiece) Q_DECL_OVERRIDE;  // 排放单个零件
+    bool packOnePieceOnSheet(const Piece &piece, int sheetID, NestEngine::NestPiece &nestPiece) Q_DECL_OVERRIDE;  // 在给定材料上排放单个零件
     bool compact(int sheetID, NestPiece &nestPiece) Q_DECL_OVERRIDE;  // 紧凑算法
-    qreal compactOnHD(int sheetID, Piece piece);  // 水平方向靠接
-    qreal compactOnVD(int sheetID, Piece piece);  // 垂直方向靠接
-    bool collidesWithOtherPieces(int sheetID, Piece piece) Q_DECL_OVERRIDE;  // 判断该零件是否与其他零件碰撞
+    qreal compactOnHD(int sheetID, const Piece &piece);  // 水平方向靠接
+    qreal compactOnVD(int sheetID, const Piece &piece);  // 垂直方向靠接
+    bool collidesWithOtherPieces(int sheetID, const Piece &piece) Q_DECL_OVERRIDE;  // 判断该零件是否与其他零件碰撞
+    void placeNestedPiece(Piece &piece, const NestPiece &nestPiece) Q_DECL_OVERRIDE;  // 将零件变换至排版零件的位置、角度
+    bool isNFPCollisionSupported() const Q_DECL_OVERRIDE;  // 当前排版方式能否使用临界多边形检测
 
 };
 Q_DECLARE_OPERATORS_FOR_FLAGS(ContinueNestEngine::RectTypes)
@@ -17,6 +17,9 @@
 #include "packpointnestengine.h"
 #include "continuenestengine.h"
 #include "nestengineconfiguredialog.h"
+#include "piecepreprocessor.h"
+#include <QProgressDialog>
+#include <QEventLoop>
 #include <sys/time.h>
 #include "common.h"
 #include <QDebug>
@@ -1966,10 +1969,20 @@ void Nest::onNestFinished(QVector<NestEngine::NestPiece> nestPieceList)
                 PiecePoint piecePoint(offsetList[j].rx(), offsetList[j].ry(), RESERVE_DOUBLE);
                 pointsList.append(piecePoint);
             }
+            QVector<QVector<PiecePoint>> holesList;  // 用来保存内孔点列表
+            foreach (QVector<QPointF> holeOffset, pieceList[i]->getHolesOffset()) {
+                QVector<PiecePoint> hole;
+                for(int j=0;j<holeOffset.length();j++){
+                    PiecePoint piecePoint(holeOffset[j].rx(), holeOffset[j].ry(), RESERVE_DOUBLE);
+                    hole.append(piecePoint);
+                }
+                holesList.append(hole);
+            }
             PieceOffset pieceOffset(i, RESERVE_DOUBLE,
                                     RESERVE_DOUBLE, RESERVE_DOUBLE,
                                     RESERVE_STRING, RESERVE_DOUBLE,
-                                    RESERVE_INT, offsetList.length(), pointsList);
+                                    holesList.length(), offsetList.length(), pointsList,
+                                    holesList);
             proPieceOffsetMap[pName].append(pieceOffset);
         }
 
@@ -2014,6 +2027,15 @@ void Nest::onNestFinished(QVector<NestEngine::NestPiece> nestPieceList)
             p->setPolyline(offsetPoints, Polyline::line);
             p->i = nestPieceList[i].index;
             sceneList[sheetID]->addCustomPolylineItem(p);  // 将多边形加入该图层
+            foreach (QVector<QPointF> hole, piece.getHolesList()) {  // 内孔
+                for(int j=0; j<hole.length(); j++){
+                    hole[j] += sceneList[sheetID]->getOffset();
+                }
+                Polyline *h = new Polyline;
+                h->setPolyline(hole, Polyline::line);
+                h->i = nestPieceList[i].index;
+                sceneList[sheetID]->addCustomPolylineItem(h);
+            }
 
             // 保存零件中心点
             PieceCenter pieceCenter(i, sheetID, typeID, angle, RESERVE_INT, pos.rx(), pos.ry());
@@ -2123,6 +2145,15 @@ void Nest::onNestPieceUpdate(NestEngine::NestPiece nestPiece)
     p->setPolyline(offsetPoints, Polyline::line);
     p->i = nestPiece.index;
     sceneList[sheetID]->addCustomPolylineItem(p);  // 将多边形加入该图层
+    foreach (QVector<QPointF> hole, piece.getHolesList()) {  // 内孔
+        for(int j=0; j<hole.length(); j++){
+            hole[j] += sceneList[sheetID]->getOffset();
+        }
+        Polyline *h = new Polyline;
+        h->setPolyline(hole, Polyline::line);
+        h->i = nestPiece.index;
+        sceneList[sheetID]->addCustomPolylineItem(h);
+    }
 
     // 更新材料使用情况
     pieceCountList[sheetID]++;  // 切割件个数计数器
@@ -2413,6 +2444,10 @@ void Nest::onActionSheetAdd()
     nestEngine->setCompactAccuracy(0.25);
     nestEngine->setCutStep(300);
     nestEngine->setAutoRepeatLastSheet(true);
+    if(config->nfpCollision){  // 使用临界多边形进行碰撞检测
+        nestEngine->setCollisionBackend(NestEngine::NFPCollisionBackend);
+    }
+    nestEngine->setPartInPart(config->partInPart);  // 将零件排入已排零件的内孔
     NestEngineConfigure *proConfig = proNestEngineConfigMap[pName];
     nestEngine->initNestEngineConfig(proSheetInfo->sheetType, proConfig);  // 初始化排版配置
     connect(this, &Nest::nestStart, nestEngine, &NestEngine::onNestStart);
@@ -3090,6 +3125,7 @@ void Nest::onActionTreeProjectAddScene()
         Project *projectTmp = new Project(this); // 局部变量，用来记录导入的dxf文件
         try{
             projectTmp->setType(Project::Nest);
+            projectTmp->setTessellationTolerance(config->tessellationTolerance);
             projectTmp->dxfFileReader(fileName);
         } catch (QString exception){
             QMessageBox::warning(this, tr("错误"), exception);
@@ -3119,24 +3155,83 @@ void Nest::onActionTreeProjectAddScene()
             }
         }
 
-        // 检测参考线
+        // 被奇数个多边形包含的多边形为内孔，属于包含它的面积最小的多边形，不再作为单独的切割件。
+        // 标记为内孔的多边形(HOLE线型或图层)不参与计数，直接作为包含它的面积最小的多边形的内孔
+        QList<Polyline *> outlines;  // 外轮廓
+        QMap<Polyline *, QList<Polyline *>> holesMap;  // 外轮廓-内孔
         foreach (Polyline *polyline, polylines) {
-            Piece *piece = new Piece(polyline);  // 切割件个数默认为1，默认精确到6位
-            foreach (QLineF line, rLines) {
-                if(piece->onBoundary(line.p1()) &&
-                        piece->onBoundary(line.p2())){
-                    QVector<QLineF> lines;
-                    lines.append(line);
-                    piece->setReferenceLinesList(lines);
-                    polyline->setRLines(lines);
-                    break;
+            QVector<QPointF> points = polyline->getPoints();
+            QRectF rect = calculatePolygonBoundingRect(points);
+            bool markedHole = polyline->getShapeType() == Shape::Hole;
+            Polyline *parent = NULL;  // 包含该多边形的面积最小的多边形
+            qreal parentArea = LONG_MAX;
+            int depth = 0;  // 包含该多边形的多边形个数
+            foreach (Polyline *other, polylines) {
+                if(other == polyline || other->getShapeType() == Shape::Hole){
+                    continue;
+                }
+                QVector<QPointF> otherPoints = other->getPoints();
+                if(points.isEmpty() || otherPoints.length() < 3
+                        || !boundingRectContain(calculatePolygonBoundingRect(otherPoints), rect)
+                        || !polygonContainsPolygon(otherPoints, points)){  // 须完全包含，不能只看一个顶点
+                    continue;
+                }
+                depth++;
+                qreal area = calculatePolygonArea(otherPoints);
+                if(area < parentArea){
+                    parentArea = area;
+                    parent = other;
                 }
             }
+            if(markedHole){
+                if(parent){  // 不在任何零件内的内孔忽略
+                    holesMap[parent].append(polyline);
+                }
+            } else if(depth % 2 == 1){
+                holesMap[parent].append(polyline);
+            } else{
+                outlines.append(polyline);
+            }
+        }
+
+        // 在线程池中预处理切割件(几何计算、内孔、参考线、简化外轮廓)，完成前界面显示进度
+        QVector<PiecePreprocessor::PieceSource> sourceList;
+        foreach (Polyline *polyline, outlines) {
+            QVector<QVector<QPointF>> holes;  // 内孔
+            foreach (Polyline *hole, holesMap.value(polyline)) {
+                holes.append(hole->getPoints());
+            }
+            sourceList.append(PiecePreprocessor::PieceSource(polyline->getPoints(), holes));
+        }
+        PiecePreprocessor preprocessor;
+        preprocessor.setReferenceLines(rLines);
+        preprocessor.setSimplifyTolerance(config->simplifyTolerance);
+        QProgressDialog progressDialog(tr("切割件预处理..."), QString(), 0, 100, this);
+        progressDialog.setWindowModality(Qt::WindowModal);  // 预处理期间不响应其他操作
+        progressDialog.setMinimumDuration(500);
+        QEventLoop loop;
+        connect(&preprocessor, &PiecePreprocessor::progress, &progressDialog, &QProgressDialog::setValue);
+        connect(&preprocessor, &PiecePreprocessor::finished, &loop, &QEventLoop::quit);
+        preprocessor.start(sourceList);
+        loop.exec();
+        progressDialog.setValue(100);
+        QVector<Piece*> preprocessedList = preprocessor.takePieceList();
+
+        for(int i=0; i<outlines.length(); i++) {
+            Polyline *polyline = outlines[i];
+            Piece *piece = preprocessedList[i];
+            QVector<QLineF> lines = piece->getReferenceLinesList();
+            if(!lines.isEmpty()){
+                polyline->setRLines(lines);
+            }
             proPieceInfo->insertPiece(piece);
             // 添加切割件图层
             Scene *scene = new Scene;
             scene->setName(QString::number(oldLen+count));
             scene->addCustomPolylineItem(polyline);
+            foreach (Polyline *hole, holesMap.value(polyline)) {
+                scene->addCustomPolylineItem(hole);
+            }
             sList.append(scene);
             count++;
         }
@@ -1,6 +1,11 @@
 ﻿#include "nestengine.h"
 #include "nestengineconfigure.h"
+#include "bestnesttypecache.h"
+#include "debug.h"
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <limits>
 
 NestEngine::NestEngine(QObject *parent) :
     QObject(parent),
@@ -20,8 +25,17 @@ NestEngine::NestEngine(QObject *parent) :
     cutStep(0),
     rotatable(false),
     maxRotateAngle(0),
+    angleTolerance(0.01),
+    maxAngleEvaluations(20),
     minHeightOpt(false),
+    partInPart(false),
     collisionCount(0),
+    collisionBackend(SATCollisionBackend),
+    collisionMargin(0),
+    pieceOffset(0),
+    satCollisionTime(0),
+    nfpCollisionTime(0),
+    collisionMismatchCount(0),
     counter(0)
 {
 }
@@ -46,11 +60,21 @@ NestEngine::NestEngine(QObject *parent,
     cutStep(0),
     rotatable(false),
     maxRotateAngle(0),
+    angleTolerance(0.01),
+    maxAngleEvaluations(20),
     minHeightOpt(false),
-    collisionCount(0)
-{
-    this->pieceList = pieceList;
+    partInPart(false),
+    collisionCount(0),
+    collisionBackend(SATCollisionBackend),
+    collisionMargin(0),
+    pieceOffset(0),
+    satCollisionTime(0),
+    nfpCollisionTime(0),
+    collisionMismatchCount(0)
+{
+    this->sourcePieceList = pieceList;
     this->sheetList = sheetList;
+    initPieceOffset();
     // 将零件按由大到小排序
     sortedPieceListByArea(pieceList, transformMap);
     // 初始化每张材料的四叉树
@@ -82,21 +106,33 @@ NestEngine::~NestEngine()
     nestSheetPieceMap.clear();
     pieceMaxPackPointMap.clear();
     quadTreeMap.clear();
+    nestedPieceMap.clear();
+    clearNestedHoles();
 }
 
 void NestEngine::setPieceList(const QVector<Piece> &pieceList)
 {
-    this->pieceList = pieceList;
+    this->sourcePieceList = pieceList;
+    initPieceOffset();
+    nfpCache.clear();  // 零件改变后，临界多边形缓存失效
+    rotatedPieceCache.clear();
+    analysisPieceCache.clear();
+    nestedPieceMap.clear();
 }
 
 QVector<Piece> NestEngine::getPieceList()
 {
-    return pieceList;
+    return sourcePieceList;
 }
 
 void NestEngine::setSheetList(QVector<Sheet> &sheetList)
 {
     this->sheetList = sheetList;
+    initPieceOffset();  // 零件间距可能改变
+    nfpCache.clear();
+    rotatedPieceCache.clear();
+    analysisPieceCache.clear();  // 零件间距改变后，分析用的零件随之改变
+    nestedPieceMap.clear();
 }
 
 QVector<Sheet> NestEngine::getSheetList()
@@ -252,6 +288,26 @@ qreal NestEngine::getMaxRotateAngle()
     return maxRotateAngle;
 }
 
+void NestEngine::setAngleTolerance(qreal tolerance)
+{
+    angleTolerance = tolerance;
+}
+
+qreal NestEngine::getAngleTolerance()
+{
+    return angleTolerance;
+}
+
+void NestEngine::setMaxAngleEvaluations(int count)
+{
+    maxAngleEvaluations = count;
+}
+
+int NestEngine::getMaxAngleEvaluations()
+{
+    return maxAngleEvaluations;
+}
+
 void NestEngine::setMinHeightOpt(bool flag)
 {
     minHeightOpt = flag;
@@ -262,6 +318,27 @@ bool NestEngine::getMinHeightOpt()
     return minHeightOpt;
 }
 
+void NestEngine::setCollisionBackend(NestEngine::CollisionBackend backend)
+{
+    collisionBackend = backend;
+}
+
+NestEngine::CollisionBackend NestEngine::getCollisionBackend()
+{
+    return collisionBackend;
+}
+
+void NestEngine::setPartInPart(bool enabled)
+{
+    partInPart = enabled;
+}
+
+bool NestEngine::isPartInPart() const
+{
+    return partInPart;
+}
+
+
 void NestEngine::sortedPieceListByArea(QVector<Piece> pieceList, QMap<int, QVector<int>> &transformMap)
 {
     // QMap 默认按key值升序排列
@@ -320,6 +397,8 @@ void NestEngine::initQuadTreeMap(int sheetID)
 
 void NestEngine::initNestPieceList()
 {
+    nestedPieceMap.clear();  // 排版零件重新生成，已排零件形状缓存失效
+    clearNestedHoles();  // 内孔随已排零件一起失效
     // 首先将零件按规定方向进行旋转
     for(int i=0; i<pieceList.length(); i++){
         Piece &piece = pieceList[i];
@@ -507,7 +586,7 @@ void NestEngine::initNestEngineConfig(Sheet::SheetType sheetType, NestEngineConf
  * @param width 单排后整体包络矩形的宽度
  * @param height 单排后整体包络矩形的高度
  */
-void NestEngine::singleRowNest(Piece piece, qreal &alpha, qreal &stepX, qreal &width, qreal &height)
+void NestEngine::singleRowNest(const Piece &piece, qreal &alpha, qreal &stepX, qreal &width, qreal &height)
 {
     qreal minArea = LONG_MAX;  // 整体包络矩形的min面积
     qreal pieceWidth = piece.getBoundingRect().width();  // 获取零件外包矩形宽度
@@ -528,7 +607,7 @@ void NestEngine::singleRowNest(Piece piece, qreal &alpha, qreal &stepX, qreal &w
 
         qreal h = piece1.getBoundingRect().height();  // 获取外包矩形的高度
         qreal w = piece1.getBoundingRect().width();  // 获取外包矩形的宽度
-        piece2.compactToOnHD(piece1, compactStep, compactAccuracy);  // 水平靠接
+        piece2.compactToOnHD(piece1);  // 水平靠接
         qreal step = piece2.getPosition().rx()-piece1.getPosition().rx();  // 返回靠接移动距离
         qreal area = h * (w+step);  // 获取整体外包矩形的面积
         if(area < minArea){
@@ -553,7 +632,7 @@ void NestEngine::singleRowNest(Piece piece, qreal &alpha, qreal &stepX, qreal &w
  * @param width  整体外包矩形宽度
  * @param height  整体外包矩形高度
  */
-void NestEngine::doubleRowNest(Piece piece, const int n, qreal &alpha, qreal &stepX, QPointF &cOffset, qreal &width, qreal &height)
+void NestEngine::doubleRowNest(const Piece &piece, const int n, qreal &alpha, qreal &stepX, QPointF &cOffset, qreal &width, qreal &height)
 {
     qreal minArea = LONG_MAX;  // 整体包络矩形的min面积
     qreal pieceWidth = piece.getBoundingRect().width();  // 获取零件外包矩形宽度
@@ -586,8 +665,8 @@ void NestEngine::doubleRowNest(Piece piece, const int n, qreal &alpha, qreal &st
             Piece piece2Copy = piece2;  // 保存零件2的状态
             Piece piece3Copy = piece3;  // 保存零件3的状态
             piece2Copy.moveTo(pos2+QPointF(0, v));  // 中间零件下沉
-            piece2Copy.compactToOnHD(piece1, compactStep, compactAccuracy);  // 零件2向左平移，与零件1靠接
-            piece3Copy.compactToOnHD(piece2Copy, compactStep, compactAccuracy);  // 零件3向左平移，与零件1靠接
+            piece2Copy.compactToOnHD(piece1);  // 零件2向左平移，与零件1靠接
+            piece3Copy.compactToOnHD(piece2Copy);  // 零件3向左平移，与零件1靠接
             qreal step = piece3Copy.getPosition().rx()-piece1.getPosition().rx();  // 获取附加偏移
             qreal area = (h+v) * (w+step);  // 获取整体外包矩形的面积
             if(area < minArea){
@@ -612,7 +691,7 @@ void NestEngine::doubleRowNest(Piece piece, const int n, qreal &alpha, qreal &st
  * @param width  整体外包矩形的宽
  * @param height  整体外包矩形的高
  */
-void NestEngine::pairwiseDoubleRowNest(Piece piece, qreal &alpha, QPointF &cOffset, qreal &width, qreal &height)
+void NestEngine::pairwiseDoubleRowNest(const Piece &piece, qreal &alpha, QPointF &cOffset, qreal &width, qreal &height)
 {
     qreal minArea = LONG_MAX;  // 整体包络矩形的min面积
     qreal pieceWidth = piece.getBoundingRect().width();  // 获取零件外包矩形宽度
@@ -633,7 +712,7 @@ void NestEngine::pairwiseDoubleRowNest(Piece piece, qreal &alpha, QPointF &cOffs
         piece2.rotate(pos2, i+180);  // 将影子零件绕中心点旋转
 
         qreal theta = i * M_PI / 180;
-        piece2.compactToOnAlpha(piece1, theta, compactStep, compactAccuracy);  // 零件2沿i方向向零件1靠接
+        piece2.compactToOnAlpha(piece1, theta);  // 零件2沿i方向向零件1靠接
         QPointF offset = piece2.getPosition()-piece1.getPosition();  // 获取附加偏移
 
         // 获取外包矩形的宽高
@@ -673,6 +752,57 @@ qreal NestEngine::calRealBestXStep(const Piece &piece, const qreal alpha, const
     return step;
 }
 
+/**
+ * @brief NestEngine::getAnalysisRotatedPiece
+ * 整数角度的旋转零件放入缓存，角度细化时的非整数角度直接旋转，避免缓存被大量一次性的角度占满。
+ * 分析用的零件由getGapPiece偏移得到，与排放用的零件分开缓存
+ * @param piece 零件
+ * @param alpha 旋转角度
+ * @param typeID 零件类型，小于0时不缓存
+ * @return
+ */
+Piece NestEngine::getAnalysisRotatedPiece(const Piece &piece, qreal alpha, const int typeID)
+{
+    return analysisPieceCache.value(alpha == qRound(alpha) ? typeID : -1, alpha, piece);
+}
+
+/**
+ * @brief NestEngine::optimizeRotateAngle
+ * 旋转角度优化：先按coarseStep粗扫描，再在各局部极小值两侧的粗扫描区间内用Brent法细化，见minimizeRotateAngle。
+ * 角度按0.001°取整，与旋转零件缓存一致；目标值相同时保留先找到的角度
+ * @param objective 目标函数，不满足限制时返回LONG_MAX
+ * @param minRotateAngle 旋转最小角度
+ * @param maxRotateAngle 旋转最大角度
+ * @param alpha 最佳旋转角度
+ * @param coarseStep 粗扫描步长，为1时结果不差于1°遍历
+ * @return 最小目标值，均不满足限制时为LONG_MAX
+ */
+qreal NestEngine::optimizeRotateAngle(const std::function<qreal(qreal)> &objective,
+                                      const int minRotateAngle,
+                                      const int maxRotateAngle,
+                                      qreal &alpha,
+                                      const int coarseStep)
+{
+    int evaluations = 0;  // 求值次数
+    qreal minZ = minimizeRotateAngle(objective, minRotateAngle, maxRotateAngle, coarseStep,
+                                     angleTolerance, maxAngleEvaluations, alpha, evaluations);
+
+#ifdef ROTATEANGLEBENCHMARK
+    qreal sweepMinZ = LONG_MAX;
+    int sweepAlpha = minRotateAngle;
+    for(int i=minRotateAngle; i<=maxRotateAngle; i++){
+        qreal z = objective(i);
+        if(z < sweepMinZ){
+            sweepMinZ = z;
+            sweepAlpha = i;
+        }
+    }
+    qDebug() << "角度优化：" << minZ << "，角度：" << alpha << "，求值次数：" << evaluations
+             << "；1°遍历：" << sweepMinZ << "，角度：" << sweepAlpha << "，求值次数：" << maxRotateAngle - minRotateAngle + 1;
+#endif
+    return minZ;
+}
+
 /**
  * @brief NestEngine::singleRowNestWithVerAlg 使用顶点算法的单排算法
  * @param piece  待排零件
@@ -680,39 +810,44 @@ qreal NestEngine::calRealBestXStep(const Piece &piece, const qreal alpha, const
  * @param step  送料步距
  * @param maxRotateAngle 旋转最大角度
  * @param maxHeight  最大高度限制
+ * @param typeID  零件类型，用于获取旋转零件缓存，小于0时不缓存
+ * @param minRotateAngle 旋转最小角度
  * @return
  */
 qreal NestEngine::singleRowNestWithVerAlg(const Piece &piece, qreal &alpha, qreal &step,
                                           const int maxRotateAngle, const qreal maxWidth,
-                                          const qreal maxHeight)
+                                          const qreal maxHeight,
+                                          const int typeID,
+                                          const int minRotateAngle)
 {
     // 初始化
     alpha = step = 0.0f;
-    qreal minZ = LONG_MAX;  // 目标值，希望其min
-    for(int i=0; i<=maxRotateAngle; i++){  // 遍历180
-        Piece p = piece;  // 复制该零件
-        p.moveTo(QPointF(0, 0));  // 移动至原点，非必须
-        p.rotate(p.getPosition(), i);  // 旋转
+    // 目标值h·d，希望其min
+    auto evaluate = [&](qreal angle, qreal &d) -> qreal {
+        Piece p = getAnalysisRotatedPiece(piece, angle, typeID);  // 复制该零件，移动至原点后旋转，同类零件的同一角度只旋转一次
         qreal w = p.getBoundingRect().width();  // 获取旋转之后的宽度
         qreal h = p.getBoundingRect().height();  // 获取旋转之后的高度
-        if(w > maxWidth || h > maxHeight){  // 如果旋转高度大于材料高度，直接进行下次循环
-            continue;
+        if(w > maxWidth || h > maxHeight){  // 如果旋转高度大于材料高度，不可行
+            return LONG_MAX;
         }
         QVector<QPointF> points = p.getPointsList();
-        qreal d = calVerToOppSideXDis(points);  // 直接计算步距
-        qreal hd = h * d;
-        if(hd < minZ){  // 寻找min值，并记录min值时各变量的值
-            minZ = hd;
-            alpha = i;
-            step = d;
-        }
-    }
+        d = calVerToOppSideXDis(points);  // 直接计算步距
+        return h * d;
+    };
+    qreal d = 0;
+    // 单排的目标值求值代价小，保留1°遍历作为粗扫描，细化结果不差于原1°遍历
+    qreal minZ = optimizeRotateAngle([&](qreal angle){ return evaluate(angle, d); },
+                                     minRotateAngle, maxRotateAngle, alpha, 1);
     // 如果目标值仍为LONG_MAX,直接返回0.0f
     if(minZ == LONG_MAX){
+        alpha = 0.0f;
         return 0.0f;
     }
+    evaluate(alpha, step);
     qreal rate = piece.getArea() / minZ;
+#ifdef BESTNESTTYPEDEBUG
     qDebug() << "minZ: " << minZ << ", alpha: " << alpha << ", step: " << step << ", rate: " << rate;
+#endif
     return rate;
 }
 
@@ -726,6 +861,8 @@ qreal NestEngine::singleRowNestWithVerAlg(const Piece &piece, qreal &alpha, qrea
  * @param n  错开量精度，默认为100
  * @param maxRotateAngle 旋转最大角度
  * @param maxHeight  最大高度限制
+ * @param typeID  零件类型，小于0时不缓存
+ * @param minRotateAngle 旋转最小角度，为10的倍数
  * @return
  */
 qreal NestEngine::doubleRowNestWithVerAlg(const Piece &piece,
@@ -736,34 +873,34 @@ qreal NestEngine::doubleRowNestWithVerAlg(const Piece &piece,
                                           const qreal n,
                                           const int maxRotateAngle,
                                           const qreal maxWidth,
-                                          const qreal maxHeight)
+                                          const qreal maxHeight,
+                                          const int typeID,
+                                          const int minRotateAngle)
 {
     // 初始化
     alpha = step = X = H = 0.0f;
-    qreal minZ = LONG_MAX;  // 目标值，希望其min
-    for(int i=0; i<=maxRotateAngle; i+=10){
-        qDebug() << "i = " << i;
-        Piece p = piece;  // 复制，零件1
-        p.moveTo(QPointF(0, 0));  // 移动至原点，非必须
-        p.rotate(p.getPosition(), i);  // 旋转
+    // 目标值为各错开量下h·d的最小值，希望其min
+    auto evaluate = [&](qreal angle, qreal &bestStep, qreal &bestX, qreal &bestH) -> qreal {
+        qreal minHD = LONG_MAX;
+        Piece p = getAnalysisRotatedPiece(piece, angle, typeID);  // 复制，零件1，移动至原点后旋转，同类零件的同一角度只旋转一次
 
         QVector<QPointF> points = p.getPointsList();  // 获取旋转之后的点集
         qreal pieceWidth = p.getBoundingRect().width();  // 切割件高度
         qreal pieceHeight = p.getBoundingRect().height();  // 切割件高度
-        if(pieceWidth > maxWidth || pieceHeight > maxHeight){// 如果零件高度大于材料高度，直接进行下次循环
-            continue;
+        if(pieceWidth > maxWidth || pieceHeight > maxHeight){// 如果零件高度大于材料高度，不可行
+            return minHD;
         }
+        // 与错开量无关，循环外只计算一次
+        qreal d1 = calVerToOppSideXDis(points);  // 计算各顶点到对边距离的最大值
+        qreal offset = pieceWidth;  // 将零件移动至外包矩形相切处
         for(qreal delta=0; delta<pieceHeight; delta+=pieceHeight/n){
 
-            qDebug() << "delta = " << delta;
+            //qDebug() << "delta = " << delta;
             qreal h = pieceHeight + qAbs(delta);  // 获取旋转之后的高度，注意要加上错开量
             if(h>maxHeight){  // 如果旋转高度大于材料高度，直接进行下次循环
                 continue;
             }
-            // 计算步距
-            qreal d1 = calVerToOppSideXDis(points);  // 计算各顶点到对边距离的最大值
             // 计算各顶点到错开零件各边最大值与min值的差
-            qreal offset = p.getBoundingRect().width();  // 将零件移动至外包矩形相切处
             qreal moveLeft;
             qreal d2 = calVerToCrossMaxMinDiff(points, offset, delta, moveLeft);
             if(d2 < 0){  // 如果差值小于0，则代表无交点
@@ -780,21 +917,28 @@ qreal NestEngine::doubleRowNestWithVerAlg(const Piece &piece,
                 continue;
             }
             qreal hd = h * d;
-            if(hd < minZ){  // 寻找min值，并记录min值时各变量的值
-                minZ = hd;
-                alpha = i;
-                step = d;
-                X = offset - moveLeft;
-                H = delta;
+            if(hd < minHD){  // 寻找min值，并记录min值时各变量的值
+                minHD = hd;
+                bestStep = d;
+                bestX = offset - moveLeft;
+                bestH = delta;
             }
         }
-    }
+        return minHD;
+    };
+    qreal s = 0, x = 0, dh = 0;
+    qreal minZ = optimizeRotateAngle([&](qreal angle){ return evaluate(angle, s, x, dh); },
+                                     minRotateAngle, maxRotateAngle, alpha);
     // 如果目标值仍为LONG_MAX,直接返回0.0f
     if(minZ == LONG_MAX){
+        alpha = 0.0f;
         return 0.0f;
     }
+    evaluate(alpha, step, X, H);
     qreal rate = 2 * piece.getArea() / minZ;
+#ifdef BESTNESTTYPEDEBUG
     qDebug() << "minZ: " << minZ << ", alpha: " << alpha << ", step: " << step << "X: " << X << ", H: " << H << ", rate: " << rate;
+#endif
     return rate;
 }
 
@@ -806,6 +950,8 @@ qreal NestEngine::doubleRowNestWithVerAlg(const Piece &piece,
  * @param offset  旋转中心较零件位置的偏移量
  * @param maxRotateAngle 旋转最大角度
  * @param maxHeight  最大高度限制
+ * @param typeID  零件类型，小于0时不缓存
+ * @param minRotateAngle 旋转最小角度，为10的倍数
  * @return
  */
 qreal NestEngine::oppositeSingleRowNestWithVerAlg(const Piece &piece,
@@ -814,50 +960,54 @@ qreal NestEngine::oppositeSingleRowNestWithVerAlg(const Piece &piece,
                                                   QPointF &offset,
                                                   const int maxRotateAngle,
                                                   const qreal maxWidth,
-                                                  const qreal maxHeight)
+                                                  const qreal maxHeight,
+                                                  const int typeID,
+                                                  const int minRotateAngle)
 {
     // 初始化
     alpha = step = 0.0f;
     offset = QPointF(0, 0);
-    qreal minZ = LONG_MAX;  // 目标值，希望其min
-    for(int i=0; i<=maxRotateAngle; i+=10){
-        Piece p = piece;  // 复制，零件1
-        p.moveTo(QPointF(0, 0));  // 移动至原点，非必须
-        p.rotate(p.getPosition(), i);  // 旋转
+    // 目标值h·d，希望其min
+    auto evaluate = [&](qreal angle, qreal &bestStep, QPointF &bestOffset) -> qreal {
+        Piece p = getAnalysisRotatedPiece(piece, angle, typeID);  // 复制，零件1，移动至原点后旋转，同类零件的同一角度只旋转一次
         qreal w = p.getBoundingRect().width();  // 获取旋转之后的宽度
         qreal h = p.getBoundingRect().height();  // 获取旋转之后的高度
-        if(w > maxWidth || h > maxHeight){  // 如果旋转高度大于材料高度，直接进行下次循环
-            continue;
+        if(w > maxWidth || h > maxHeight){  // 如果旋转高度大于材料高度，不可行
+            return LONG_MAX;
         }
         // 直接计算步距
         QVector<QPointF> points = p.getPointsList();
         qreal d = calVerToLeftXDis(points);  // 计算各顶点到外包矩形最左侧的距离与关于(yMin+yMax)/2对称位置水平距离之和的最大值
-        qreal hd = h * d;
-        if(hd < minZ){  // 寻找min值，并记录min值时各变量的值
-            // 计算旋转中心点
-            qreal xMin = p.getBoundingRect().left();  // xMin
-            qreal yMin = p.getBoundingRect().bottom();  // yMin
-            qreal yMax = p.getBoundingRect().top();  // yMax
-            minZ = hd;
-            alpha = i;
-            step = d;  // 最佳送料步距其实不是这个d
-            QPointF rotateCenter;  // 旋转中心
-            rotateCenter.setX(xMin + d / 2);
-            rotateCenter.setY((yMin + yMax) / 2);
-            offset = rotateCenter - p.getPosition();  // 相较与位置点的偏移
-            offset = pointPrecision(offset, PRECISION);  // 保留精度
-        }
-    }
+        // 计算旋转中心点
+        qreal xMin = p.getBoundingRect().left();  // xMin
+        qreal yMin = p.getBoundingRect().bottom();  // yMin
+        qreal yMax = p.getBoundingRect().top();  // yMax
+        bestStep = d;  // 最佳送料步距其实不是这个d
+        QPointF rotateCenter;  // 旋转中心
+        rotateCenter.setX(xMin + d / 2);
+        rotateCenter.setY((yMin + yMax) / 2);
+        bestOffset = rotateCenter - p.getPosition();  // 相较与位置点的偏移
+        bestOffset = pointPrecision(bestOffset, PRECISION);  // 保留精度
+        return h * d;
+    };
+    qreal s = 0;
+    QPointF o;
+    qreal minZ = optimizeRotateAngle([&](qreal angle){ return evaluate(angle, s, o); },
+                                     minRotateAngle, maxRotateAngle, alpha);
 
     // 如果目标值仍为LONG_MAX,直接返回0.0f
     if(minZ == LONG_MAX){
+        alpha = 0.0f;
         return 0.0f;
     }
+    evaluate(alpha, step, offset);
     // 计算最佳送料步距
     step = calRealBestXStep(piece, alpha, offset);
     // 计算利用率
     qreal rate = 2 * piece.getArea() / minZ;
+#ifdef BESTNESTTYPEDEBUG
     qDebug() << "minZ: " << minZ << ", alpha: " << alpha << ", step: " << step << ", center: " << offset << ", rate: " << rate;
+#endif
     return rate;
 }
 
@@ -871,6 +1021,8 @@ qreal NestEngine::oppositeSingleRowNestWithVerAlg(const Piece &piece,
  * @param n  错开量精度，默认为100
  * @param maxRotateAngle 旋转最大角度
  * @param maxHeight  最大高度限制
+ * @param typeID  零件类型，小于0时不缓存
+ * @param minRotateAngle 旋转最小角度，为10的倍数
  * @return
  */
 qreal NestEngine::oppositeDoubleRowNestWithVerAlg(const Piece &piece,
@@ -881,56 +1033,66 @@ qreal NestEngine::oppositeDoubleRowNestWithVerAlg(const Piece &piece,
                                                   const qreal n,
                                                   int maxRotateAngle,
                                                   const qreal maxWidth,
-                                                  const qreal maxHeight)
+                                                  const qreal maxHeight,
+                                                  const int typeID,
+                                                  const int minRotateAngle)
 {
     // 初始化
     alpha = step = H = 0.0f;
     offset = QPointF(0, 0);
-    qreal minZ = LONG_MAX;  // 目标值，希望其min
-    for(int i=0; i<=maxRotateAngle; i+=10){
-        Piece p = piece;  // 复制，零件1
-        p.moveTo(QPointF(0, 0));  // 移动至原点，非必须
-        p.rotate(p.getPosition(), i);  // 旋转
-        qreal pieceWidth = p.getBoundingRect().width();  // 切割件宽度
-        qreal pieceHeight = p.getBoundingRect().height();  // 切割件高度
-        if(pieceWidth > maxWidth || pieceHeight > maxHeight){// 如果零件高度大于材料高度，直接进行下次循环
-            continue;
+    // 目标值为各错开量下h·d的最小值，希望其min
+    auto evaluate = [&](qreal angle, qreal &bestStep, QPointF &bestOffset, qreal &bestH) -> qreal {
+        qreal minHD = LONG_MAX;
+        Piece p = getAnalysisRotatedPiece(piece, angle, typeID);  // 复制，零件1，移动至原点后旋转，同类零件的同一角度只旋转一次
+        QRectF boundingRect = p.getBoundingRect();  // 旋转之后的外包矩形
+        qreal pieceWidth = boundingRect.width();  // 切割件宽度
+        qreal pieceHeight = boundingRect.height();  // 切割件高度
+        if(pieceWidth > maxWidth || pieceHeight > maxHeight){// 如果零件高度大于材料高度，不可行
+            return minHD;
         }
+        QVector<QPointF> points = p.getPointsList();  // 获取旋转之后的点集
+        qreal xMin = boundingRect.left();  // xMin
+        qreal yMin = boundingRect.bottom();  // yMin
+        qreal yMax = boundingRect.top();  // yMax
         for(qreal delta=0; delta<pieceHeight; delta+=pieceHeight/n){
             qreal h = pieceHeight + delta;  // 获取旋转之后的高度，注意要加上错开量
             if(h>maxHeight){  // 如果旋转高度大于材料高度，直接进行下次循环
                 continue;
             }
             // 直接计算步距
-            QVector<QPointF> points = p.getPointsList();
             qreal d = calVerToLeftXDis(points, delta);  // 计算步距
             qreal hd = h * d;
-            if(hd < minZ){  // 寻找min值，并记录min值时各变量的值
+            if(hd < minHD){  // 寻找min值，并记录min值时各变量的值
                 // 计算旋转中心点
-                qreal xMin = p.getBoundingRect().left();  // xMin
-                qreal yMin = p.getBoundingRect().bottom();  // yMin
-                qreal yMax = p.getBoundingRect().top();  // yMax
-                minZ = hd;
-                alpha = i;
-                step = d;  // 最佳送料步距其实不是这个d
-                H = delta;
+                minHD = hd;
+                bestStep = d;  // 最佳送料步距其实不是这个d
+                bestH = delta;
                 QPointF rotateCenter;  // 旋转中心
                 rotateCenter.setX(xMin + d / 2);
-                rotateCenter.setY((yMin + yMax + H) / 2);
-                offset = rotateCenter - p.getPosition();  // 相较与位置点的偏移
-                offset = pointPrecision(offset, PRECISION);  // 保留精度
+                rotateCenter.setY((yMin + yMax + bestH) / 2);
+                bestOffset = rotateCenter - p.getPosition();  // 相较与位置点的偏移
+                bestOffset = pointPrecision(bestOffset, PRECISION);  // 保留精度
             }
         }
-    }
+        return minHD;
+    };
+    qreal s = 0, dh = 0;
+    QPointF o;
+    qreal minZ = optimizeRotateAngle([&](qreal angle){ return evaluate(angle, s, o, dh); },
+                                     minRotateAngle, maxRotateAngle, alpha);
 
     if(minZ == LONG_MAX){
+        alpha = 0.0f;
         return 0.0f;
     }
+    evaluate(alpha, step, offset, H);
     // 计算最佳送料步距
     step = calRealBestXStep(piece, alpha, offset);
     // 计算利用率
     qreal rate = 2 * piece.getArea() / minZ;
+#ifdef BESTNESTTYPEDEBUG
     qDebug() << "minZ: " << minZ << ", alpha: " << alpha << ", step: " << step << "H: " << H << ", offset: " << offset << ", rate: " << rate;
+#endif
     return rate;
 }
 
@@ -944,6 +1106,7 @@ qreal NestEngine::oppositeDoubleRowNestWithVerAlg(const Piece &piece,
  * @param yStep  y方向送料步距
  * @param maxRotateAngle 旋转最大角度
  * @param maxHeight  最大高度限制
+ * @param typeID  零件类型，小于0时不缓存
  * @return
  */
 NestEngine::NestType NestEngine::getPieceBestNestType(const Piece &piece,
@@ -953,80 +1116,246 @@ NestEngine::NestType NestEngine::getPieceBestNestType(const Piece &piece,
                                                       QPointF &rCOffset,
                                                       const int maxRotateAngle,
                                                       const qreal maxWidth,
-                                                      const qreal maxHeight)
+                                                      const qreal maxHeight,
+                                                      const int typeID)
 {
-    NestType type = NoNestType;  // 最佳排版方式
-    qreal rateMax = 0;  // 最佳利用率
-    qreal a, s, x, h;
-    QPointF o;
+    QVector<BestNestTypeTask> taskList = createBestNestTypeTasks(piece, maxRotateAngle, maxWidth, maxHeight, typeID);
+    QtConcurrent::blockingMap(taskList, [this](BestNestTypeTask &task){
+        runBestNestTypeTask(task);
+    });
+    return mergeBestNestTypeTasks(piece, taskList.constData(), taskList.length(), alpha, xStep, pOffset, rCOffset);
+}
 
-#if 0
-    qreal rate1 = singleRowNestWithVerAlg(piece, a, s, maxRotateAngle, maxWidth, maxHeight);  // 普通单排方式
-    if(rate1 > rateMax){
-        rateMax = rate1;
-        alpha = a;
-        xStep = s;
-        pOffset = QPointF(xStep, 0);
-        type = NestType::SingleRow;
-    }
+/**
+ * @brief NestEngine::getAllBestNestTypes
+ * 所有零件类型的分析任务一起放入线程池，按零件类型依次合并，结果与逐个零件串行计算一致。
+ * 先查找磁盘缓存，几何与约束相同的零件类型只分析一次，分析结果写回缓存
+ * @param pieceList 零件列表
+ */
+void NestEngine::getAllBestNestTypes(QVector<Piece> pieceList)
+{
+#ifdef BESTNESTTYPEDEBUG
+    QElapsedTimer timer;
+    timer.start();
 #endif
+    BestNestTypeCache cache;  // 最佳排版方式磁盘缓存
+    cache.load();
+    QVector<QString> keyList;  // 各零件类型的缓存键
+    QMap<QString, int> firstTypeMap;  // 键-第一个使用该键的零件类型
+    QVector<BestNestTypeTask> taskList;  // 所有分析任务
+    QVector<int> taskBeginList;  // 各零件类型第一个任务的序号
+    int hitCount = 0;  // 缓存命中个数
+    for(int i=0; i<pieceList.length(); i++) {
+        pieceList[i] = getGapPiece(pieceList[i]);  // 送料步距与组合偏移量需包含零件间距
+        pieceList[i].updateGeometry();  // 交给各线程共享之前应用平移量，任务中读取时不再复制几何数据
+        taskBeginList.append(taskList.length());
+        QVector<BestNestTypeTask> pieceTaskList = createBestNestTypeTasks(pieceList[i], maxRotateAngle, LONG_MAX, LONG_MAX, i);
+        QString key = BestNestTypeCache::key(pieceList[i], pieceTaskList, angleTolerance, maxAngleEvaluations);
+        keyList.append(key);
+        BestNestType bestNestType;
+        if(cache.value(key, bestNestType)){
+            hitCount++;
+            continue;
+        }
+        if(firstTypeMap.contains(key)){  // 与之前的零件类型相同，直接使用其结果
+            continue;
+        }
+        firstTypeMap.insert(key, i);
+        taskList += pieceTaskList;
+    }
+    taskBeginList.append(taskList.length());
+    QtConcurrent::blockingMap(taskList, [this](BestNestTypeTask &task){
+        runBestNestTypeTask(task);
+    });
 
-#if 1
-    qreal rate2 = doubleRowNestWithVerAlg(piece, a, s, x, h, 100, maxRotateAngle, maxWidth, maxHeight);  // 普通双排方式
-    if(rate2 > rateMax){
-        rateMax = rate2;
-        alpha = a;
-        xStep = s;
-        pOffset = QPointF(x, h);
-        type = h == 0 ? NestType::SingleRow : NestType::DoubleRow;
+    // 按照零件类型确定最佳排版方式
+    for(int i=0; i<pieceList.length(); i++) {
+        BestNestType bestNestType;
+        if(!cache.value(keyList[i], bestNestType)){
+            qreal alpha = 0, xStep = 0;
+            QPointF pOffset, rCOffset;
+            NestType type = mergeBestNestTypeTasks(pieceList[i], taskList.constData() + taskBeginList[i],
+                                                   taskBeginList[i+1] - taskBeginList[i],
+                                                   alpha, xStep, pOffset, rCOffset);
+            bestNestType = BestNestType(i, type, alpha, xStep, pOffset, rCOffset);
+            cache.insert(keyList[i], bestNestType);
+        }
+        // 缓存的偏移量与位置无关，组合外包矩形中心按本零件的位置计算
+        bestNestType.pieceID = i;
+        bestNestType.rCOffset = calRCOffset(pieceList[i], bestNestType.pOffset);
+        qDebug() << "#" << i << ", bestNestType: " << bestNestType.nestType;
+
+        // 保存每个零件的最佳排版信息
+        pieceBestNestTypeMap[i] = bestNestType;
+    }
+    if(cache.isModified()){
+        cache.save();
     }
-#endif
 
-#if 0
-    qreal rate3 = oppositeSingleRowNestWithVerAlg(piece, a, s, o, maxRotateAngle, maxWidth, maxHeight); // 对头单排方式
-    if(rate3 > rateMax){
-        rateMax = rate3;
-        alpha = a;
-        xStep = s;
-        QPointF pos2 = pointPrecision(transformRotate(piece.getPosition()+o, piece.getPosition(), 180), PRECISION);
-        pOffset = pointPrecision(pos2-piece.getPosition(), PRECISION);
-        type = NestType::OppositeSingleRow;
+#ifdef BESTNESTTYPEDEBUG
+    // 串行用时为各任务用时之和
+    qint64 wallTime = qMax(timer.nsecsElapsed(), qint64(1));
+    qint64 taskTime = 0;
+    for(int i=0; i<taskList.length(); i++){
+        taskTime += taskList[i].nsecs;
     }
+    qDebug() << "最佳排版方式分析：缓存命中" << hitCount << "/" << pieceList.length()
+             << "，任务数" << taskList.length()
+             << "，用时(ms)：" << wallTime / 1000000.0
+             << "，任务用时之和(ms)：" << taskTime / 1000000.0
+             << "，加速比：" << qreal(taskTime) / wallTime;
 #endif
+}
 
+/**
+ * @brief NestEngine::createBestNestTypeTasks
+ * 按排版策略与角度区间划分任务，任务顺序即串行计算时比较的顺序
+ * @param piece  待排零件，任务执行完之前不能释放
+ * @param maxRotateAngle 旋转最大角度
+ * @param maxWidth  最大宽度限制
+ * @param maxHeight  最大高度限制
+ * @param typeID  零件类型，小于0时不缓存
+ * @return
+ */
+QVector<NestEngine::BestNestTypeTask> NestEngine::createBestNestTypeTasks(const Piece &piece,
+                                                                          const int maxRotateAngle,
+                                                                          const qreal maxWidth,
+                                                                          const qreal maxHeight,
+                                                                          const int typeID)
+{
+    const int angleRange = 30;  // 每个任务的角度区间，为10的倍数，与各算法的角度步长对齐
+    QVector<NestType> strategyList;  // 参与比较的排版策略
+#if 0
+    strategyList.append(NestType::SingleRow);  // 普通单排方式
+#endif
 #if 1
-    qreal rate4 = oppositeDoubleRowNestWithVerAlg(piece, a, s, o, h, 100, maxRotateAngle, maxWidth, maxHeight);  // 对头双排方式
-    if(rate4 > rateMax){
-        rateMax = rate4;
-        alpha = a;
-        xStep = s;
-        QPointF pos2 = pointPrecision(transformRotate(piece.getPosition()+o, piece.getPosition(), 180), PRECISION);
-        pOffset = pointPrecision(pos2-piece.getPosition(), PRECISION);
-        type = h == 0 ? NestType::OppositeSingleRow : NestType::OppositeDoubleRow;
-    }
+    strategyList.append(NestType::DoubleRow);  // 普通双排方式
+#endif
+#if 0
+    strategyList.append(NestType::OppositeSingleRow);  // 对头单排方式
+#endif
+#if 1
+    strategyList.append(NestType::OppositeDoubleRow);  // 对头双排方式
 #endif
 
-    rCOffset = QPointF((2*piece.getPosition().rx()+pOffset.rx())/2, (2*piece.getPosition().ry()+pOffset.ry())/2);
-    return type;
+    QVector<BestNestTypeTask> taskList;
+    foreach (NestType strategy, strategyList) {
+        // 相邻任务的角度区间首尾相接，区间内的角度细化不会漏掉任务边界之间的角度
+        for(int minAngle=0; ; minAngle+=angleRange){
+            int maxAngle = qMin(minAngle + angleRange, maxRotateAngle);
+            taskList.append(BestNestTypeTask(&piece, typeID, strategy, minAngle, maxAngle, maxWidth, maxHeight));
+            if(maxAngle >= maxRotateAngle){
+                break;
+            }
+        }
+    }
+    return taskList;
 }
 
-void NestEngine::getAllBestNestTypes(QVector<Piece> pieceList)
-{
-    // 按照零件类型确定最佳排版方式
-    for(int i=0; i<pieceList.length(); i++) {
-        Piece piece = pieceList[i];
-        qreal alpha, xStep;
-        QPointF pOffset, rCOffset;
-        NestType type = getPieceBestNestType(piece, alpha, xStep, pOffset, rCOffset, maxRotateAngle);
-        qDebug() << "#" << i << ", bestNestType: " << (NestType)type;
+/**
+ * @brief NestEngine::runBestNestTypeTask
+ * 在角度区间内执行一种排版策略，只读取零件与线程安全的旋转零件缓存
+ * @param task 分析任务，结果写回任务
+ */
+void NestEngine::runBestNestTypeTask(NestEngine::BestNestTypeTask &task)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const Piece &piece = *task.piece;
+    switch (task.strategy) {
+    case NestType::SingleRow:
+        task.rate = singleRowNestWithVerAlg(piece, task.alpha, task.step, task.maxAngle,
+                                            task.maxWidth, task.maxHeight, task.typeID, task.minAngle);
+        break;
+    case NestType::DoubleRow:
+        task.rate = doubleRowNestWithVerAlg(piece, task.alpha, task.step, task.X, task.H, 100, task.maxAngle,
+                                            task.maxWidth, task.maxHeight, task.typeID, task.minAngle);
+        break;
+    case NestType::OppositeSingleRow:
+        task.rate = oppositeSingleRowNestWithVerAlg(piece, task.alpha, task.step, task.offset, task.maxAngle,
+                                                    task.maxWidth, task.maxHeight, task.typeID, task.minAngle);
+        break;
+    case NestType::OppositeDoubleRow:
+        task.rate = oppositeDoubleRowNestWithVerAlg(piece, task.alpha, task.step, task.offset, task.H, 100, task.maxAngle,
+                                                    task.maxWidth, task.maxHeight, task.typeID, task.minAngle);
+        break;
+    default:
+        task.rate = 0;
+        break;
+    }
+    task.nsecs = timer.nsecsElapsed();
+}
 
-        // 保存每个零件的最佳排版信息
-        if(!pieceBestNestTypeMap.contains(i)){
-            pieceBestNestTypeMap.insert(i, BestNestType());
+/**
+ * @brief NestEngine::mergeBestNestTypeTasks
+ * 按任务顺序取利用率最大者，利用率相同时保留靠前的任务，
+ * 与各策略内按角度递增、策略间按顺序比较的串行结果一致
+ * @param piece  待排零件
+ * @param taskList  该零件的分析任务
+ * @param taskCount  任务个数
+ * @param alpha  旋转角度
+ * @param xStep  x方向送料步距
+ * @param pOffset 影子零件较基准零件位置的偏移量
+ * @param rCOffset 外包矩形中心较基准零件位置的偏移量
+ * @return
+ */
+NestEngine::NestType NestEngine::mergeBestNestTypeTasks(const Piece &piece,
+                                                        const BestNestTypeTask *taskList,
+                                                        int taskCount,
+                                                        qreal &alpha,
+                                                        qreal &xStep,
+                                                        QPointF &pOffset,
+                                                        QPointF &rCOffset)
+{
+    NestType type = NoNestType;  // 最佳排版方式
+    qreal rateMax = 0;  // 最佳利用率
+    for(int i=0; i<taskCount; i++){
+        const BestNestTypeTask &task = taskList[i];
+        if(task.rate <= rateMax){
+            continue;
+        }
+        rateMax = task.rate;
+        alpha = task.alpha;
+        xStep = task.step;
+        switch (task.strategy) {
+        case NestType::SingleRow:
+            pOffset = QPointF(xStep, 0);
+            type = NestType::SingleRow;
+            break;
+        case NestType::DoubleRow:
+            pOffset = QPointF(task.X, task.H);
+            type = task.H == 0 ? NestType::SingleRow : NestType::DoubleRow;
+            break;
+        case NestType::OppositeSingleRow:
+        case NestType::OppositeDoubleRow:{
+            QPointF pos2 = pointPrecision(transformRotate(piece.getPosition()+task.offset, piece.getPosition(), 180), PRECISION);
+            pOffset = pointPrecision(pos2-piece.getPosition(), PRECISION);
+            if(task.strategy == NestType::OppositeSingleRow){
+                type = NestType::OppositeSingleRow;
+            } else{
+                type = task.H == 0 ? NestType::OppositeSingleRow : NestType::OppositeDoubleRow;
+            }
+            break;
+        }
+        default:
+            break;
         }
-        BestNestType bestNestType(i, type, alpha, xStep, pOffset, rCOffset);
-        pieceBestNestTypeMap[i] = bestNestType;
     }
+
+    rCOffset = calRCOffset(piece, pOffset);
+    return type;
+}
+
+/**
+ * @brief NestEngine::calRCOffset
+ * 基准零件与影子零件组合外包矩形的中心
+ * @param piece  基准零件
+ * @param pOffset  影子零件较基准零件位置的偏移量
+ * @return
+ */
+QPointF NestEngine::calRCOffset(const Piece &piece, const QPointF &pOffset)
+{
+    return QPointF((2*piece.getPosition().x()+pOffset.x())/2, (2*piece.getPosition().y()+pOffset.y())/2);
 }
 
 /**
@@ -1071,7 +1400,7 @@ qreal NestEngine::oppositeDoubleRowNestWithVerAlgForStrip(const QRectF &layoutRe
     p2.moveTo(p2.getPosition() + offset2 + QPointF(p1.getBoundingRect().width(), 0));
 
     // 进行水平靠接
-    p2.compactToOnHD(p1, compactStep, compactAccuracy);
+    p2.compactToOnHD(p1);
     pos2 = p2.getPosition();
 
     // 计算步距
@@ -1126,14 +1455,14 @@ void NestEngine::packPieces(QVector<int> indexList)
     Q_UNUSED(indexList);
 }
 
-bool NestEngine::packOnePiece(Piece piece, NestEngine::NestPiece &nestPiece)
+bool NestEngine::packOnePiece(const Piece &piece, NestEngine::NestPiece &nestPiece)
 {
     Q_UNUSED(piece);
     Q_UNUSED(nestPiece);
     return true;
 }
 
-bool NestEngine::packOnePieceOnSheet(Piece piece, int sheetID, NestEngine::NestPiece &nestPiece)
+bool NestEngine::packOnePieceOnSheet(const Piece &piece, int sheetID, NestEngine::NestPiece &nestPiece)
 {
     Q_UNUSED(piece);
     Q_UNUSED(sheetID);
@@ -1148,21 +1477,591 @@ bool NestEngine::compact(int sheetID, NestEngine::NestPiece &nestPiece)
     return true;
 }
 
-bool NestEngine::collidesWithOtherPieces(int sheetID, Piece piece)
+bool NestEngine::collidesWithOtherPieces(int sheetID, const Piece &piece)
 {
     Q_UNUSED(piece);
     Q_UNUSED(sheetID);
     return true;
 }
 
+/**
+ * @brief NestEngine::getNoFitPolygon
+ * 获取两零件的临界多边形，未缓存时计算并缓存。
+ * 两零件均通过placeNestedPiece变换至位置为原点的排放姿态，
+ * 与已排零件的变换方式一致，参考点即排版零件的position
+ * @param fixedTypeID 固定零件类型
+ * @param fixedAlpha 固定零件旋转角度
+ * @param movingTypeID 移动零件类型
+ * @param movingAlpha 移动零件旋转角度
+ * @return
+ */
+NoFitPolygon NestEngine::getNoFitPolygon(int fixedTypeID, qreal fixedAlpha, int movingTypeID, qreal movingAlpha)
+{
+    NoFitPolygonCache::Key key(fixedTypeID, fixedAlpha, movingTypeID, movingAlpha);
+    if(nfpCache.contains(key)){
+        return nfpCache.value(key);
+    }
+
+    NestPiece fixedNestPiece(-1, fixedTypeID, fixedAlpha);
+    fixedNestPiece.position = QPointF(0, 0);
+    NestPiece movingNestPiece(-1, movingTypeID, movingAlpha);
+    movingNestPiece.position = QPointF(0, 0);
+    Piece fixedPiece = pieceList[fixedTypeID];
+    Piece movingPiece = pieceList[movingTypeID];
+    placeNestedPiece(fixedPiece, fixedNestPiece);
+    placeNestedPiece(movingPiece, movingNestPiece);
+    NoFitPolygon nfp(fixedPiece.getConvexPartsList(),
+                     movingPiece.getConvexPartsList(),
+                     movingPiece.getPrecision());
+    return nfpCache.insert(key, nfp);
+}
+
+/**
+ * @brief NestEngine::collidesWithOtherPiecesByNFP
+ * 移动零件参考点相对于已排零件参考点的位置落在临界多边形内部，即为重叠。
+ * 临界多边形按实心外轮廓计算，两零件之一有内孔时按形状检测
+ * @param sheetID 材料ID
+ * @param typeID 零件类型
+ * @param alpha 零件旋转角度
+ * @param position 零件的排放位置，与排版零件的position含义相同
+ * @param piece 已移动、旋转至排放位置的零件
+ * @return
+ */
+bool NestEngine::collidesWithOtherPiecesByNFP(int sheetID, int typeID, qreal alpha, const QPointF &position, const Piece &piece)
+{
+    qreal margin = piece.getCollisionMargin() + collisionMargin;  // 简化外轮廓可能超出外包矩形
+    Object obj(piece.getBoundingRect().adjusted(-margin, -margin, margin, margin));
+    std::list<Object *> resObjects = quadTreeMap[sheetID]->retrieve(&obj);
+    for(auto &t:resObjects){
+        const NestPiece &nestPiece = nestPieceList[t->id];
+        if(piece.hasHoles() || pieceList[nestPiece.typeID].hasHoles()){
+            if(piece.collidesWithPiece(getNestedPiece(t->id))){
+                return true;
+            }
+            collisionCount++;
+            continue;
+        }
+        NoFitPolygon nfp = getNoFitPolygon(nestPiece.typeID, nestPiece.alpha, typeID, alpha);
+        if(nfp.contains(position - nestPiece.position)){
+            return true;
+        }
+        collisionCount++;
+    }
+    return false;
+}
+
+/**
+ * @brief NestEngine::isNFPCollisionSupported
+ * 参考线排版时零件按参考线移动、旋转，与placeNestedPiece的方式不同，只能使用分离轴检测
+ * @return
+ */
+bool NestEngine::isNFPCollisionSupported() const
+{
+    return nestEngineStrategys != ReferenceLine;
+}
+
+/**
+ * @brief NestEngine::collidesWithNestedPieces
+ * 根据碰撞检测方式进行检测，当前排版方式不支持时使用分离轴检测；
+ * 零件已按间距偏移时临界多边形包含间距，只有剩余间距大于0时才使用分离轴检测
+ * @param sheetID 材料ID
+ * @param piece 已移动、旋转至排放位置的零件
+ * @param typeID 零件类型
+ * @param alpha 零件旋转角度
+ * @param position 零件的排放位置，与排版零件的position含义相同
+ * @return
+ */
+bool NestEngine::collidesWithNestedPieces(int sheetID, const Piece &piece, int typeID, qreal alpha, const QPointF &position)
+{
+    if(collisionBackend != NFPCollisionBackend || !isNFPCollisionSupported()
+            || getComponentGap(sheetID) > 0){
+        return collidesWithOtherPieces(sheetID, piece);
+    }
+#ifdef NFPBENCHMARK
+    QElapsedTimer timer;
+    timer.start();
+    bool satRet = collidesWithOtherPieces(sheetID, piece);
+    satCollisionTime += timer.nsecsElapsed();
+    timer.restart();
+    bool nfpRet = collidesWithOtherPiecesByNFP(sheetID, typeID, alpha, position, piece);
+    nfpCollisionTime += timer.nsecsElapsed();
+    if(satRet != nfpRet){
+        collisionMismatchCount++;
+    }
+    return nfpRet;
+#else
+    return collidesWithOtherPiecesByNFP(sheetID, typeID, alpha, position, piece);
+#endif
+}
+
+/**
+ * @brief NestEngine::getRotatedPiece
+ * 从旋转零件缓存中获取零件，外包矩形中心位于原点
+ * @param typeID 零件类型
+ * @param alpha 旋转角度
+ * @return
+ */
+Piece NestEngine::getRotatedPiece(int typeID, qreal alpha)
+{
+    return rotatedPieceCache.value(typeID, alpha, pieceList[typeID]);
+}
+
+/**
+ * @brief NestEngine::placeNestedPiece
+ * 将零件移动、旋转至排版零件的位置，旋转后的零件取自缓存
+ * @param piece 零件
+ * @param nestPiece 排版零件
+ */
+void NestEngine::placeNestedPiece(Piece &piece, const NestEngine::NestPiece &nestPiece)
+{
+    piece = getRotatedPiece(nestPiece.typeID, nestPiece.alpha);
+    piece.moveTo(nestPiece.position);
+}
+
+/**
+ * @brief NestEngine::getNestedPiece
+ * 已排零件只在第一次使用(或位置、角度改变)时变换，之后直接使用缓存，
+ * 碰撞检测时不再对每个已排零件重复拷贝、移动、旋转
+ * @param index 排版零件序号
+ * @return
+ */
+const Piece &NestEngine::getNestedPiece(int index)
+{
+    const NestPiece &nestPiece = nestPieceList[index];
+    NestedPiece &nestedPiece = nestedPieceMap[index];
+    if(nestedPiece.position != nestPiece.position || nestedPiece.alpha != nestPiece.alpha){
+        nestedPiece.piece = pieceList[nestPiece.typeID];
+        placeNestedPiece(nestedPiece.piece, nestPiece);
+        nestedPiece.piece.updateGeometry();  // 缓存的零件只平移一次
+        nestedPiece.position = nestPiece.position;
+        nestedPiece.alpha = nestPiece.alpha;
+    }
+    return nestedPiece.piece;
+}
+
+/**
+ * @brief NestEngine::getComponentGap
+ * 材料设置的零件间距减去两零件碰撞检测外轮廓已偏移的部分，
+ * 各材料间距相同时为0，碰撞检测直接使用偏移后的外轮廓
+ * @param sheetID 材料ID
+ * @return
+ */
+qreal NestEngine::getComponentGap(int sheetID) const
+{
+    if(sheetID < 0 || sheetID >= sheetList.length()){
+        return 0;
+    }
+    return qMax(sheetList[sheetID].componentGap - 2 * pieceOffset, qreal(0));
+}
+
+/**
+ * @brief NestEngine::getGapPiece
+ * 最佳排版方式按原多边形计算，整版排版时按送料步距与组合偏移量直接摆放，不再做碰撞检测，
+ * 因此先将外轮廓按各材料零件间距最大值的一半向外偏移。
+ * 圆弧连接时偏移结果任意角度下的外包矩形都向四周扩大相同距离，中心不变，
+ * 按偏移结果得到的步距与偏移量可直接用于原零件；另加弦高误差与取整误差，保证间距不小于设定值
+ * @param piece 零件
+ * @return 零件间距为0或偏移失败时返回原零件
+ */
+Piece NestEngine::getGapPiece(const Piece &piece) const
+{
+    qreal gap = 0;
+    for(int i=0; i<sheetList.length(); i++){
+        gap = qMax(gap, sheetList[i].componentGap);
+    }
+    if(gap <= 0){
+        return piece;
+    }
+    const qreal arcTolerance = 0.01;  // 圆弧离散的弦高误差
+    PolygonOffset polygonOffset(PolygonOffset::RoundJoin, 2, arcTolerance);
+    qreal delta = gap / 2 + 2 * arcTolerance + qPow(10.0, -piece.getPrecision());
+    QVector<QPointF> points = polygonOffset.outerOutline(piece.getPointsList(), delta);
+    if(points.length() < 4){
+        return piece;
+    }
+    return Piece(points, piece.getCount(), piece.getPrecision());
+}
+
+/**
+ * @brief NestEngine::initPieceOffset
+ * 各零件的碰撞检测外轮廓按各材料零件间距最小值的一半向外偏移，
+ * 偏移结果随零件保存，旋转、平移时同步变换，不必在每次碰撞检测时考虑间距；
+ * 有零件偏移失败时全部不偏移，仍按间距逐次检测
+ */
+void NestEngine::initPieceOffset()
+{
+    pieceList = sourcePieceList;
+    pieceOffset = sheetList.isEmpty() ? 0 : LONG_MAX;
+    for(int i=0; i<sheetList.length(); i++){
+        pieceOffset = qMin(pieceOffset, qMax(sheetList[i].componentGap, qreal(0)) / 2);
+    }
+    if(pieceOffset > 0){
+        // 各零件的偏移相互独立，在线程池中并行计算
+        QAtomicInt failedCount(0);
+        qreal offset = pieceOffset;
+        QtConcurrent::blockingMap(pieceList, [&failedCount, offset](Piece &piece){
+            if(!piece.offsetCollisionOutline(offset)){
+                failedCount.ref();
+            }
+        });
+        if(failedCount.load() > 0){
+            pieceList = sourcePieceList;
+            pieceOffset = 0;
+        }
+    }
+    updateCollisionMargin();
+}
+
+/**
+ * @brief NestEngine::updateCollisionMargin
+ * 零件简化后，碰撞检测外轮廓可能超出外包矩形，
+ * 四叉树中保存的仍为外包矩形，查询时需按各零件超出距离的最大值扩大
+ */
+void NestEngine::updateCollisionMargin()
+{
+    collisionMargin = 0;
+    for(int i=0; i<pieceList.length(); i++){
+        collisionMargin = qMax(collisionMargin, pieceList[i].getCollisionMargin());
+    }
+}
+
+/**
+ * @brief NestEngine::collidesWithNestedPieceList
+ * 从四叉树中取出可能重叠的已排零件，一次批量检测。
+ * 材料设置了零件间距时，与已排零件的距离小于间距即视为重叠
+ * @param sheetID 材料ID
+ * @param piece 已移动、旋转至排放位置的零件
+ * @return
+ */
+bool NestEngine::collidesWithNestedPieceList(int sheetID, const Piece &piece)
+{
+    qreal gap = getComponentGap(sheetID);
+    qreal margin = gap + piece.getCollisionMargin() + collisionMargin;  // 简化外轮廓可能超出外包矩形
+    Object obj(piece.getBoundingRect().adjusted(-margin, -margin, margin, margin));
+    std::list<Object *> resObjects = quadTreeMap[sheetID]->retrieve(&obj);
+    QVector<const Piece *> nestedList;
+    nestedList.reserve(int(resObjects.size()));
+    for(auto &t:resObjects){
+        nestedList.append(&getNestedPiece(t->id));
+    }
+    int ret = piece.collidesWithPieces(nestedList, gap);
+    collisionCount += ret < 0 ? nestedList.length() : ret;
+    return ret >= 0;
+}
+
+/**
+ * @brief NestEngine::slideDistanceToOtherPieces
+ * 通过四叉树获取扫过区域内的已排零件，一次遍历得到最近的接触距离。
+ * 材料设置了零件间距时，得到的是平移至与已排零件距离为间距的距离
+ * @param sheetID 材料ID
+ * @param piece 零件
+ * @param direction 平移方向，单位向量
+ * @param sweepRect 零件平移时扫过的区域
+ * @return 接触距离，不与任何零件接触时返回std::numeric_limits<qreal>::max()
+ */
+qreal NestEngine::slideDistanceToOtherPieces(int sheetID, const Piece &piece, const QPointF &direction, const QRectF &sweepRect)
+{
+    qreal minDis = std::numeric_limits<qreal>::max();
+    qreal gap = getComponentGap(sheetID);
+    qreal margin = gap + piece.getCollisionMargin() + collisionMargin;  // 简化外轮廓可能超出外包矩形
+    QRectF gapRect = sweepRect.adjusted(-margin, -margin, margin, margin);  // 按间距扩大的扫过区域
+    Object obj(gapRect);
+    std::list<Object *> resObjects = quadTreeMap[sheetID]->retrieve(&obj);
+    for(auto &t:resObjects){
+        const Piece &pieceNested = getNestedPiece(t->id);
+        if(boundingRectSeperate(gapRect, pieceNested.getBoundingRect())){
+            continue;
+        }
+        minDis = qMin(minDis, piece.slideDistance(pieceNested, direction, gap));
+        collisionCount++;
+    }
+    return minDis;
+}
+
+/**
+ * @brief NestEngine::penetrationWithOtherPieces
+ * 分离轴检测零件与已排零件是否重叠，同时返回零件移出碰撞的平移向量。
+ * 与多个已排零件重叠时，以各自的最小穿透方向为候选方向，
+ * 取移出所有重叠零件所需距离最小的方向。
+ * 材料设置了零件间距时，移出后与已排零件的距离为间距
+ * @param sheetID 材料ID
+ * @param piece 已移动、旋转至排放位置的零件
+ * @param separatingAxisMap 各已排零件上一次的分离轴 Map<排版零件序号, 分离轴>，检测后更新
+ * @param direction 指定移出方向(单位向量)，为空时取最小平移向量
+ * @return
+ */
+CollisionDectect::CollisionInfo NestEngine::penetrationWithOtherPieces(int sheetID, const Piece &piece,
+                                                                      QMap<int, QPointF> &separatingAxisMap,
+                                                                      const QPointF &direction)
+{
+    CollisionDectect::CollisionInfo info;
+    qreal gap = getComponentGap(sheetID);
+    qreal margin = gap + piece.getCollisionMargin() + collisionMargin;  // 简化外轮廓可能超出外包矩形
+    Object obj(piece.getBoundingRect().adjusted(-margin, -margin, margin, margin));
+    std::list<Object *> resObjects = quadTreeMap[sheetID]->retrieve(&obj);
+    QVector<const Piece *> collidedPieceList;  // 重叠的已排零件
+    QVector<CollisionDectect::CollisionInfo> infoList;  // 与各重叠零件的穿透信息
+    for(auto &t:resObjects){
+        int id = t->id;
+        const Piece &pieceNested = getNestedPiece(id);
+        CollisionDectect::CollisionInfo pieceInfo =
+                piece.penetrationWithPiece(pieceNested, separatingAxisMap.value(id), direction, gap);
+        collisionCount++;
+        if(pieceInfo.collided){
+            separatingAxisMap.remove(id);
+            collidedPieceList.append(&pieceNested);
+            infoList.append(pieceInfo);
+        } else if(!pieceInfo.axis.isNull()){
+            separatingAxisMap.insert(id, pieceInfo.axis);
+        } else{
+            separatingAxisMap.remove(id);
+        }
+    }
+    if(infoList.isEmpty()){
+        return info;
+    }
+    if(infoList.length() == 1){
+        return infoList.first();
+    }
+    // 指定方向时，各零件的移出方向相同，取最大的穿透深度
+    if(!direction.isNull()){
+        info = infoList.first();
+        for(int i=1; i<infoList.length(); i++){
+            if(infoList[i].depth > info.depth){
+                info = infoList[i];
+            }
+        }
+        return info;
+    }
+    info.collided = true;
+    info.depth = LONG_MAX;
+    for(int k=0; k<infoList.length(); k++){
+        QPointF axis = infoList[k].axis;
+        qreal depth = infoList[k].depth;
+        for(int i=0; i<collidedPieceList.length() && depth < info.depth; i++){
+            if(i != k){
+                depth = qMax(depth, piece.penetrationWithPiece(*collidedPieceList[i], QPointF(), axis, gap).depth);
+            }
+        }
+        if(depth < info.depth){
+            info.depth = depth;
+            info.axis = axis;
+        }
+    }
+    info.mtv = info.axis * info.depth;
+    return info;
+}
+
+/**
+ * @brief NestEngine::packOnePieceInHoles
+ * 从内孔四叉树中取出该材料上已排零件的内孔，只在放得下零件外包矩形的内孔中生成候选排样点，
+ * 不扫描整张材料的排样点。候选点按maxStep取样，内孔较小时加密，取重心最低的位置
+ * @param sheetID 材料ID
+ * @param nestPiece 排版零件
+ * @param rotateNumber 在最大旋转角度内尝试的旋转个数
+ * @param maxStep 最大取样间隔
+ * @return 是否排入内孔
+ */
+bool NestEngine::packOnePieceInHoles(int sheetID, NestEngine::NestPiece &nestPiece, int rotateNumber, qreal maxStep)
+{
+    if(!holeQuadTreeMap.contains(sheetID) || nestEngineStrategys == ReferenceLine){
+        return false;
+    }
+    // 每个旋转角度的零件取自旋转零件缓存，外包矩形中心位于原点
+    QVector<Piece> rotatedPieceList;
+    QVector<qreal> alphaList;
+    QVector<QRectF> rectList;  // 各旋转角度下含碰撞余量的外包矩形
+    qreal minRectWidth = std::numeric_limits<qreal>::max();
+    qreal minRectHeight = std::numeric_limits<qreal>::max();
+    for(int k=0; k<=rotateNumber; k++){
+        qreal alpha = rotateNumber == 0 ? nestPiece.alpha : maxRotateAngle * k / rotateNumber + nestPiece.alpha;
+        Piece pieceTmp = getRotatedPiece(nestPiece.typeID, alpha);
+        qreal margin = pieceTmp.getCollisionMargin();
+        QRectF rect = pieceTmp.getBoundingRect().adjusted(-margin, -margin, margin, margin);
+        minRectWidth = qMin(minRectWidth, rect.width());
+        minRectHeight = qMin(minRectHeight, rect.height());
+        rotatedPieceList.append(pieceTmp);
+        alphaList.append(alpha);
+        rectList.append(rect);
+    }
+    // 按零件外包矩形尺寸查询内孔四叉树，小于外包矩形的节点整棵跳过
+    std::list<Object *> resObjects;
+    retrieveHolesFitting(holeQuadTreeMap[sheetID], minRectWidth, minRectHeight, resObjects);
+    if(resObjects.empty()){
+        return false;
+    }
+    const QVector<NestedHole> &holeList = sheetHoleMap[sheetID];
+    qreal pieceArea = rotatedPieceList[0].getArea();
+    bool found = false;
+    qreal minHeightInHole = LONG_MAX;
+    QPointF bestPos;
+    qreal bestAlpha = nestPiece.alpha;
+    for(auto &t:resObjects){
+        const NestedHole &hole = holeList[t->id];
+        if(hole.area < pieceArea){  // 内孔面积小于零件面积，不可能放下
+            continue;
+        }
+        QRectF holeRect = hole.rect;
+        qreal step = qMax(qMin(maxStep, qMin(holeRect.width(), holeRect.height()) / 4), compactAccuracy);  // 取样间隔
+        for(int k=0; k<rotatedPieceList.length(); k++){
+            const QRectF &rect = rectList[k];
+            if(rect.width() > holeRect.width() || rect.height() > holeRect.height()){
+                continue;  // 该角度下外包矩形放不进内孔的包络矩形，不做取样
+            }
+            Piece pieceTmp = rotatedPieceList[k];
+            // 外包矩形中心的可选范围
+            qreal minX = holeRect.left() - rect.left();
+            qreal maxX = holeRect.right() - rect.right();
+            qreal minY = holeRect.top() - rect.top();
+            qreal maxY = holeRect.bottom() - rect.bottom();
+            if(maxX < minX || maxY < minY){
+                continue;
+            }
+            int columns = qFloor((maxX - minX) / step) + 1;
+            int rows = qFloor((maxY - minY) / step) + 1;
+            for(int r=0; r<rows; r++){
+                for(int c=0; c<columns; c++){
+                    QPointF pos(minX + c * step, minY + r * step);
+                    pieceTmp.moveTo(pos);
+                    qreal height = pieceTmp.getCenterPoint().ry();
+                    if(qrealPrecision(height, PRECISION) >= qrealPrecision(minHeightInHole, PRECISION)){
+                        continue;
+                    }
+                    if(!pieceTmp.containsInSheet(sheetList[sheetID])){
+                        continue;
+                    }
+                    if(collidesWithNestedPieces(sheetID, pieceTmp, nestPiece.typeID, alphaList[k], pieceTmp.getPosition())){
+                        continue;
+                    }
+                    minHeightInHole = height;
+                    bestPos = pos;
+                    bestAlpha = alphaList[k];
+                    found = true;
+                }
+            }
+        }
+    }
+    if(found){
+        nestPiece.position = bestPos;
+        nestPiece.alpha = bestAlpha;
+        nestPiece.nested = true;
+        nestPiece.sheetID = sheetID;
+    }
+    return found;
+}
+
+/**
+ * @brief NestEngine::insertNestedHoles
+ * 已排零件的碰撞检测内孔按包络矩形加入该材料的内孔四叉树
+ * @param sheetID 材料ID
+ * @param index 排版零件序号
+ * @param piece 已移动、旋转至排放位置的零件
+ */
+void NestEngine::insertNestedHoles(int sheetID, int index, const Piece &piece)
+{
+    if(!piece.hasHoles()){
+        return;
+    }
+    if(!holeQuadTreeMap.contains(sheetID)){
+        QRectF rect = sheetList[sheetID].layoutRect();
+        holeQuadTreeMap.insert(sheetID, new QuadTreeNode<Object>(rect.x(), rect.y(), rect.width(), rect.height(), 1, 5, 10, ROOT, NULL));
+    }
+    QVector<NestedHole> &holeList = sheetHoleMap[sheetID];
+    const QVector<QVector<QPointF>> &holesList = piece.getCollisionHolesList();
+    for(int i=0; i<holesList.length(); i++){
+        QRectF rect = calculatePolygonBoundingRect(holesList[i]);
+        holeList.append(NestedHole(index, i, rect, calculatePolygonArea(holesList[i])));
+        holeQuadTreeMap[sheetID]->insert(new Object(holeList.length() - 1, rect));
+    }
+}
+
+/**
+ * @brief NestEngine::retrieveHolesFitting
+ * 递归取出四叉树中包络矩形不小于 width x height 的内孔。
+ * 对象存放在完全包含它的节点内，节点尺寸小于零件外包矩形时其子树中不可能有放得下零件的内孔，整棵跳过
+ * @param node 四叉树节点
+ * @param width 零件外包矩形的最小宽度
+ * @param height 零件外包矩形的最小高度
+ * @param result 查询结果
+ */
+void NestEngine::retrieveHolesFitting(QuadTreeNode<Object> *node, qreal width, qreal height, std::list<Object *> &result)
+{
+    if(node == NULL || node->width < width || node->height < height){
+        return;
+    }
+    for(auto &obj : node->objects){
+        if(obj->width >= width && obj->height >= height){
+            result.push_back(obj);
+        }
+    }
+    retrieveHolesFitting(node->upRightNode, width, height, result);
+    retrieveHolesFitting(node->upLeftNode, width, height, result);
+    retrieveHolesFitting(node->bottomLeftNode, width, height, result);
+    retrieveHolesFitting(node->bottomRightNode, width, height, result);
+}
+
+/**
+ * @brief NestEngine::deleteHoleQuadTree
+ * 释放内孔四叉树的节点及节点中的对象，QuadTreeNode的析构函数不释放子节点
+ * @param node 四叉树节点
+ */
+void NestEngine::deleteHoleQuadTree(QuadTreeNode<Object> *node)
+{
+    if(node == NULL){
+        return;
+    }
+    qDeleteAll(node->objects);
+    node->objects.clear();
+    deleteHoleQuadTree(node->upRightNode);
+    deleteHoleQuadTree(node->upLeftNode);
+    deleteHoleQuadTree(node->bottomLeftNode);
+    deleteHoleQuadTree(node->bottomRightNode);
+    delete node;
+}
+
+/**
+ * @brief NestEngine::clearNestedHoles
+ * 清空内孔列表并释放各材料的内孔四叉树
+ */
+void NestEngine::clearNestedHoles()
+{
+    for(auto it=holeQuadTreeMap.constBegin(); it!=holeQuadTreeMap.constEnd(); ++it){
+        deleteHoleQuadTree(it.value());
+    }
+    holeQuadTreeMap.clear();
+    sheetHoleMap.clear();
+}
+
 void NestEngine::onNestStart()
 {
     if(!isStripSheet){  // 如果不为条形材料排版，则首先计算每个零件的最佳排版类型
         qDebug() << "如果不为条形材料排版，则首先计算每个零件的最佳排版类型";
         getAllBestNestTypes(pieceList);  // 获取每个零件最佳排样类型
     }
+#ifdef COLLISIONSTATISTICS
+    Piece::resetCollisionStatistics();
+#endif
     initNestPieceList();  // 初始化排样零件
     packAlg();  // 进行连续排版
+#ifdef COLLISIONSTATISTICS
+    qDebug() << "凸多边形对检测次数：" << Piece::getPartPairTestCount()
+             << "，被包络矩形/包络圆剔除：" << Piece::getPartPairCulledCount();
+    qDebug() << "旋转零件缓存：" << rotatedPieceCache.size()
+             << "，占用(KB)：" << rotatedPieceCache.getBytes() / 1024
+             << "，命中：" << rotatedPieceCache.getHitCount()
+             << "，未命中：" << rotatedPieceCache.getMissCount()
+             << "，淘汰：" << rotatedPieceCache.getEvictionCount();
+#endif
+#ifdef NFPBENCHMARK
+    qDebug() << "SAT碰撞检测耗时(ms)：" << satCollisionTime / 1000000.0
+             << "，NFP碰撞检测耗时(ms)：" << nfpCollisionTime / 1000000.0
+             << "，结果不一致次数：" << collisionMismatchCount
+             << "，NFP缓存：" << nfpCache.size()
+             << "，命中：" << nfpCache.getHitCount()
+             << "，未命中：" << nfpCache.getMissCount()
+             << "，占用(KB)：" << nfpCache.getBytes() / 1024
+             << "，淘汰：" << nfpCache.getEvictionCount();
+#endif
 }
 
 QRectF NestEngine::getPairBoundingRect(QPointF &pos1, QPointF &pos2,
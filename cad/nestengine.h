@@ -6,6 +6,8 @@
 #include <QVector>
 #include <piece.h>
 #include <sheet.h>
+#include "nofitpolygon.h"
+#include "rotatedpiececache.h"
 
 class NestEngineConfigure;
 
@@ -109,6 +111,50 @@ public:
         int rightID;  // 右支零件ID
     };
 
+    /**
+     * @brief The NestedPiece struct
+     * 已排零件在材料上的形状，按排版零件的位置、角度变换一次后缓存
+     */
+    struct NestedPiece
+    {
+        NestedPiece() :
+            position(QPointF(-INT_MAX, -INT_MAX)),
+            alpha(0)
+        {}
+
+        QPointF position;  // 变换时使用的位置
+        qreal alpha;  // 变换时使用的角度
+        Piece piece;  // 变换后的零件
+    };
+
+    /**
+     * @brief The NestedHole struct
+     * 已排零件的内孔，用于将零件排入内孔
+     */
+    struct NestedHole
+    {
+        NestedHole() :
+            index(-1),
+            holeID(-1),
+            area(0)
+        {
+
+        }
+        NestedHole(int i, int h, QRectF r, qreal a) :
+            index(i),
+            holeID(h),
+            rect(r),
+            area(a)
+        {
+
+        }
+
+        int index;  // 排版零件序号
+        int holeID;  // 内孔序号
+        QRectF rect;  // 内孔的包络矩形
+        qreal area;  // 内孔面积
+    };
+
     /**
      * @brief The IDRange struct
      * 零件组成排版零件后在列表中的序号范围
@@ -165,6 +211,15 @@ public:
         ContinueNest
     };
 
+    /**
+     * @brief The CollisionBackend enum
+     * 碰撞检测方式
+     */
+    enum CollisionBackend{
+        SATCollisionBackend,  // 分离轴检测，默认
+        NFPCollisionBackend  // 临界多边形检测，不支持参考线排版
+    };
+
     /**
      * @brief The NestType enum
      * 排版方式
@@ -228,6 +283,65 @@ public:
         qreal yStep;  // y方向送料步距
     };
 
+    /**
+     * @brief The BestNestTypeTask struct
+     * 最佳排版方式分析任务，对应(零件类型, 排版策略, 角度区间)，
+     * 各任务相互独立，可在线程池中并行计算
+     */
+    struct BestNestTypeTask
+    {
+        BestNestTypeTask() :
+            piece(NULL),
+            typeID(-1),
+            strategy(NoNestType),
+            minAngle(0),
+            maxAngle(0),
+            maxWidth(LONG_MAX),
+            maxHeight(LONG_MAX),
+            rate(0),
+            alpha(0),
+            step(0),
+            X(0),
+            H(0),
+            nsecs(0)
+        {
+
+        }
+
+        BestNestTypeTask(const Piece *p, int id, NestType s, int min, int max, qreal w, qreal h) :
+            piece(p),
+            typeID(id),
+            strategy(s),
+            minAngle(min),
+            maxAngle(max),
+            maxWidth(w),
+            maxHeight(h),
+            rate(0),
+            alpha(0),
+            step(0),
+            X(0),
+            H(0),
+            nsecs(0)
+        {
+
+        }
+
+        const Piece *piece;  // 待排零件
+        int typeID;  // 零件类型
+        NestType strategy;  // 排版策略，SingleRow、DoubleRow、OppositeSingleRow、OppositeDoubleRow分别对应4种顶点算法
+        int minAngle;  // 角度区间下限
+        int maxAngle;  // 角度区间上限
+        qreal maxWidth;  // 最大宽度限制
+        qreal maxHeight;  // 最大高度限制
+        qreal rate;  // 材料利用率，无可行解时为0
+        qreal alpha;  // 旋转角度
+        qreal step;  // 送料步距
+        qreal X;  // 错开零件x方向偏移
+        qreal H;  // 错开量
+        QPointF offset;  // 旋转中心较零件位置的偏移量
+        qint64 nsecs;  // 计算用时，单位为ns
+    };
+
     /**
      * @brief The SinglePieceStatus struct
      * 单个零件状态
@@ -434,6 +548,18 @@ public:
     void setMaxRotateAngle(int angle);  // 设置最大旋转角度
     qreal getMaxRotateAngle();  // 获取最大旋转角度
 
+    void setAngleTolerance(qreal tolerance);  // 设置旋转角度优化精度
+    qreal getAngleTolerance();  // 获取旋转角度优化精度
+
+    void setMaxAngleEvaluations(int count);  // 设置每个局部极小值细化时的最大求值次数
+    int getMaxAngleEvaluations();  // 获取每个局部极小值细化时的最大求值次数
+
+    void setCollisionBackend(CollisionBackend backend);  // 设置碰撞检测方式
+    CollisionBackend getCollisionBackend();  // 获取碰撞检测方式
+
+    void setPartInPart(bool enabled);  // 设置是否将零件排入已排零件的内孔
+    bool isPartInPart() const;  // 是否将零件排入已排零件的内孔
+
     void setMinHeightOpt(bool flag);  // 设置是否自动重复使用最后一张材料
     bool getMinHeightOpt();  // 获取是否自动重复使用最后一张材料
 
@@ -444,11 +570,17 @@ public:
     void initSamePairNestPieceIndexMap();  // 初始化同双体排版零件列表Map
     void initNestEngineConfig(Sheet::SheetType sheetType, NestEngineConfigure *proConfig);  // 初始化排版引擎配置
 
-    void singleRowNest(Piece piece, qreal &alpha, qreal &stepX, qreal &width, qreal &height);  // 最优单排
-    void doubleRowNest(Piece piece, const int n, qreal &alpha, qreal &stepX, QPointF &cOffset, qreal &width, qreal &height);  // 最优双排
-    void pairwiseDoubleRowNest(Piece piece, qreal &alpha, QPointF &cOffset, qreal &width, qreal &height);  // 最优对头双排
+    void singleRowNest(const Piece &piece, qreal &alpha, qreal &stepX, qreal &width, qreal &height);  // 最优单排
+    void doubleRowNest(const Piece &piece, const int n, qreal &alpha, qreal &stepX, QPointF &cOffset, qreal &width, qreal &height);  // 最优双排
+    void pairwiseDoubleRowNest(const Piece &piece, qreal &alpha, QPointF &cOffset, qreal &width, qreal &height);  // 最优对头双排
 
     qreal calRealBestXStep(const Piece &piece, const qreal alpha, const QPointF &offset, bool forOppFlag=true) const;  // 对对头排版计算真实的送料步距
+    Piece getAnalysisRotatedPiece(const Piece &piece, qreal alpha, const int typeID);  // 获取排版方式分析用的旋转零件
+    qreal optimizeRotateAngle(const std::function<qreal(qreal)> &objective,
+                              const int minRotateAngle,
+                              const int maxRotateAngle,
+                              qreal &alpha,
+                              const int coarseStep=10);  // 粗扫描后在局部极小值附近细化旋转角度
     /**
      * 4中单零件排样策略，返回材料利用率
      */
@@ -457,7 +589,9 @@ public:
                                   qreal &step,
                                   const int maxRotateAngle=180,
                                   const qreal maxWidth=LONG_MAX,
-                                  const qreal maxHeight=LONG_MAX);  // 单排，使用顶点算法
+                                  const qreal maxHeight=LONG_MAX,
+                                  const int typeID=-1,
+                                  const int minRotateAngle=0);  // 单排，使用顶点算法
 
     qreal doubleRowNestWithVerAlg(const Piece &piece,
                                   qreal &alpha,
@@ -467,13 +601,17 @@ public:
                                   const qreal n=100,
                                   const int maxRotateAngle=180,
                                   const qreal maxWidth=LONG_MAX,
-                                  const qreal maxHeight=LONG_MAX);  // 双排，使用顶点算法
+                                  const qreal maxHeight=LONG_MAX,
+                                  const int typeID=-1,
+                                  const int minRotateAngle=0);  // 双排，使用顶点算法
 
     qreal oppositeSingleRowNestWithVerAlg(const Piece &piece, qreal &alpha,
                                           qreal &step, QPointF &offset,
                                           const int maxRotateAngle=180,
                                           const qreal maxWidth=LONG_MAX,
-                                          const qreal maxHeight=LONG_MAX);  // 对头单排，使用顶点算法
+                                          const qreal maxHeight=LONG_MAX,
+                                          const int typeID=-1,
+                                          const int minRotateAngle=0);  // 对头单排，使用顶点算法
 
     qreal oppositeDoubleRowNestWithVerAlg(const Piece &piece,
                                           qreal &alpha,
@@ -483,7 +621,9 @@ public:
                                           const qreal n=100,
                                           const int maxRotateAngle=180,
                                           const qreal maxWidth=LONG_MAX,
-                                          const qreal maxHeight=LONG_MAX);  // 对头双排，使用顶点算法
+                                          const qreal maxHeight=LONG_MAX,
+                                          const int typeID=-1,
+                                          const int minRotateAngle=0);  // 对头双排，使用顶点算法
 
     NestType getPieceBestNestType(const Piece &piece,
                                   qreal &alpha,
@@ -492,9 +632,23 @@ public:
                                   QPointF &rCOffset,
                                   const int maxRotateAngle=180,
                                   const qreal maxWidth=LONG_MAX,
-                                  const qreal maxHeight=LONG_MAX);  // 获取零件的最佳排版方式
+                                  const qreal maxHeight=LONG_MAX,
+                                  const int typeID=-1);  // 获取零件的最佳排版方式
 
     void getAllBestNestTypes(QVector<Piece> pieceList);  // 获取所有零件最佳排样方式
+    QVector<BestNestTypeTask> createBestNestTypeTasks(const Piece &piece, const int maxRotateAngle,
+                                                      const qreal maxWidth, const qreal maxHeight,
+                                                      const int typeID);  // 将零件的最佳排版方式分析划分为任务
+    void runBestNestTypeTask(BestNestTypeTask &task);  // 执行分析任务
+    NestType mergeBestNestTypeTasks(const Piece &piece,
+                                    const BestNestTypeTask *taskList,
+                                    int taskCount,
+                                    qreal &alpha,
+                                    qreal &xStep,
+                                    QPointF &pOffset,
+                                    QPointF &rCOffset);  // 按任务顺序合并分析结果
+    static QPointF calRCOffset(const Piece &piece, const QPointF &pOffset);  // 计算组合外包矩形中心
+    Piece getGapPiece(const Piece &piece) const;  // 外轮廓按零件间距的一半向外偏移，用于计算含间距的排版方式
 
     qreal oppositeDoubleRowNestWithVerAlgForStrip(const QRectF &layoutRect,
                                                   const Piece &piece1,
@@ -507,10 +661,29 @@ public:
     void packAlg();  // 排版算法
 
     virtual void packPieces(QVector<int> indexList);  //  排版算法
-    virtual bool packOnePiece(Piece piece, NestEngine::NestPiece &nestPiece);  // 排放单个零件
-    virtual bool packOnePieceOnSheet(Piece piece, int sheetID, NestEngine::NestPiece &nestPiece);  // 在给定材料上排放单个零件
+    virtual bool packOnePiece(const Piece &piece, NestEngine::NestPiece &nestPiece);  // 排放单个零件
+    virtual bool packOnePieceOnSheet(const Piece &piece, int sheetID, NestEngine::NestPiece &nestPiece);  // 在给定材料上排放单个零件
     virtual bool compact(int sheetID, NestPiece &nestPiece);  // 紧凑算法
-    virtual bool collidesWithOtherPieces(int sheetID, Piece piece);  // 判断该零件是否与其他零件重叠
+    virtual bool collidesWithOtherPieces(int sheetID, const Piece &piece);  // 判断该零件是否与其他零件重叠
+
+    NoFitPolygon getNoFitPolygon(int fixedTypeID, qreal fixedAlpha, int movingTypeID, qreal movingAlpha);  // 获取两零件的临界多边形
+    bool collidesWithOtherPiecesByNFP(int sheetID, int typeID, qreal alpha, const QPointF &position, const Piece &piece);  // 使用临界多边形判断该零件是否与其他零件重叠
+    bool collidesWithNestedPieces(int sheetID, const Piece &piece, int typeID, qreal alpha, const QPointF &position);  // 根据碰撞检测方式判断该零件是否与其他零件重叠
+    virtual bool isNFPCollisionSupported() const;  // 当前排版方式能否使用临界多边形检测
+    virtual void placeNestedPiece(Piece &piece, const NestPiece &nestPiece);  // 将零件变换至排版零件的位置、角度
+    const Piece &getNestedPiece(int index);  // 获取已排零件在材料上的形状
+    Piece getRotatedPiece(int typeID, qreal alpha);  // 获取移至原点、旋转alpha度之后的零件
+    qreal getComponentGap(int sheetID) const;  // 获取材料的零件间距
+    void updateCollisionMargin();  // 更新各零件碰撞检测外轮廓超出外包矩形的最大距离
+    void initPieceOffset();  // 按零件间距偏移各零件的碰撞检测外轮廓，每种零件只计算一次
+    bool collidesWithNestedPieceList(int sheetID, const Piece &piece);  // 批量判断该零件是否与四叉树中的已排零件重叠
+    CollisionDectect::CollisionInfo penetrationWithOtherPieces(int sheetID, const Piece &piece,
+                                                               QMap<int, QPointF> &separatingAxisMap,
+                                                               const QPointF &direction = QPointF());  // 判断该零件是否与其他零件重叠，同时返回穿透信息
+    qreal slideDistanceToOtherPieces(int sheetID, const Piece &piece, const QPointF &direction, const QRectF &sweepRect);  // 零件沿direction方向平移至与其他零件接触的距离
+    bool packOnePieceInHoles(int sheetID, NestPiece &nestPiece, int rotateNumber, qreal maxStep);  // 尝试将零件排入已排零件的内孔
+    void insertNestedHoles(int sheetID, int index, const Piece &piece);  // 将已排零件的内孔加入内孔四叉树
+    void clearNestedHoles();  // 清空内孔列表并释放内孔四叉树
 
 signals:
     void nestPieceUpdate(NestEngine::NestPiece nestPiece);  // 排版零件更新
@@ -527,7 +700,8 @@ public slots:
     void onNestStart();  // 开始排版
 
 protected:
-    QVector<Piece> pieceList;  // 零件列表
+    QVector<Piece> pieceList;  // 零件列表，碰撞检测外轮廓已按pieceOffset偏移
+    QVector<Piece> sourcePieceList;  // 未偏移的零件列表
     QVector<Sheet> sheetList;  // 材料列表
     QVector<SameTypePiece> sameTypePieceList;  // 同型体零件
     QVector<PairPiece> pairPieceList;  // 同双零件
@@ -549,6 +723,7 @@ protected:
     //QMap<int, QMap<int, QList<int>>> sheetRowPieceMap;  // 记录材料-行-零件 Map<材料id, Map<行id, 零件id列表>>
     QMap<int, int> pieceMaxPackPointMap;  // 记录零件-最大排样点序号 Map<零件id, 排样点id>   /////迁移至packPointNestEngine
     QMap<int, QuadTreeNode<Object>*> quadTreeMap;  // 四叉树 Map<材料id, 四叉树>
+    QMap<int, NestedPiece> nestedPieceMap;  // 已排零件形状缓存 Map<排版零件序号, 已排零件>
 
     bool isStripSheet;  // 条形板材料标志
     bool autoRepeatLastSheet;  // 自动重复使用最后一张材料
@@ -564,14 +739,31 @@ protected:
     qreal cutStep;  // 切割步长
     bool rotatable;  // 可旋转
     int maxRotateAngle;  // 最大转动角度
+    qreal angleTolerance;  // 旋转角度优化精度，单位为度
+    int maxAngleEvaluations;  // 每个局部极小值细化时的最大求值次数，为0时只粗扫描
     bool minHeightOpt;  // 最小高度优化
+    bool partInPart;  // 是否将零件排入已排零件的内孔
+    QMap<int, QVector<NestedHole>> sheetHoleMap;  // 材料上已排零件的内孔 Map<材料id, 内孔列表>
+    QMap<int, QuadTreeNode<Object>*> holeQuadTreeMap;  // 内孔四叉树 Map<材料id, 四叉树>，对象id为内孔在内孔列表中的序号
     int collisionCount;  // 碰撞检测次数
+    CollisionBackend collisionBackend;  // 碰撞检测方式
+    NoFitPolygonCache nfpCache;  // 临界多边形缓存
+    RotatedPieceCache rotatedPieceCache;  // 旋转零件缓存
+    RotatedPieceCache analysisPieceCache;  // 排版方式分析用的旋转零件缓存，零件含零件间距，不能与排放用的零件混用
+    qreal collisionMargin;  // 各零件碰撞检测外轮廓超出外包矩形的最大距离，四叉树查询时按此扩大
+    qreal pieceOffset;  // 各零件碰撞检测外轮廓已向外偏移的距离，为各材料零件间距最小值的一半
+    qint64 satCollisionTime;  // 分离轴检测累计耗时，单位为ns，NFPBENCHMARK时统计
+    qint64 nfpCollisionTime;  // 临界多边形检测累计耗时，单位为ns，NFPBENCHMARK时统计
+    int collisionMismatchCount;  // 两种检测方式结果不一致的次数
 
     // debug
     int counter;
 
     QRectF getPairBoundingRect(QPointF &pos1, QPointF &pos2, const qreal pieceWidth, const qreal pieceHeight);  // 计算组合零件的外包矩形
     QRectF getPairBoundingRect(QRectF &bRect1, QRectF &bRect2);  // 计算组合零件的外包矩形
+
+    static void retrieveHolesFitting(QuadTreeNode<Object> *node, qreal width, qreal height, std::list<Object *> &result);  // 取出放得下该尺寸外包矩形的内孔
+    static void deleteHoleQuadTree(QuadTreeNode<Object> *node);  // 释放内孔四叉树
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(NestEngine::NestMixingTypes)
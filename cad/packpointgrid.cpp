@@ -0,0 +1,146 @@
+﻿#include "packpointgrid.h"
+#include <QtAlgorithms>
+
+PackPointGrid::PackPointGrid() :
+    rows(0),
+    columns(0),
+    PPD(0),
+    XOffset(0),
+    YOffset(0),
+    uncoveredCount(0)
+{
+
+}
+
+PackPointGrid::PackPointGrid(int rows, int columns, qreal PPD, qreal XOffset, qreal YOffset) :
+    rows(qMax(rows, 0)),
+    columns(qMax(columns, 0)),
+    PPD(PPD),
+    XOffset(XOffset),
+    YOffset(YOffset),
+    coveredBits((this->rows * this->columns + 63) / 64, 0),
+    rowUncoveredCountList(this->rows, this->columns),
+    uncoveredCount(this->rows * this->columns)
+{
+
+}
+
+PackPointGrid::PackPointGrid(int rows, const QVector<qreal> &columnPosList, qreal PPD, qreal YOffset) :
+    PackPointGrid(rows, columnPosList.length(), PPD, 0, YOffset)
+{
+    this->columnPosList = columnPosList;
+}
+
+int PackPointGrid::getRows() const
+{
+    return rows;
+}
+
+int PackPointGrid::getColumns() const
+{
+    return columns;
+}
+
+int PackPointGrid::count() const
+{
+    return rows * columns;
+}
+
+qreal PackPointGrid::getXOffset() const
+{
+    return XOffset;
+}
+
+qreal PackPointGrid::getYOffset() const
+{
+    return YOffset;
+}
+
+const QVector<qreal> &PackPointGrid::getColumnPosList() const
+{
+    return columnPosList;
+}
+
+/**
+ * @brief PackPointGrid::position
+ * 与逐点存储时的计算方式一致
+ * @param index 排样点序号
+ * @return
+ */
+QPointF PackPointGrid::position(int index) const
+{
+    int row = index / columns;  // 获取序号为index的排样点在第几行
+    int column = index - columns * row;  // 获取序号为index的排样点在第几列
+    qreal px = columnPosList.isEmpty() ? column * PPD + XOffset : columnPosList[column];
+    qreal py = row * PPD + YOffset;
+    return QPointF(px, py);
+}
+
+bool PackPointGrid::isCovered(int index) const
+{
+    return (coveredBits[index / 64] >> (index % 64)) & 1;
+}
+
+bool PackPointGrid::setCovered(int index)
+{
+    quint64 mask = quint64(1) << (index % 64);
+    quint64 &word = coveredBits[index / 64];
+    if(word & mask){
+        return false;
+    }
+    word |= mask;
+    rowUncoveredCountList[index / columns]--;
+    uncoveredCount--;
+    return true;
+}
+
+/**
+ * @brief PackPointGrid::nextUncovered
+ * 整行都已覆盖时直接跳到下一行，否则在该行内按64位字查找
+ * @param index 起始序号
+ * @return
+ */
+int PackPointGrid::nextUncovered(int index) const
+{
+    index = qMax(index, 0);
+    int PPN = count();
+    while(index < PPN){
+        int row = index / columns;
+        int rowEnd = (row + 1) * columns;  // 下一行第一个排样点
+        if(rowUncoveredCountList[row] > 0){
+            int ret = findUncovered(index, rowEnd);
+            if(ret >= 0){
+                return ret;
+            }
+        }
+        index = rowEnd;
+    }
+    return -1;
+}
+
+int PackPointGrid::getUncoveredCount() const
+{
+    return uncoveredCount;
+}
+
+int PackPointGrid::getRowUncoveredCount(int row) const
+{
+    return rowUncoveredCountList[row];
+}
+
+int PackPointGrid::findUncovered(int begin, int end) const
+{
+    int word = begin / 64;
+    quint64 bits = ~coveredBits[word] & (~quint64(0) << (begin % 64));  // 未覆盖的位，去掉begin之前的位
+    while(true){
+        if(bits){
+            int ret = word * 64 + qCountTrailingZeroBits(bits);
+            return ret < end ? ret : -1;
+        }
+        word++;
+        if(word * 64 >= end){
+            return -1;
+        }
+        bits = ~coveredBits[word];
+    }
+}
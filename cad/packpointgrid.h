@@ -0,0 +1,50 @@
+﻿#ifndef PACKPOINTGRID_H
+#define PACKPOINTGRID_H
+
+#include <QtGlobal>
+#include <QVector>
+#include <QPointF>
+
+/**
+ * @brief The PackPointGrid class
+ * 一张材料的排样点，按行优先编号，序号为row*columns+column。
+ * 排样点坐标由序号直接计算，不逐点存储；覆盖状态按序号存为位图，
+ * 查找下一个未覆盖的排样点时逐个64位字求最低的0位，
+ * 并用各行剩余排样点个数跳过整行都已覆盖的行
+ */
+class PackPointGrid
+{
+public:
+    PackPointGrid();
+    PackPointGrid(int rows, int columns, qreal PPD, qreal XOffset, qreal YOffset);  // 整体材料，列等间距
+    PackPointGrid(int rows, const QVector<qreal> &columnPosList, qreal PPD, qreal YOffset);  // 条板材料，各列位置由列表给出
+
+    int getRows() const;  // 行数
+    int getColumns() const;  // 列数
+    int count() const;  // 排样点个数
+    qreal getXOffset() const;  // x方向的偏移
+    qreal getYOffset() const;  // y方向的偏移
+    const QVector<qreal> &getColumnPosList() const;  // 各列位置，列等间距时为空
+
+    QPointF position(int index) const;  // 排样点坐标
+    bool isCovered(int index) const;  // 排样点是否被覆盖
+    bool setCovered(int index);  // 覆盖排样点，返回是否为新覆盖
+    int nextUncovered(int index) const;  // 序号不小于index的第一个未覆盖排样点，没有时返回-1
+    int getUncoveredCount() const;  // 未覆盖的排样点个数
+    int getRowUncoveredCount(int row) const;  // 该行未覆盖的排样点个数
+
+private:
+    int findUncovered(int begin, int end) const;  // [begin, end)内第一个未覆盖的排样点，没有时返回-1
+
+    int rows;  // 行数
+    int columns;  // 列数
+    qreal PPD;  // 排样点间隔
+    qreal XOffset;  // x方向的偏移
+    qreal YOffset;  // y方向的偏移
+    QVector<qreal> columnPosList;  // 条板材料各列的位置
+    QVector<quint64> coveredBits;  // 覆盖位图，第index位对应序号为index的排样点
+    QVector<int> rowUncoveredCountList;  // 各行未覆盖的排样点个数
+    int uncoveredCount;  // 未覆盖的排样点个数
+};
+
+#endif // PACKPOINTGRID_H
@@ -1,10 +1,14 @@
 ﻿#include "packpointnestengine.h"
+#include <limits>
 
 PackPointNestEngine::PackPointNestEngine(QObject *parent) :
     NestEngine(parent),
     PPD(5),
     RN(4),
-    minHeight(LONG_MAX)
+    minHeight(LONG_MAX),
+    collisionsMode(Piece::BoundingRectCollisionMode),
+    rasterResolution(1),
+    rasterRejectCount(0)
 {
     setNestEngineType(NestEngine::PackPointNest);
 }
@@ -13,7 +17,10 @@ PackPointNestEngine::PackPointNestEngine(QObject *parent,
                                          const QVector<Piece> pieceList,
                                          const QVector<Sheet> sheetList, qreal PPD, int RN) :
     NestEngine(parent, pieceList, sheetList),
-    minHeight(LONG_MAX)
+    minHeight(LONG_MAX),
+    collisionsMode(Piece::BoundingRectCollisionMode),
+    rasterResolution(1),
+    rasterRejectCount(0)
 {
     setNestEngineType(NestEngine::PackPointNest);
     this->PPD = PPD;
@@ -28,7 +35,10 @@ PackPointNestEngine::PackPointNestEngine(QObject *parent,
                                          qreal PPD,
                                          int RN) :
     NestEngine(parent, pieceList, sheetList, sameTypePieceList),
-    minHeight(LONG_MAX)
+    minHeight(LONG_MAX),
+    collisionsMode(Piece::BoundingRectCollisionMode),
+    rasterResolution(1),
+    rasterRejectCount(0)
 {
     setNestEngineType(NestEngine::PackPointNest);
     this->PPD = PPD;
@@ -44,7 +54,10 @@ PackPointNestEngine::~PackPointNestEngine()
 void PackPointNestEngine::initPackPoint(QVector<Sheet> sheetList, qreal PPD)
 {
     // 清空材料-排样点Map
-    sheetPackPointPositionMap.clear();
+    sheetPackPointGridMap.clear();
+    sheetRasterMap.clear();
+    pieceRasterMap.clear();
+    clearNestedHoles();
     // 初始化材料-排样点Map
     for(int i=0; i<sheetList.length(); i++){
         initPackPointOneSheet(i, PPD);
@@ -63,77 +76,30 @@ void PackPointNestEngine::initPackPointOneSheet(int sheetID, qreal PPD)
         qreal XOffset = sheet.leftMargin;
         qreal YOffset = sheet.topMargin;
 
-        // 记录第i个材料的排样点信息
-        QMap<int, PackPoint> packPointMap;
-        // 记录剩余排样点
-        QList<int> unusedPackPointList;
-        // 获取行列数即排样点个数总数
+        // 获取行列数，排样点坐标由序号计算，初始时均未覆盖
         int rows = qFloor(height / PPD) + 1;
         int columns = qFloor(width / PPD)  + 1;
-        int PPN = rows * columns;
-        for(int j=0; j<PPN; j++){
-            int row = j / columns;  // 获取序号为j的排样点在第几行
-            int column = (j - columns * row) % columns;  // 获取序号为j的排样点在第几列
-            // 将序号为j的排样点添加至map中
-            qreal px = column * PPD + XOffset;
-            qreal py = row * PPD + YOffset;
-            PackPoint packPoint(j, QPointF(px, py), false);
-            packPointMap.insert(j, packPoint);
-            // 将序号为j的排样点加入到剩余排样点map中
-            unusedPackPointList.append(j);
-        }
-        // 记录该材料的排样点信息
-        PackPointInfo info(sheetID, rows, columns, XOffset, YOffset);
-        packPointInfoList.append(info);
-        // 将第i个材料的排样点信息加入到map中去
-        sheetPackPointPositionMap.insert(sheetID, packPointMap);
-        // 剩余排样点
-        unusedSheetPackPointMap.insert(sheetID,unusedPackPointList);
+        sheetPackPointGridMap.insert(sheetID, PackPointGrid(rows, columns, PPD, XOffset, YOffset));
         return;
     }
 
     if(sheet.type == Sheet::Strip){
-        QVector<double> posList;
-        int columns = 0;  // 条板列数
+        QVector<qreal> posList;  // 各列位置，每个条板两列
         for(int i=0; i<sheet.stripPW.length(); i++){
             posList.append(sheet.stripPW[i].position);
             posList.append(sheet.stripPW[i].position + sheet.stripPW[i].width);
-            columns += 2;
         }
         qreal height = sheet.height - 2 * sheet.topMargin;
-        qreal XOffset = 0;
         qreal YOffset = sheet.topMargin;
 
-        // 记录第i个材料的排样点信息
-        QMap<int, PackPoint> packPointMap;
-        // 记录剩余排样点
-        QList<int> unusedPackPointList;
-        // 获取行列数即排样点个数总数
+        // 获取行数，各列的位置为条板的两侧
         int rows = qFloor(height / PPD) + 1;
-        int PPN = rows * columns;
-        for(int j=0; j<PPN; j++){
-            int row = j / columns;  // 获取序号为j的排样点在第几行
-            int column = (j - columns * row) % columns;  // 获取序号为j的排样点在第几列
-            // 将序号为j的排样点添加至map中
-            qreal px = posList[column];
-            qreal py = row * PPD + YOffset;
-            PackPoint packPoint(j, QPointF(px, py), false);
-            packPointMap.insert(j, packPoint);
-            // 将序号为j的排样点加入到剩余排样点map中
-            unusedPackPointList.append(j);
-        }
-        // 记录该材料的排样点信息
-        PackPointInfo info(sheetID, rows, columns, XOffset, YOffset, posList);
-        packPointInfoList.append(info);
-        // 将第i个材料的排样点信息加入到map中去
-        sheetPackPointPositionMap.insert(sheetID, packPointMap);
-        // 剩余排样点
-        unusedSheetPackPointMap.insert(sheetID,unusedPackPointList);
+        sheetPackPointGridMap.insert(sheetID, PackPointGrid(rows, posList, PPD, YOffset));
         return;
     }
 }
 
-void PackPointNestEngine::updatePackPointOneSheet(int sheetID, Piece piece)
+void PackPointNestEngine::updatePackPointOneSheet(int sheetID, const Piece &piece)
 {
     //qDebug() << "";
     //qDebug() << "更新排样点";
@@ -146,11 +112,11 @@ void PackPointNestEngine::updatePackPointOneSheet(int sheetID, Piece piece)
     getRectBoundValue(minBoundingRect, minX, minY, maxX, maxY);
 
     // 获取该材料的排样点状态
-    PackPointInfo &info = packPointInfoList[sheetID];
-    int columns = info.columns;
-    qreal XOffset = info.XOffset;
-    qreal YOffset = info.YOffset;
-    QVector<qreal> colList = info.columnPosList;
+    PackPointGrid &grid = sheetPackPointGridMap[sheetID];
+    int columns = grid.getColumns();
+    qreal XOffset = grid.getXOffset();
+    qreal YOffset = grid.getYOffset();
+    const QVector<qreal> &colList = grid.getColumnPosList();
 
     // 获取边界范围内排样点的序号
     int minRow, maxRow, minColumn, maxColumn;
@@ -179,34 +145,42 @@ void PackPointNestEngine::updatePackPointOneSheet(int sheetID, Piece piece)
     //qDebug() << "minColumn: " << minColumn;
     //qDebug() << "maxRow: " << maxRow;
     //qDebug() << "maxColumn: " << maxColumn;
-    // 记录多边形可能覆盖的排样点
-    //qDebug() << "多边形可能覆盖的排样点";
-    QList<int> packPointsList;
+    minRow = qMax(minRow, 0);
+    maxRow = qMin(maxRow, grid.getRows() - 1);
+    minColumn = qMax(minColumn, 0);
+    maxColumn = qMin(maxColumn, columns - 1);
+
+    // 逐行求扫描线与多边形相交的区间，区间内的排样点即被覆盖的排样点
+    int count = 0;
     for(int row=minRow; row<=maxRow; row++){
-        for(int column=minColumn; column<=maxColumn; column++){
-            int packPointID = row * columns + column;
-            packPointsList.append(packPointID);
-            //qDebug() << packPointID;
+        if(grid.getRowUncoveredCount(row) == 0){  // 该行已全部覆盖
+            continue;
         }
-    }
-    //qDebug() << "长度为：" << packPointsList.length();
-    // debug
-    int count = 0;
-    // 判断这些可疑点是否被覆盖，及更新剩余排样点
-    QMap<int, PackPoint> &packPointMap = sheetPackPointPositionMap[sheetID];  // 获取该材料的排样点状态
-    foreach(int id, packPointsList){
-        QPointF point = packPointMap[id].position;
-        //qDebug() << "排样点 #" << id << ", pos: " << point;
-        if(piece.hasRelationToPoint(point)){
-            count++;
-            packPointMap[id].coverd = true;
-            info.coverdList.append(id);
-            unusedSheetPackPointMap[sheetID].removeOne(id);
+        qreal py = row * PPD + YOffset;
+        QVector<QPair<qreal, qreal>> intervalList = piece.scanlineIntervals(py);
+        for(const auto &interval : intervalList){
+            int first = minColumn;
+            int last = maxColumn;
+            if(colList.length() < 1){  // 排样点等间距，只检查区间附近的列
+                first = qMax(first, qFloor((interval.first - XOffset) / PPD));
+                last = qMin(last, qCeil((interval.second - XOffset) / PPD));
+            }
+            for(int column=first; column<=last; column++){
+                int packPointID = row * columns + column;
+                if(grid.isCovered(packPointID)){
+                    continue;
+                }
+                qreal px = pointPrecision(grid.position(packPointID), piece.getPrecision()).x();
+                if(px < interval.first || px > interval.second){
+                    continue;
+                }
+                grid.setCovered(packPointID);
+                count++;
+            }
         }
     }
     //qDebug() << "真正覆盖的点长度为： " << count;
-    //qDebug() << "更新后覆盖点列表的长度： " << packPointInfoList[sheetID].coverdList.length();
-    //qDebug() << "更新后未使用的排样点： " << unusedSheetPackPointMap[sheetID].length();
+    //qDebug() << "更新后未使用的排样点： " << grid.getUncoveredCount();
 }
 
 void PackPointNestEngine::packPieces(QVector<int> indexList)
@@ -250,6 +224,9 @@ void PackPointNestEngine::packPieces(QVector<int> indexList)
         }
     }
     counter += nestedPieceIndexlist.length();
+#ifdef COLLISIONSTATISTICS
+    qDebug() << "被占用栅格排除的候选位置：" << rasterRejectCount;
+#endif
 
     int remainNum = unnestedPieceIndexlist.length();  // 剩余个数
     // 如果没有剩余零件，则排版结束
@@ -276,7 +253,7 @@ void PackPointNestEngine::packPieces(QVector<int> indexList)
     packPieces(unnestedPieceIndexlist);  // 进行排版
 }
 
-bool PackPointNestEngine::packOnePiece(Piece piece, NestEngine::NestPiece &nestPiece)
+bool PackPointNestEngine::packOnePiece(const Piece &piece, NestEngine::NestPiece &nestPiece)
 {
     /***
      * 将零件排至第i张材料上，
@@ -303,19 +280,23 @@ bool PackPointNestEngine::packOnePiece(Piece piece, NestEngine::NestPiece &nestP
     return false;
 }
 
-bool PackPointNestEngine::packOnePieceOnSheet(Piece piece, int sheetID, NestEngine::NestPiece &nestPiece)
+bool PackPointNestEngine::packOnePieceOnSheet(const Piece &piece, int sheetID, NestEngine::NestPiece &nestPiece)
 {
     /***
-     * 尝试排放该零件
+     * 优先尝试排入已排零件的内孔，
+     * 内孔中放不下时再尝试排放该零件
      */
-    bool nestRet = packOnePieceAttempt(piece, sheetID, nestPiece, unusedSheetPackPointMap[sheetID], maxRotateAngle, RN);
+    bool nestRet = partInPart && packOnePieceInHoles(sheetID, nestPiece, RN, PPD);
+    if(!nestRet){
+        nestRet = packOnePieceAttempt(piece, sheetID, nestPiece, maxRotateAngle, RN);
+    }
     /***
      * 如果零件没有排入，最大的可能是在尾行处，
      * 此时如果开启了尾行优化，则允许任意角度排入
      */
     if(!nestRet && (mixingTyes & NestEngine::TailLineMixing) == NestEngine::TailLineMixing){
         qDebug() << "尾行优化";
-        nestRet = packOnePieceAttempt(piece, sheetID, nestPiece, unusedSheetPackPointMap[sheetID], 360, 36);
+        nestRet = packOnePieceAttempt(piece, sheetID, nestPiece, 360, 36);
     }
 
     /***
@@ -325,10 +306,15 @@ bool PackPointNestEngine::packOnePieceOnSheet(Piece piece, int sheetID, NestEngi
      * 然后继续循环，在下一张材料上对目标零件排版
      */
     if(nestRet && compact(sheetID, nestPiece)){  //
-        piece.moveTo(nestPiece.position);
-        piece.rotate(nestPiece.position, nestPiece.alpha);  // 确定此零件的位置
-        //qDebug() << "参考线" << piece.referenceLines[0];
-        updatePackPointOneSheet(sheetID, piece);  // 更新排样点状态
+        Piece nestedPiece = piece;
+        nestedPiece.moveTo(nestPiece.position);
+        nestedPiece.rotate(nestPiece.position, nestPiece.alpha);  // 确定此零件的位置
+        nestedPiece.updateGeometry();  // rotate以moveTo结束，先应用平移量，逐行求扫描线区间时不再平移
+        //qDebug() << "参考线" << nestedPiece.referenceLines[0];
+        updatePackPointOneSheet(sheetID, nestedPiece);  // 更新排样点状态
+        if(collisionsMode == Piece::RasterCollisionMode){
+            updateSheetRaster(sheetID, nestedPiece);  // 更新材料占用栅格
+        }
         if(!nestSheetPieceMap.contains(sheetID)){  // 更新材料-零件索引
             QVector<int> pieceIDList;
             pieceIDList.append(nestPiece.index);
@@ -336,9 +322,10 @@ bool PackPointNestEngine::packOnePieceOnSheet(Piece piece, int sheetID, NestEngi
         nestSheetPieceMap[sheetID].append(nestPiece.index);
 
         // 将该对象加入四叉树中
-        Object *obj = new Object(nestPiece.index, piece.getBoundingRect());
+        Object *obj = new Object(nestPiece.index, nestedPiece.getBoundingRect());
         QuadTreeNode<Object> *quadTree = quadTreeMap[sheetID];
         quadTree->insert(obj);
+        insertNestedHoles(sheetID, nestPiece.index, nestedPiece);  // 内孔加入内孔四叉树
 #ifndef DEBUG
         std::list<QLineF* > lineList = quadTree->getMiddleAxis();
         qDebug() << "分界线";
@@ -347,7 +334,7 @@ bool PackPointNestEngine::packOnePieceOnSheet(Piece piece, int sheetID, NestEngi
         }
 #endif
         qDebug() << "加入四叉树：ID："<< nestPiece.index;
-        qDebug() << "包络矩形：" << piece.getBoundingRect();
+        qDebug() << "包络矩形：" << nestedPiece.getBoundingRect();
         qDebug() << "排放位置: " << nestPiece.position;
         qDebug() << "旋转度数：" << nestPiece.alpha;
         qDebug() << "";
@@ -359,10 +346,10 @@ bool PackPointNestEngine::packOnePieceOnSheet(Piece piece, int sheetID, NestEngi
 
 /***
  * 优化方案：
- * 1. 只访问可排排样点
+ * 1. 只访问可排排样点，由覆盖位图逐个查找未覆盖的排样点
  * 2. 界定上界，即第一个可排位置确定时，确定有效排样点
  */
-bool PackPointNestEngine::packOnePieceAttempt(Piece piece, int sheetID, NestEngine::NestPiece &nestPiece, QList<int> packPointList, int maxRotateAngle, int RN)
+bool PackPointNestEngine::packOnePieceAttempt(const Piece &piece, int sheetID, NestEngine::NestPiece &nestPiece, int maxRotateAngle, int RN)
 {
     qDebug() << "排放零件:#" << nestPiece.index << ", 材料类型: " << nestPiece.typeID;
     //qDebug() << "材料ID：" << sheetID;
@@ -370,19 +357,19 @@ bool PackPointNestEngine::packOnePieceAttempt(Piece piece, int sheetID, NestEngi
         return false;
     }
     minHeight = sheetList[sheetID].height;  // 初始化最小高度
-    QMap<int, PackPoint> packPointMap = sheetPackPointPositionMap[sheetID];  // 获取该材料的排样点状态
+    const PackPointGrid &grid = sheetPackPointGridMap[sheetID];  // 获取该材料的排样点状态，排放过程中不变
 
     int maxPackPointIndex = pieceMaxPackPointMap[nestPiece.typeID];  //  之前的排样点最大值
     if(nestPiece.typeID >= 1 && pieceMaxPackPointMap[nestPiece.typeID] == 0){
         maxPackPointIndex = pieceMaxPackPointMap[nestPiece.typeID-1];
     }
     int maxPackPointIndexTemp = maxPackPointIndex;  // 用该值记录排样点最大值
-    qDebug() << "最大排样点为：" << maxPackPointIndexTemp << packPointMap[maxPackPointIndexTemp].position;
+    if(maxPackPointIndexTemp < grid.count()){
+        qDebug() << "最大排样点为：" << maxPackPointIndexTemp << grid.position(maxPackPointIndexTemp);
+    }
 
-    PackPointInfo info = packPointInfoList[sheetID];  // 获取该材料的排样点状态
-    int rows = info.rows;
-    int columns = info.columns;
-    int PPN =  rows * columns;
+    int columns = grid.getColumns();
+    int PPN = grid.count();
     int upperIndex = PPN;  // 上界
     bool upperFlag = false;  // 上界已设置标志
     qreal nestPieceAngle = nestPiece.alpha;
@@ -390,12 +377,17 @@ bool PackPointNestEngine::packOnePieceAttempt(Piece piece, int sheetID, NestEngi
     if(nestEngineStrategys == NestEngine::ReferenceLine){
         nestPieceAngle  = nestPiece.alpha;
     }*/
-    foreach(int j, packPointList){
-        // 如果未设置尾只混合方式，则需要从该种零件最大的排样点去排
-        if(((mixingTyes & NestEngine::TailPieceMixing) == NestEngine::NoMixing) && j < maxPackPointIndexTemp){
-            //qDebug() << "从最大的排样点出发去排";
-            continue;
+    // 每个旋转角度的零件取自旋转零件缓存，排样点之间只需平移，平移时不逐点计算
+    QVector<Piece> rotatedPieceList;
+    if(nestEngineStrategys != ReferenceLine){
+        for(int k=0; k<=RN; k++){
+            qreal alpha = RN == 0 ? nestPieceAngle : maxRotateAngle * k / RN + nestPieceAngle;
+            rotatedPieceList.append(getRotatedPiece(nestPiece.typeID, alpha));
         }
+    }
+    // 如果未设置尾只混合方式，则需要从该种零件最大的排样点去排
+    int firstIndex = ((mixingTyes & NestEngine::TailPieceMixing) == NestEngine::NoMixing) ? maxPackPointIndexTemp : 0;
+    for(int j=grid.nextUncovered(firstIndex); j>=0; j=grid.nextUncovered(j+1)){
         // 如果排样点序号大于上界，则结束
         if(j > upperIndex){
             break;
@@ -408,8 +400,8 @@ bool PackPointNestEngine::packOnePieceAttempt(Piece piece, int sheetID, NestEngi
              * 选择凸点，是一个较好的选择，
              * 现在默认是将最小包络矩形的中心设置为参考点
              */
-            Piece pieceTmp = piece;
-            QPointF pos = packPointMap[j].position;  // 该排样点对应的位置坐标
+            Piece pieceTmp = nestEngineStrategys == ReferenceLine ? piece : rotatedPieceList[k];
+            QPointF pos = grid.position(j);  // 该排样点对应的位置坐标
             qreal alpha;
             if(RN == 0){
                 alpha = nestPieceAngle;  // 如果RN=0，代表不能对该零件进行额外的旋转
@@ -424,8 +416,7 @@ bool PackPointNestEngine::packOnePieceAttempt(Piece piece, int sheetID, NestEngi
                 pieceTmp.rotateByReferenceLine(pos, (column % 2==0));
                 //qDebug() << pieceTmp.getReferenceLinesList()[0];
             } else{
-                pieceTmp.moveTo(pos);  // 将零件最小包络矩形中心移至该位置
-                pieceTmp.rotate(pos, alpha);  // 绕参考点旋转alpha度
+                pieceTmp.moveTo(pos);  // 将旋转后的零件外包矩形中心移至该位置
             }
             qreal height = pieceTmp.getCenterPoint().ry();  // 得到零件形心
             //qDebug() << "尝试位置: #" << j << " - " << pieceTmp.getBoundingRect().center();
@@ -444,7 +435,12 @@ bool PackPointNestEngine::packOnePieceAttempt(Piece piece, int sheetID, NestEngi
             if(!pieceTmp.containsInSheet(sheetList[sheetID])){
                 continue;
             }
-            if(collidesWithOtherPieces(sheetID, pieceTmp)){
+            // 占用栅格粗判，只有未被排除的候选位置才进行精确检测
+            if(collisionsMode == Piece::RasterCollisionMode && nestEngineStrategys != ReferenceLine
+                    && collidesWithSheetRaster(sheetID, nestPiece.typeID, alpha, pieceTmp.getPosition())){
+                continue;
+            }
+            if(collidesWithNestedPieces(sheetID, pieceTmp, nestPiece.typeID, alpha, pieceTmp.getPosition())){
                 continue;
             }
             if(qrealPrecision(height, PRECISION) < qrealPrecision(minHeight, PRECISION)){
@@ -501,7 +497,8 @@ bool PackPointNestEngine::packOnePieceAttempt(Piece piece, int sheetID, NestEngi
  * @param nestPiece
  * @return
  * 靠接时优先进行重力方向上的靠接，
- * 然后再进行与重力方向垂直的方向上进行靠接
+ * 然后再进行与重力方向垂直的方向上进行靠接，
+ * 每个方向的靠接距离由compactDistance一次求出
  */
 bool PackPointNestEngine::compact(int sheetID, NestEngine::NestPiece &nestPiece)
 {
@@ -512,61 +509,18 @@ bool PackPointNestEngine::compact(int sheetID, NestEngine::NestPiece &nestPiece)
     piece.rotate(pos, nestPiece.alpha);  // 旋转
     //qDebug() << "原始位置：" << pos;
     // 重力方向靠接
-    qreal stepY = compactStep;
-    while(stepY > compactAccuracy){
-        QPointF posTemp = pos;
-        QPointF forwardPos(posTemp.rx(), posTemp.ry()-stepY);  // 重力反方向移动
-        //qDebug() << "移动至：" << forwardPos;
-        piece.moveTo(forwardPos);  // 将零件移至前进位置
-        if(!piece.containsInSheet(sheetList[sheetID])){
-            //qDebug() << "超出材料范围";
-            stepY /= 2;
-            continue;
-        } else{
-            //qDebug() << "包含在材料内";
-        }
-        //qDebug() << "零件 *" << nestPiece.index << " 位置： " << piece.getBoundingRect().center() << " 旋转：" << nestPiece.alpha;
-        if(collidesWithOtherPieces(sheetID, piece)){
-            // 往右移
-            //qDebug() << "碰撞";
-            stepY /= 2;
-            continue;
-        } else{
-            //qDebug() << "没有碰撞";
-        }
-        pos.setY(pos.ry() - stepY);
-    }
+    pos.ry() -= compactDistance(sheetID, piece, QPointF(0, -1));
     //qDebug() << "重力方向靠接后的位置：" << pos;
 
     // 如果是参考线排版，则不再进行水平方向的靠接
     if(nestEngineStrategys == ReferenceLine){
+        nestPiece.position = pos;
         return true;
     }
 
     // 水平方向靠接
-    qreal stepX = compactStep;
-    while(stepX > compactAccuracy){
-        QPointF posTemp = pos;
-        QPointF forwardPos(posTemp.rx()-stepX, posTemp.ry());  // 水平方向移动
-        //qDebug() << "移动至：" << forwardPos;
-        piece.moveTo(forwardPos);  // 将零件移至新位置
-        if(!piece.containsInSheet(sheetList[sheetID])){
-            //qDebug() << "超出材料范围";
-            stepX /= 2;
-            continue;
-        } else{
-            //qDebug() << "包含在材料内";
-        }
-        //qDebug() << "零件 *" << nestPiece.index << " 位置： " << nestPiece.position << " 旋转：" << nestPiece.alpha;
-        if(collidesWithOtherPieces(sheetID, piece)){
-            //qDebug() << "碰撞";
-            stepX /= 2;
-            continue;
-        } else{
-            //qDebug() << "没有碰撞";
-        }
-        pos.setX(pos.rx() - stepX);
-    }
+    piece.moveTo(pos);
+    pos.rx() -= compactDistance(sheetID, piece, QPointF(-1, 0));
     //qDebug() << "水平方向靠接后的位置：" << pos;
     //qDebug() << "";
 
@@ -577,127 +531,160 @@ bool PackPointNestEngine::compact(int sheetID, NestEngine::NestPiece &nestPiece)
      * 这种情况往往发生在行尾，因此针对这种情况进行优化。
      *
      * 优化方案：
-     * 将材料视图向右上方移动
+     * 零件每次向右移动一个靠接步长，再沿重力方向靠接，直到无法继续移动
      */
     if(minHeightOpt && pos.rx() >= 0.8 * sheetList[sheetID].width){
         qreal maxX = pos.rx() + piece.getBoundingRect().width();  // 右移的最大值
-        qreal maxY = pos.ry() + piece.getBoundingRect().height();  // 上移的最大值
-        while(pos.rx() <= maxX && pos.ry() <= maxY){
-            bool moveFlag = false;  // 移动标志
-            stepX = compactStep;  // 设置移动步长
-            QPointF posTemp1 = pos;
-            while(stepX > compactAccuracy) {
-                QPointF forwardPos1(posTemp1.rx()+stepX, posTemp1.ry());  // 向右移动
-                qDebug() << "移动至：" << forwardPos1;
-                piece.moveTo(forwardPos1);  // 将零件移至新位置
-                if(!piece.containsInSheet(sheetList[sheetID])){
-                    qDebug() << "超出材料范围";
-                    stepX /= 2;
-                    continue;
-                } else{
-                    qDebug() << "包含在材料内";
-                }
-                //qDebug() << "零件 *" << nestPiece.index << " 位置： " << nestPiece.position << " 旋转：" << nestPiece.alpha;
-                if(collidesWithOtherPieces(sheetID, piece)){
-                    qDebug() << "碰撞";
-                    stepX /= 2;
-                    continue;
-                } else{
-                    qDebug() << "没有碰撞";
-                }
-                posTemp1.setX(posTemp1.rx() + stepX);  // 记录新的坐标
-
-                stepY = compactStep;  // 设置步长
-                while(stepY > compactAccuracy){
-                    QPointF posTemp2 = posTemp1;
-                    QPointF forwardPos2(posTemp2.rx(), posTemp2.ry()-stepY);
-                    qDebug() << "移动至：" << forwardPos2;
-                    piece.moveTo(forwardPos2);  // 将零件移至新位置2
-                    if(!piece.containsInSheet(sheetList[sheetID])){
-                        qDebug() << "超出材料范围";
-                        stepY /= 2;
-                        continue;
-                    } else{
-                        qDebug() << "包含在材料内";
-                    }
-                    //qDebug() << "零件 *" << nestPiece.index << " 位置： " << nestPiece.position << " 旋转：" << nestPiece.alpha;
-                    if(collidesWithOtherPieces(sheetID, piece)){
-                        qDebug() << "碰撞";
-                        stepY /= 2;
-                        continue;
-                    } else{
-                        qDebug() << "没有碰撞";
-                    }
-                    moveFlag = true;  // 更新移动标志
-                    posTemp1.setY(posTemp1.ry() - stepY);
-                }
+        while(pos.rx() <= maxX){
+            piece.moveTo(pos);
+            qreal stepX = qMin(compactStep, compactDistance(sheetID, piece, QPointF(1, 0)));  // 向右移动，不超出材料范围、不碰撞
+            if(stepX < compactAccuracy){
+                break;
             }
-            if(!moveFlag){  // 如果无法继续移动，则结束
-                qDebug() << "无法移动";
+            QPointF posTemp = pos + QPointF(stepX, 0);
+            piece.moveTo(posTemp);
+            qreal stepY = compactDistance(sheetID, piece, QPointF(0, -1));
+            if(stepY < compactAccuracy){  // 如果无法继续移动，则结束
                 break;
             }
-            // 更新位置
-            pos = posTemp1;
-            qDebug() << "新的pos: " << pos;
+            pos = posTemp - QPointF(0, stepY);  // 更新位置
         }
-        qDebug() << "向右上方靠接后的位置：" << pos;
+        //qDebug() << "向右上方靠接后的位置：" << pos;
         // 水平方向靠接
-        stepX = compactStep;
-        while(stepX > compactAccuracy){
-            QPointF posTemp = pos;
-            QPointF forwardPos(posTemp.rx()-stepX, posTemp.ry());  // 水平方向移动
-            //qDebug() << "移动至：" << forwardPos;
-            piece.moveTo(forwardPos);  // 将零件移至新位置
-            if(!piece.containsInSheet(sheetList[sheetID])){
-                //qDebug() << "超出材料范围";
-                stepX /= 2;
-                continue;
-            } else{
-                //qDebug() << "包含在材料内";
-            }
-            //qDebug() << "零件 *" << nestPiece.index << " 位置： " << nestPiece.position << " 旋转：" << nestPiece.alpha;
-            if(collidesWithOtherPieces(sheetID, piece)){
-                //qDebug() << "碰撞";
-                stepX /= 2;
-                continue;
-            } else{
-                //qDebug() << "没有碰撞";
-            }
-            pos.setX(pos.rx() - stepX);
-        }
+        piece.moveTo(pos);
+        pos.rx() -= compactDistance(sheetID, piece, QPointF(-1, 0));
         //qDebug() << "水平方向靠接后的位置：" << pos;
     }
     nestPiece.position = pos;
     return true;
 }
 
-bool PackPointNestEngine::collidesWithOtherPieces(int sheetID, Piece piece)
+/**
+ * @brief PackPointNestEngine::compactDistance
+ * 零件沿direction方向平移至与已排零件接触(距离为零件间距)或到达材料边缘的距离，
+ * 与ContinueNestEngine的靠接一样由slideDistance一次求出，不再按步长试探
+ * @param sheetID 材料ID
+ * @param piece 已移动、旋转至当前位置的零件
+ * @param direction 平移方向，水平或竖直的单位向量
+ * @return 平移距离，当前位置已碰撞时返回0
+ */
+qreal PackPointNestEngine::compactDistance(int sheetID, const Piece &piece, const QPointF &direction)
 {
-    // 判断两两零件是否碰撞, 优化方案：使用四叉树进行管理
-    //qDebug() << "与对象: " << piece.getBoundingRect() << " 在同一象限的对象：";
-    std::list<Object *> resObjects =
-            quadTreeMap[sheetID]->retrieve(new Object(piece.getBoundingRect()));
-    for(auto &t:resObjects){
-        //qDebug()<< t->id << ' ' << t->x<<' '<<t->y<<' '<<t->width<<' '<<t->height;
-        int id = t->id;
-        int typeID = nestPieceList[id].typeID;
-        Piece pieceNested = pieceList[typeID];
-        pieceNested.moveTo(nestPieceList[id].position);
-        pieceNested.rotate(nestPieceList[id].position, nestPieceList[id].alpha);
-        if(pieceNested.collidesWithPiece(piece)){
-            //qDebug() << "与 &" << nestPieceList[i].index << "，位置：" << nestPieceList[i].position;
-            //qDebug() << "";
-            return true;
-        }
-        collisionCount++;
+    QRectF rect = piece.getBoundingRect();
+    QRectF layoutRect = sheetList[sheetID].layoutRect();
+    qreal maxStep;  // 不超出材料范围
+    if(direction.x() < 0){
+        maxStep = rect.left() - layoutRect.left();
+    } else if(direction.x() > 0){
+        maxStep = layoutRect.right() - rect.right();
+    } else if(direction.y() < 0){
+        maxStep = rect.top() - layoutRect.top();
+    } else{
+        maxStep = layoutRect.bottom() - rect.bottom();
     }
-    //qDebug() << "";
-    return false;
+    if(maxStep <= 0 || collidesWithOtherPieces(sheetID, piece)){
+        return 0;
+    }
+    QRectF sweepRect = rect.united(rect.translated(direction * maxStep));  // 零件平移时扫过的区域
+    return qMin(slideDistanceToOtherPieces(sheetID, piece, direction, sweepRect), maxStep);
 }
 
+bool PackPointNestEngine::collidesWithOtherPieces(int sheetID, const Piece &piece)
+{
+    // 判断两两零件是否碰撞, 使用四叉树进行管理，已排零件使用缓存的形状批量检测
+    return collidesWithNestedPieceList(sheetID, piece);
+}
 
+/**
+ * @brief PackPointNestEngine::setCollisionsMode
+ * 候选位置的粗判方式，默认按包络矩形。占用栅格(RasterCollisionMode)需由调用者显式开启，
+ * 目前界面使用的ContinueNestEngine不经过排样点粗判，Nest不会设置此项
+ * @param mode
+ */
+void PackPointNestEngine::setCollisionsMode(Piece::CollisionsMode mode)
+{
+    collisionsMode = mode;
+}
 
+Piece::CollisionsMode PackPointNestEngine::getCollisionsMode() const
+{
+    return collisionsMode;
+}
+
+void PackPointNestEngine::setRasterResolution(qreal resolution)
+{
+    if(resolution <= 0 || resolution == rasterResolution){
+        return;
+    }
+    rasterResolution = resolution;
+    // 栅格边长改变后，已有栅格全部失效
+    sheetRasterMap.clear();
+    pieceRasterMap.clear();
+}
 
+qreal PackPointNestEngine::getRasterResolution() const
+{
+    return rasterResolution;
+}
 
+/**
+ * @brief PackPointNestEngine::getPieceRaster
+ * 零件移至原点、旋转alpha度之后栅格化，与排版时moveTo、rotate的方式一致，
+ * 每种零件的每个角度只计算一次
+ * @param typeID 零件类型
+ * @param alpha 旋转角度
+ * @return
+ */
+const OccupancyRaster &PackPointNestEngine::getPieceRaster(int typeID, qreal alpha)
+{
+    QPair<int, int> key(typeID, NoFitPolygonCache::quantizeAngle(alpha));
+    if(!pieceRasterMap.contains(key)){
+        Piece piece = getRotatedPiece(typeID, alpha);
+        qreal margin = qPow(10, 3 - piece.getPrecision());  // 抵消坐标取位误差
+        pieceRasterMap.insert(key, OccupancyRaster::fromPolygon(piece.getCollisionLoopsList(), rasterResolution, margin));
+    }
+    return pieceRasterMap[key];
+}
 
+/**
+ * @brief PackPointNestEngine::updateSheetRaster
+ * 标记被已排零件完全覆盖的材料栅格，内孔中的栅格不标记，仍可排放零件
+ * @param sheetID 材料ID
+ * @param piece 已移动、旋转至排放位置的零件
+ */
+void PackPointNestEngine::updateSheetRaster(int sheetID, const Piece &piece)
+{
+    QRectF layoutRect = sheetList[sheetID].layoutRect();
+    if(!sheetRasterMap.contains(sheetID)){
+        sheetRasterMap.insert(sheetID, OccupancyRaster(qCeil(layoutRect.width() / rasterResolution),
+                                                       qCeil(layoutRect.height() / rasterResolution)));
+    }
+    qreal margin = qPow(10, 3 - piece.getPrecision());
+    sheetRasterMap[sheetID].fillPolygon(piece.getCollisionLoopsList(), layoutRect.topLeft(), rasterResolution, 1, margin);
+}
 
+/**
+ * @brief PackPointNestEngine::collidesWithSheetRaster
+ * 零件参考点落在材料第(k, l)个栅格内时，零件栅格整体偏移(k, l)，
+ * 与材料占用栅格逐行按字相与，有共同标记时一定碰撞
+ * @param sheetID 材料ID
+ * @param typeID 零件类型
+ * @param alpha 旋转角度
+ * @param pos 零件参考点位置
+ * @return
+ */
+bool PackPointNestEngine::collidesWithSheetRaster(int sheetID, int typeID, qreal alpha, const QPointF &pos)
+{
+    if(!sheetRasterMap.contains(sheetID)){
+        return false;
+    }
+    const OccupancyRaster &pieceRaster = getPieceRaster(typeID, alpha);
+    QPointF origin = sheetList[sheetID].layoutRect().topLeft();
+    int k = qFloor((pos.x() - origin.x()) / rasterResolution);
+    int l = qFloor((pos.y() - origin.y()) / rasterResolution);
+    if(sheetRasterMap[sheetID].overlaps(pieceRaster, pieceRaster.getOriginColumn() + k, pieceRaster.getOriginRow() + l)){
+        rasterRejectCount++;
+        return true;
+    }
+    return false;
+}
@@ -1,8 +1,78 @@
 ﻿#include "piece.h"
+#include <algorithm>
+#include <limits>
+
+QAtomicInt Piece::partPairTestCount;
+QAtomicInt Piece::partPairCulledCount;
+
+/**
+ * @brief roundedPoint 坐标取整到定点网格，或保留precision位小数位
+ */
+static QPointF roundedPoint(const QPointF &point, short precision)
+{
+#ifdef FIXEDPOINTGEOMETRY
+    Q_UNUSED(precision);
+    return toPointF(toFixedPoint(point));
+#else
+    return pointPrecision(point, precision);
+#endif
+}
+
+/**
+ * @brief pointToSegmentDistance 点到线段的距离
+ */
+static qreal pointToSegmentDistance(const QPointF &point, const QPointF &a, const QPointF &b)
+{
+    QPointF ab = b - a;
+    QPointF ap = point - a;
+    qreal len2 = ab.x() * ab.x() + ab.y() * ab.y();
+    qreal t = len2 == 0 ? 0 : qBound(qreal(0), (ap.x() * ab.x() + ap.y() * ab.y()) / len2, qreal(1));
+    QPointF d = ap - t * ab;
+    return qSqrt(d.x() * d.x() + d.y() * d.y());
+}
+
+/**
+ * @brief segmentsCross 两线段在内部相交，端点接触、共线重叠不算相交，与分离轴检测中接触不算碰撞一致
+ */
+static bool segmentsCross(const QPointF &p1, const QPointF &p2, const QPointF &q1, const QPointF &q2, qreal epsilon)
+{
+    QPointF p = p2 - p1;
+    QPointF q = q2 - q1;
+    qreal epsilonP = epsilon * qSqrt(p.x() * p.x() + p.y() * p.y());
+    qreal epsilonQ = epsilon * qSqrt(q.x() * q.x() + q.y() * q.y());
+    qreal d1 = q.x() * (p1.y() - q1.y()) - q.y() * (p1.x() - q1.x());
+    qreal d2 = q.x() * (p2.y() - q1.y()) - q.y() * (p2.x() - q1.x());
+    qreal d3 = p.x() * (q1.y() - p1.y()) - p.y() * (q1.x() - p1.x());
+    qreal d4 = p.x() * (q2.y() - p1.y()) - p.y() * (q2.x() - p1.x());
+    return ((d1 > epsilonQ && d2 < -epsilonQ) || (d1 < -epsilonQ && d2 > epsilonQ))
+            && ((d3 > epsilonP && d4 < -epsilonP) || (d3 < -epsilonP && d4 > epsilonP));
+}
+
+/**
+ * @brief pointInsideLoop 点在环的内部，或离环的边不超过epsilon
+ */
+static bool pointInsideLoop(const QVector<QPointF> &loop, const QPointF &point, qreal epsilon)
+{
+    bool inside = false;
+    int len = loop.length();
+    for(int i=0, j=len-1; i<len; j=i++){
+        const QPointF &a = loop[i];
+        const QPointF &b = loop[j];
+        if(pointToSegmentDistance(point, a, b) <= epsilon){
+            return true;
+        }
+        if((a.y() > point.y()) != (b.y() > point.y())
+                && point.x() < (b.x() - a.x()) * (point.y() - a.y()) / (b.y() - a.y()) + a.x()){
+            inside = !inside;
+        }
+    }
+    return inside;
+}
 
 Piece::Piece() :
     pairType(None),
-    pointsList(QVector<QPointF>()),
+    geometry(new PieceGeometry),
+    collisionMargin(0),
     area(0),
     minBoundingRect(QRectF()),
     boundingRect(QRectF()),
@@ -17,22 +87,28 @@ Piece::Piece() :
 
 Piece::Piece(Polyline *p, int n, short i) :
     pairType(None),
+    geometry(new PieceGeometry),
+    collisionMargin(0),
     transpose(false)
 {
     QVector<QPointF> points = p->getPoints();
     if(points.length() < 3){
         return;
     }
-    pointsList = pointsListPrecision(points, i);  // 读入边时，保留i位小数位
+    geometry->pointsList = pointsListPrecision(points, i);  // 读入边时，保留i位小数位
+#ifdef FIXEDPOINTGEOMETRY
+    snapToFixedPoints(geometry->pointsList, geometry->fixedPointsList);  // 取整到定点网格
+#endif
     // referenceLine = linesListPrecision(p->getReferenceLines(), i);  // 读入参考线
-    area = calculatePolygonArea(pointsList);  // 计算多边形面积
-    qreal minBoundingRectArea = calculatePloygonMinBoundingRectArea(pointsList, angle, minBoundingRect);
+    area = calculatePolygonArea(geometry->pointsList);  // 计算多边形面积
+    qreal minBoundingRectArea = calculatePloygonMinBoundingRectArea(geometry->pointsList, angle, minBoundingRect);
     minBoundingRect = rectPrecision(minBoundingRect, i);  // 最小矩形，保留i位小数位
-    boundingRect = rectPrecision(calculatePolygonBoundingRect(pointsList), i);  // 计算包络矩形，保留i位小数
+    boundingRect = rectPrecision(calculatePolygonBoundingRect(geometry->pointsList), i);  // 计算包络矩形，保留i位小数
     squareness = qrealPrecision(area / minBoundingRectArea, i);  // 计算方正度，保留i位小数位
-    centerPoint = pointPrecision(calculatePolygonGravityCenter(pointsList), i); // 计算多边形的质心，保留i位小数位
+    centerPoint = pointPrecision(calculatePolygonGravityCenter(geometry->pointsList), i); // 计算多边形的质心，保留i位小数位
     count = n;
     precision = i;
+    initConvexParts();  // 凸多边形分解
 }
 
 Piece::Piece(Polyline *p, QVector<QLineF> lines, int n, short i) :
@@ -56,25 +132,31 @@ Piece::Piece(Polyline *p, QVector<QLineF> lines, int n, short i) :
     }
 #endif
 
-    referenceLines = linesListPrecision(lines, i);
+    geometry->referenceLines = linesListPrecision(lines, i);
 }
 
 Piece::Piece(QVector<QPointF> points, int n, short i) :
     pairType(None),
+    geometry(new PieceGeometry),
+    collisionMargin(0),
     transpose(false)
 {
     if(points.length() < 3){
         return;
     }
-    pointsList = pointsListPrecision(points, i);  // 读入边时，保留i位小数位
-    area = calculatePolygonArea(pointsList);  // 计算多边形面积
-    qreal minBoundingRectArea = calculatePloygonMinBoundingRectArea(pointsList, angle, minBoundingRect);
+    geometry->pointsList = pointsListPrecision(points, i);  // 读入边时，保留i位小数位
+#ifdef FIXEDPOINTGEOMETRY
+    snapToFixedPoints(geometry->pointsList, geometry->fixedPointsList);  // 取整到定点网格
+#endif
+    area = calculatePolygonArea(geometry->pointsList);  // 计算多边形面积
+    qreal minBoundingRectArea = calculatePloygonMinBoundingRectArea(geometry->pointsList, angle, minBoundingRect);
     minBoundingRect = rectPrecision(minBoundingRect, i);  // 边缘矩形，保留i位小数位
-    boundingRect = rectPrecision(calculatePolygonBoundingRect(pointsList), i);  // 计算包络矩形，保留i位小数
+    boundingRect = rectPrecision(calculatePolygonBoundingRect(geometry->pointsList), i);  // 计算包络矩形，保留i位小数
     squareness = qrealPrecision(area / minBoundingRectArea, i);  // 计算方正度，保留i位小数位
-    centerPoint = pointPrecision(calculatePolygonGravityCenter(pointsList), i); // 计算多边形的质心，保留i位小数位
+    centerPoint = pointPrecision(calculatePolygonGravityCenter(geometry->pointsList), i); // 计算多边形的质心，保留i位小数位
     count = n;
     precision = i;
+    initConvexParts();  // 凸多边形分解
 }
 
 Piece::Piece(QVector<QPointF> points, QVector<QLineF> lines, int n, short i) :
@@ -98,13 +180,14 @@ Piece::Piece(QVector<QPointF> points, QVector<QLineF> lines, int n, short i) :
     }
 #endif
 
-    referenceLines = linesListPrecision(lines, i);
+    geometry->referenceLines = linesListPrecision(lines, i);
 }
 
 Polyline *Piece::getPolyline()
 {
+    updateGeometry();
     Polyline *polyline = new Polyline;
-    polyline->setPolyline(pointsList, Polyline::line);
+    polyline->setPolyline(geometry->pointsList, Polyline::line);
     return polyline;
 }
 
@@ -126,19 +209,184 @@ Piece::PairType Piece::getPairType() const
     return this->pairType;
 }
 
-QVector<QPointF> &Piece::getPointsList()
+QVector<QPointF> Piece::getPointsList() const
+{
+    return currentGeometry()->pointsList;
+}
+
+QVector<QVector<QPointF>> Piece::getConvexPartsList() const
+{
+    return currentGeometry()->convexPartsList;
+}
+
+/**
+ * @brief Piece::simplify
+ * 简化碰撞检测用的外轮廓：DXF导入的曲线被离散为大量短边，分离轴检测的耗时与顶点数成正比，
+ * 简化后的外轮廓完全包含原多边形，只用于碰撞检测，pointsList保持不变，输出时仍为精确轮廓
+ * @param tolerance 简化允许误差，外轮廓离原多边形的距离约为1~2倍tolerance
+ * @return 顶点数减少且外轮廓有效时返回true，否则继续使用原多边形
+ */
+bool Piece::simplify(const qreal tolerance)
 {
-    return pointsList;
+    updateGeometry();
+    qreal margin = 0;
+    qreal clearance = 2 * qPow(10.0, -precision);  // 抵消坐标保留precision位小数的误差
+    QVector<QPointF> points = simplifyPolygonConservative(geometry->pointsList, tolerance, margin, clearance);
+    if(points.isEmpty()){
+        return false;
+    }
+    detachGeometry();
+#ifdef FIXEDPOINTGEOMETRY
+    geometry->collisionPointsList = points;
+    snapToFixedPoints(geometry->collisionPointsList, geometry->fixedCollisionPointsList);  // 取整到定点网格
+#else
+    geometry->collisionPointsList = pointsListPrecision(points, precision);  // 保留i位小数位
+#endif
+    collisionMargin = margin + clearance;
+    initConvexParts();  // 按简化轮廓重新分解
+    return true;
+}
+
+/**
+ * @brief Piece::offsetCollisionOutline
+ * 碰撞检测用的外轮廓向外偏移delta，两零件都偏移gap/2后不重叠，即原多边形的距离不小于gap，
+ * 排版引擎按零件类型偏移一次，之后的碰撞检测不必再逐次考虑零件间距
+ * @param delta 偏移量，需大于0
+ * @param polygonOffset 偏移方式，默认为斜接
+ * @return 偏移成功时返回true
+ */
+bool Piece::offsetCollisionOutline(const qreal delta, const PolygonOffset &polygonOffset)
+{
+    if(delta <= 0){
+        return false;
+    }
+    qreal clearance = qPow(10.0, -precision);  // 抵消坐标保留precision位小数的误差
+    QVector<QPointF> points = polygonOffset.outerOutline(getCollisionPointsList(), delta + clearance);
+    if(points.length() < 4){
+        return false;
+    }
+    detachGeometry();
+#ifdef FIXEDPOINTGEOMETRY
+    geometry->collisionPointsList = points;
+    snapToFixedPoints(geometry->collisionPointsList, geometry->fixedCollisionPointsList);  // 取整到定点网格
+#else
+    geometry->collisionPointsList = pointsListPrecision(points, precision);  // 保留i位小数位
+#endif
+    collisionMargin += polygonOffset.maxDeviation(delta + clearance) + clearance;
+    // 内孔向内收缩相同的距离，收缩后可能分裂为多个环或消失
+    QVector<QVector<QPointF>> holesList = geometry->collisionHolesList;
+    geometry->collisionHolesList.clear();
+    for(int i=0; i<holesList.length(); i++){
+        QVector<QVector<QPointF>> loopsList = polygonOffset.execute(holesList[i], -(delta + clearance));
+        for(int j=0; j<loopsList.length(); j++){
+            QVector<QPointF> hole;
+            for(int k=0; k<loopsList[j].length(); k++){
+                QPointF p = roundedPoint(loopsList[j][k], precision);
+                if(hole.isEmpty() || hole.last() != p){  // 取整后相邻点可能重合
+                    hole.append(p);
+                }
+            }
+            while(hole.length() > 1 && hole.last() == hole.first()){
+                hole.removeLast();
+            }
+            if(hole.length() < 3){  // 取整后退化为点或线段，不能容纳零件
+                continue;
+            }
+            hole.append(hole.first());
+            if(calculatePolygonArea(hole) <= 0){
+                continue;
+            }
+            geometry->collisionHolesList.append(hole);
+        }
+    }
+    initHoleBounds();
+    initConvexParts();  // 按偏移后的轮廓重新分解
+    return true;
+}
+
+QVector<QPointF> Piece::getCollisionPointsList() const
+{
+    QExplicitlySharedDataPointer<PieceGeometry> current = currentGeometry();
+    return current->collisionPointsList.isEmpty() ? current->pointsList : current->collisionPointsList;
+}
+
+qreal Piece::getCollisionMargin() const
+{
+    return collisionMargin;
+}
+
+QRectF Piece::collisionBoundingRect() const
+{
+    return boundingRect.adjusted(-collisionMargin, -collisionMargin, collisionMargin, collisionMargin);
+}
+
+/**
+ * @brief Piece::setHolesList
+ * 设置零件的内孔，碰撞检测时完全位于内孔中的零件不视为碰撞。
+ * 需在offsetCollisionOutline之前设置，偏移时内孔随外轮廓一起收缩
+ * @param holes 内孔点集
+ */
+void Piece::setHolesList(const QVector<QVector<QPointF>> &holes)
+{
+    updateGeometry();
+    detachGeometry();
+    geometry->holesList.clear();
+    area = calculatePolygonArea(geometry->pointsList);
+    for(int i=0; i<holes.length(); i++){
+        if(holes[i].length() < 3){
+            continue;
+        }
+        QVector<QPointF> hole;
+        for(int j=0; j<holes[i].length(); j++){
+            hole.append(roundedPoint(holes[i][j], precision));
+        }
+        if(hole.first() != hole.last()){
+            hole.append(hole.first());  // 首尾相连
+        }
+        area -= calculatePolygonArea(hole);  // 零件面积减去内孔面积
+        geometry->holesList.append(hole);
+    }
+    geometry->collisionHolesList = geometry->holesList;
+#ifdef FIXEDPOINTGEOMETRY
+    initFixedPoints();
+#endif
+    initHoleBounds();
+}
+
+QVector<QVector<QPointF>> Piece::getHolesList() const
+{
+    return currentGeometry()->holesList;
+}
+
+QVector<QVector<QPointF>> Piece::getCollisionHolesList() const
+{
+    return currentGeometry()->collisionHolesList;
+}
+
+QVector<QVector<QPointF>> Piece::getCollisionLoopsList() const
+{
+    QExplicitlySharedDataPointer<PieceGeometry> current = currentGeometry();
+    QVector<QVector<QPointF>> loopsList;
+    loopsList.append(current->collisionPointsList.isEmpty() ? current->pointsList : current->collisionPointsList);
+    loopsList += current->collisionHolesList;
+    return loopsList;
+}
+
+bool Piece::hasHoles() const
+{
+    return !geometry->collisionHolesList.isEmpty();
 }
 
 void Piece::setReferenceLinesList(QVector<QLineF> lines)
 {
-    this->referenceLines = lines;
+    updateGeometry();
+    detachGeometry();
+    geometry->referenceLines = lines;
 }
 
-QVector<QLineF> Piece::getReferenceLinesList()
+QVector<QLineF> Piece::getReferenceLinesList() const
 {
-    return referenceLines;
+    return currentGeometry()->referenceLines;
 }
 
 qreal Piece::getArea() const
@@ -194,13 +442,28 @@ int Piece::getCount() const
 
 QVector<QPointF> Piece::getOffset()
 {
+    updateGeometry();
     QVector<QPointF> offsetList;
-    for(int i=0; i<pointsList.length(); i++){
-        offsetList.append(pointsList[i] - minBoundingRect.center());
+    for(int i=0; i<geometry->pointsList.length(); i++){
+        offsetList.append(geometry->pointsList[i] - minBoundingRect.center());
     }
     return offsetList;
 }
 
+QVector<QVector<QPointF>> Piece::getHolesOffset()
+{
+    updateGeometry();
+    QVector<QVector<QPointF>> holesOffsetList;
+    for(int i=0; i<geometry->holesList.length(); i++){
+        QVector<QPointF> offsetList;
+        for(int j=0; j<geometry->holesList[i].length(); j++){
+            offsetList.append(geometry->holesList[i][j] - minBoundingRect.center());  // 与外轮廓相对同一中心
+        }
+        holesOffsetList.append(offsetList);
+    }
+    return holesOffsetList;
+}
+
 void Piece::setPrecision(const short i)
 {
     precision = i;
@@ -228,38 +491,21 @@ bool Piece::isTranspose() const
 
 QPointF Piece::refLineCenterToMinBoundRectCenter() const
 {
-    return pointPrecision(minBoundingRect.center() - referenceLines[0].center(), precision);
+    return pointPrecision(minBoundingRect.center() - currentGeometry()->referenceLines[0].center(), precision);
 }
 
+/**
+ * @brief Piece::moveTo
+ * 只累计平移量并更新质心与包络矩形，不逐点平移；
+ * 点集、凸多边形分解结果与参考线在下一次使用时由updateGeometry一次性平移。
+ * 排样点之间移动候选零件的开销与顶点数无关
+ * @param position 外包矩形中心的目标位置
+ */
 void Piece::moveTo(const QPointF position)
 {
     QPointF offset = position - getPosition();  // 偏移量
     offset = pointPrecision(offset, precision);  // 保留i位小数位
-
-    // 更新多边形点集
-    QVector<QPointF> oldPointsList = pointsList;  // 多边形点集
-    QVector<QPointF> newPointsList;  // 存储移动之后的点坐标
-    for(int i=0; i<oldPointsList.length(); i++){
-        QPointF oldPoint = oldPointsList[i];  // 初始点
-        QPointF newPoint = oldPoint + offset;  // 移动之后的点
-        newPoint = pointPrecision(newPoint, precision);  // 保留i位小数位
-        newPointsList.append(newPoint);
-    }
-    pointsList = newPointsList;  // 更新点集
-
-    // 更新参考线集
-    QVector<QLineF> oldLinesList = referenceLines;  // 参考线集
-    QVector<QLineF> newLinesList;  // 存储移动之后的线
-    for(int i=0; i<oldLinesList.length(); i++){
-        QLineF oldLine = oldLinesList[i];  // 初始线
-        QLineF newLine(oldLine.p1()+offset, oldLine.p2()+offset);  // 移动之后的线
-        newLine = linePrecision(newLine, precision);  // 保留i位小数位
-        newLinesList.append(newLine);
-    }
-    referenceLines = newLinesList;  // 更新参考线集
-    centerPoint += offset; // 更新多边形质心
-    minBoundingRect.moveCenter(position);  // 更新最小包络矩形
-    boundingRect.moveCenter(position);  // 更新外包矩形
+    deferTranslate(offset, position);
 }
 
 void Piece::rotate(const QPointF cPoint, const qreal alpha)
@@ -268,25 +514,17 @@ void Piece::rotate(const QPointF cPoint, const qreal alpha)
     if(alphaPcs == 0.0f || alphaPcs == 360.0f){
         return;
     }
+    updateGeometry();
 
     bool flag = false;  // 是否关于外包矩形中心点进行旋转
     QPointF cPointPcs = pointPrecision(cPoint, precision);  // 保留i位小数位
     if(cPointPcs == getPosition()){
         flag = true;
     }
-    // 更新多边形点集
-    QVector<QPointF> oldPointsList = pointsList;  // 多边形点集
-    QVector<QPointF> newPointsList;  // 存储移动之后的点坐标
-    for(int i=0; i<oldPointsList.length(); i++){
-        QPointF oldPoint = oldPointsList[i];  // 初始点
-        QPointF newPoint = transformRotate(cPointPcs, oldPoint, alphaPcs);  // 移动之后的点
-        newPoint = pointPrecision(newPoint, precision);  // 保留i位小数位
-        newPointsList.append(newPoint);
-    }
-    pointsList = newPointsList;  // 更新点集
+    rotatePoints(cPointPcs, alphaPcs);  // 更新多边形点集与凸多边形分解结果
 
     // 更新参考线集
-    QVector<QLineF> oldLinesList = referenceLines;  // 参考线集
+    QVector<QLineF> oldLinesList = geometry->referenceLines;  // 参考线集
     QVector<QLineF> newLinesList;  // 存储移动之后的线
     for(int i=0; i<oldLinesList.length(); i++){
         QLineF oldLine = oldLinesList[i];  // 初始线
@@ -299,10 +537,10 @@ void Piece::rotate(const QPointF cPoint, const qreal alpha)
         newLine = linePrecision(newLine, precision);  // 保留i位小数位
         newLinesList.append(newLine);
     }
-    referenceLines = newLinesList;  // 更新参考线集
+    geometry->referenceLines = newLinesList;  // 更新参考线集
 
     centerPoint = transformRotate(cPoint, centerPoint, alpha); // 更新多边形质心
-    boundingRect = rectPrecision(calculatePolygonBoundingRect(pointsList), precision);  // 更新最小包络矩形
+    boundingRect = rectPrecision(calculatePolygonBoundingRect(geometry->pointsList), precision);  // 更新最小包络矩形
     // 如果旋转中心为外包矩形的中心，且旋转之后的外包矩形的中心点与旋转中心点不同，一定要进行再移动，这一步非常关键
     if(flag && boundingRect.center() != cPointPcs){
         moveTo(cPointPcs);
@@ -312,46 +550,25 @@ void Piece::rotate(const QPointF cPoint, const qreal alpha)
 
 void Piece::moveToByReferenceLine(const QPointF position)
 {
-    if(referenceLines.length() == 0){
+    if(geometry->referenceLines.length() == 0){
         qDebug() << "无参考线";
         return;
     }
     // 有多条参考线，这里首先默认第一条
-    QLineF line = linePrecision(referenceLines[0], precision); // 保留i位小数位
+    updateGeometry();
+    QLineF line = linePrecision(geometry->referenceLines[0], precision); // 保留i位小数位
     QPointF offset = position - line.center();  // 偏移量
     offset = pointPrecision(offset, precision);  // 保留i位小数位
-    // 更新多边形点集
-    QVector<QPointF> oldPointsList = pointsList;  // 多边形点集
-    QVector<QPointF> newPointsList;  // 存储移动之后的点坐标
-    for(int i=0; i<oldPointsList.length(); i++){
-        QPointF oldPoint = oldPointsList[i];  // 初始点
-        QPointF newPoint = oldPoint + offset;  // 移动之后的点
-        newPoint = pointPrecision(newPoint, precision);  // 保留i位小数位
-        newPointsList.append(newPoint);
-    }
-    pointsList = newPointsList;  // 更新点集
-
-    // 更新参考线集
-    QVector<QLineF> oldLinesList = referenceLines;  // 参考线集
-    QVector<QLineF> newLinesList;  // 存储移动之后的线
-    for(int i=0; i<oldLinesList.length(); i++){
-        QLineF oldLine = oldLinesList[i];  // 初始线
-        QLineF newLine(oldLine.p1()+offset, oldLine.p2()+offset);  // 移动之后的线
-        newLine = linePrecision(newLine, precision);  // 保留i位小数位
-        newLinesList.append(newLine);
-    }
-    referenceLines = newLinesList;  // 更新参考线集
-    centerPoint += offset; // 更新多边形质心
-    minBoundingRect.moveCenter(position);  // 更新最小包络矩形
-    boundingRect.moveCenter(position);  // 更新外包矩形
+    deferTranslate(offset, position);
 }
 
 void Piece::rotateByReferenceLine(const QPointF cPoint, bool flag)
 {
-    if(referenceLines.length() == 0){
+    if(geometry->referenceLines.length() == 0){
         qDebug() << "无参考线";
         return;
     }
+    updateGeometry();
 
     // 使参考线处于水平方向
     QLineF packLine;
@@ -360,21 +577,12 @@ void Piece::rotateByReferenceLine(const QPointF cPoint, bool flag)
     } else{
         packLine.setLine(0, 0, -10, 0);
     }
-    qreal theta = referenceLines[0].angleTo(packLine);
-    //qDebug() << packLine <<  " " << referenceLines[0] << " 参考线水平角度需旋转" << theta;
-    // 更新多边形点集
-    QVector<QPointF> oldPointsList = pointsList;  // 多边形点集
-    QVector<QPointF> newPointsList;  // 存储移动之后的点坐标
-    for(int i=0; i<oldPointsList.length(); i++){
-        QPointF oldPoint = oldPointsList[i];  // 初始点
-        QPointF newPoint = transformRotate(cPoint, oldPoint, theta);  // 移动之后的点
-        newPoint = pointPrecision(newPoint, precision);  // 保留i位小数位
-        newPointsList.append(newPoint);
-    }
-    pointsList = newPointsList;  // 更新点集
+    qreal theta = geometry->referenceLines[0].angleTo(packLine);
+    //qDebug() << packLine <<  " " << geometry->referenceLines[0] << " 参考线水平角度需旋转" << theta;
+    rotatePoints(cPoint, theta);  // 更新多边形点集与凸多边形分解结果
 
     // 更新参考线集
-    QVector<QLineF> oldLinesList = referenceLines;  // 参考线集
+    QVector<QLineF> oldLinesList = geometry->referenceLines;  // 参考线集
     QVector<QLineF> newLinesList;  // 存储移动之后的线
     for(int i=0; i<oldLinesList.length(); i++){
         QLineF oldLine = oldLinesList[i];  // 初始线
@@ -389,10 +597,10 @@ void Piece::rotateByReferenceLine(const QPointF cPoint, bool flag)
         newLine = linePrecision(newLine, precision);  // 保留i位小数位
         newLinesList.append(newLine);
     }
-    referenceLines = newLinesList;  // 更新参考线集
+    geometry->referenceLines = newLinesList;  // 更新参考线集
 
     centerPoint = transformRotate(cPoint, centerPoint, theta); // 更新多边形质心
-    boundingRect = rectPrecision(calculatePolygonBoundingRect(pointsList), precision);  // 更新包络矩形
+    boundingRect = rectPrecision(calculatePolygonBoundingRect(geometry->pointsList), precision);  // 更新包络矩形
     angle = theta;  // 该图形对应最小矩形顺时针转angle度
     //qDebug() << "angle: " << angle;
 }
@@ -405,7 +613,8 @@ void Piece::rotateByReferenceLine(const QPointF cPoint, bool flag)
  */
 QPointF Piece::getOffsetForReferenceLine(const QRectF layoutRect, QPointF &gPoint)
 {
-    QLineF rLine = referenceLines.first();  // 参考线
+    updateGeometry();
+    QLineF rLine = geometry->referenceLines.first();  // 参考线
     QPointF offset;
     QRectF targetRect;
     qreal y = rLine.p1().ry();
@@ -428,7 +637,8 @@ QPointF Piece::getOffsetForReferenceLine(const QRectF layoutRect, QPointF &gPoin
  */
 QPointF Piece::getOffsetForReferenceLine(const QRectF layoutRect)
 {
-    QLineF rLine = referenceLines.first();  // 参考线
+    updateGeometry();
+    QLineF rLine = geometry->referenceLines.first();  // 参考线
     QPointF offset;
     QRectF targetRect;
     qreal y = rLine.p1().ry();
@@ -442,7 +652,7 @@ QPointF Piece::getOffsetForReferenceLine(const QRectF layoutRect)
     return offset;
 }
 
-bool Piece::hasRelationToPoint(const QPointF &point)
+bool Piece::hasRelationToPoint(const QPointF &point) const
 {
     PointRealtionToPiece relation = relationToPoint(point);
     if(relation == Outside){
@@ -451,7 +661,7 @@ bool Piece::hasRelationToPoint(const QPointF &point)
     return true;
 }
 
-Piece::PointRealtionToPiece Piece::relationToPoint(const QPointF &point)
+Piece::PointRealtionToPiece Piece::relationToPoint(const QPointF &point) const
 {
     QPointF cPointPcs = pointPrecision(point, precision);  // 保留i位小数位
     if(!inBoundingRect(cPointPcs)){
@@ -470,7 +680,7 @@ Piece::PointRealtionToPiece Piece::relationToPoint(const QPointF &point)
     return Outside;
 }
 
-bool Piece::inBoundingRect(const QPointF &point)
+bool Piece::inBoundingRect(const QPointF &point) const
 {
     QPointF cPointPcs = pointPrecision(point, precision);  // 保留i位小数位
     qreal minX, minY, maxX, maxY;
@@ -483,35 +693,116 @@ bool Piece::inBoundingRect(const QPointF &point)
     return true;
 }
 
-bool Piece::onBoundary(const QPointF &point)
+bool Piece::onBoundary(const QPointF &point) const
 {
     QPointF cPointPcs = pointPrecision(point, precision);  // 保留i位小数位
-    return pointOnPolygonBoundary(pointsList, cPointPcs);
+    QExplicitlySharedDataPointer<PieceGeometry> current = currentGeometry();
+    if(pointOnPolygonBoundary(current->pointsList, cPointPcs)){
+        return true;
+    }
+    for(int i=0; i<current->holesList.length(); i++){
+        if(pointOnPolygonBoundary(current->holesList[i], cPointPcs)){
+            return true;
+        }
+    }
+    return false;
 }
 
-bool Piece::contains(const QPointF &point)
+bool Piece::contains(const QPointF &point) const
 {
     QPointF cPointPcs = pointPrecision(point, precision);  // 保留i位小数位
-    return pointContainsInPolygon(pointsList, cPointPcs);
+    QExplicitlySharedDataPointer<PieceGeometry> current = currentGeometry();
+    if(!pointContainsInPolygon(current->pointsList, cPointPcs)){
+        return false;
+    }
+    for(int i=0; i<current->holesList.length(); i++){
+        if(pointContainsInPolygon(current->holesList[i], cPointPcs)){  // 内孔中的点不属于零件
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Piece::scanlineIntervals
+ * 水平扫描线与零件相交的x区间，与hasRelationToPoint一致：边界上的点属于零件，内孔中的点不属于零件
+ * 1. 外轮廓与内孔的边按半开区间与扫描线求交，交点排序后按奇偶规则两两配对；
+ * 2. 与扫描线相交或重合的边另记为退化区间，保证顶点与水平边也被覆盖；
+ * 3. 合并重叠区间。
+ * @param y 扫描线纵坐标，保留precision位小数
+ * @return 按x升序排列、互不重叠的闭区间
+ */
+QVector<QPair<qreal, qreal>> Piece::scanlineIntervals(qreal y) const
+{
+    QVector<QPair<qreal, qreal>> intervalList;
+    y = pointPrecision(QPointF(0, y), precision).y();
+    if(y < boundingRect.top() || y > boundingRect.bottom()){
+        return intervalList;
+    }
+    QExplicitlySharedDataPointer<PieceGeometry> current = currentGeometry();
+
+    QVector<qreal> crossList;  // 奇偶规则的交点
+    for(int k=-1; k<current->holesList.length(); k++){
+        const QVector<QPointF> &pList = k < 0 ? current->pointsList : current->holesList[k];
+        int len = pList.length();
+        for(int i=0; i<len; i++){
+            const QPointF &p1 = pList[i];
+            const QPointF &p2 = pList[(i+1)%len];
+            qreal minY = qMin(p1.y(), p2.y());
+            qreal maxY = qMax(p1.y(), p2.y());
+            if(y < minY || y > maxY){
+                continue;
+            }
+            if(minY == maxY){  // 水平边与扫描线重合
+                intervalList.append(qMakePair(qMin(p1.x(), p2.x()), qMax(p1.x(), p2.x())));
+                continue;
+            }
+            qreal x = (y - p1.y()) * (p2.x() - p1.x()) / (p2.y() - p1.y()) + p1.x();
+            intervalList.append(qMakePair(x, x));
+            if((p1.y() <= y) != (p2.y() <= y)){
+                crossList.append(x);
+            }
+        }
+    }
+    std::sort(crossList.begin(), crossList.end());
+    for(int i=0; i+1<crossList.length(); i+=2){
+        intervalList.append(qMakePair(crossList[i], crossList[i+1]));
+    }
+    if(intervalList.isEmpty()){
+        return intervalList;
+    }
+
+    // 合并重叠区间
+    std::sort(intervalList.begin(), intervalList.end());
+    int count = 0;
+    for(int i=1; i<intervalList.length(); i++){
+        if(intervalList[i].first <= intervalList[count].second){
+            intervalList[count].second = qMax(intervalList[count].second, intervalList[i].second);
+        } else{
+            intervalList[++count] = intervalList[i];
+        }
+    }
+    intervalList.resize(count + 1);
+    return intervalList;
 }
 
-bool Piece::containsInSheet(const Sheet &sheet)
+bool Piece::containsInSheet(const Sheet &sheet) const
 {
     // 获取材料的排版区域
     QRectF layoutRect = sheet.layoutRect();
     return boundingRectContain(layoutRect, getBoundingRect());
 }
 
-bool Piece::collidesWithPiece(Piece piece, const Piece::CollisionsMode mode)
+bool Piece::collidesWithPiece(const Piece &piece, const Piece::CollisionsMode mode) const
 {
     /***
      * 判断零件与其他零件是否重叠，
      * 1. 首先判断两多边形的外包矩形是否重叠，如果不重叠，则两多边形一定不会重叠
      * 2. 如果两矩形框重叠，再去进一步判断两多边形是否重叠
      */
-    QRectF boundingRect1 = piece.getBoundingRect();
+    QRectF boundingRect1 = piece.collisionBoundingRect();
     //qDebug() << minBoundingRect << "  " << boundingRect1;
-    if(boundingRectSeperate(getBoundingRect(), boundingRect1)){
+    if(boundingRectSeperate(collisionBoundingRect(), boundingRect1)){
         //qDebug() << "边缘矩形不碰撞，结束判断";
         return false;
     }
@@ -520,97 +811,776 @@ bool Piece::collidesWithPiece(Piece piece, const Piece::CollisionsMode mode)
         //qDebug() << "边缘矩形碰撞";
         return true;
     }
-    CollisionDectect collisionDectect(pointsList, piece.getPointsList());
+    // 完全位于另一零件内孔中时不碰撞
+    if(holeContainingPiece(piece) >= 0 || piece.holeContainingPiece(*this) >= 0){
+        return false;
+    }
+    // 凸分解结果在构造时已缓存，逐对检测凸多边形，
+    // 先用包络矩形、包络圆剔除，剩下的再进行分离轴检测。
+    // 几何数据不平移(不复制共享的数据)，包络加上各自的平移量，另一零件的凸多边形按相对平移量在投影时平移
+    const PieceGeometry &geometry1 = *geometry;
+    const PieceGeometry &geometry2 = *piece.geometry;
+    if(!geometry1.convexPartsList.isEmpty() && !geometry2.convexPartsList.isEmpty()){
+        QPointF offset1 = geometryOffset();
+        QPointF offset2 = piece.geometryOffset();
+        QPointF relativeOffset = offset2 - offset1;
+#ifdef FIXEDPOINTGEOMETRY
+        FixedPoint fixedRelativeOffset = toFixedPoint(offset2) - toFixedPoint(offset1);  // 两平移量都在定点网格上，相减为精确的整数
+#endif
+        CollisionDectect collisionDectect(geometry1.convexPartsList, geometry2.convexPartsList);
+        bool ret = false;
+#ifdef COLLISIONSTATISTICS
+        int testCount = 0;  // 本次检测的凸多边形对个数，结束时一次性累加到全局统计
+        int culledCount = 0;  // 本次被剔除的凸多边形对个数
+#endif
+        for(int i=0; !ret && i<geometry1.convexPartsList.length(); i++){
+            QRectF rect1 = geometry1.convexPartRectList[i].translated(offset1);
+            if(boundingRectSeperate(rect1, boundingRect1)){
+#ifdef COLLISIONSTATISTICS
+                testCount += geometry2.convexPartsList.length();
+                culledCount += geometry2.convexPartsList.length();
+#endif
+                continue;
+            }
+            QPointF center1 = geometry1.convexPartCircleList[i].center + offset1;
+            qreal radius1 = geometry1.convexPartCircleList[i].radius;
+            for(int j=0; j<geometry2.convexPartsList.length(); j++){
+#ifdef COLLISIONSTATISTICS
+                testCount++;
+#endif
+                if(boundingRectSeperate(rect1, geometry2.convexPartRectList[j].translated(offset2))){
+#ifdef COLLISIONSTATISTICS
+                    culledCount++;
+#endif
+                    continue;
+                }
+                const CollisionDectect::CircleInfo &circle2 = geometry2.convexPartCircleList[j];
+                QPointF d = center1 - circle2.center - offset2;
+                qreal r = radius1 + circle2.radius;
+                if(d.x() * d.x() + d.y() * d.y() >= r * r){
+#ifdef COLLISIONSTATISTICS
+                    culledCount++;
+#endif
+                    continue;
+                }
+#ifdef FIXEDPOINTGEOMETRY
+                if(fixedConvexPolygonCollision(geometry1.fixedPartsList[i], geometry2.fixedPartsList[j], fixedRelativeOffset)){
+                    ret = true;
+                    break;
+                }
+#else
+                if(collisionDectect.convexPolygonCollision(geometry1.convexPartsList[i], geometry2.convexPartsList[j],
+                                                           relativeOffset)){
+                    ret = true;
+                    break;
+                }
+#endif
+            }
+        }
+#ifdef COLLISIONSTATISTICS
+        partPairTestCount.fetchAndAddRelaxed(testCount);
+        partPairCulledCount.fetchAndAddRelaxed(culledCount);
+#endif
+        return ret;
+    }
+    CollisionDectect collisionDectect(getCollisionPointsList(), piece.getCollisionPointsList());
     return collisionDectect.collision();
 }
 
-qreal Piece::compactToOnHD(Piece p, qreal compactStep, qreal compactAccuracy)
+/**
+ * @brief Piece::holeContainingPiece
+ * 给定零件的碰撞检测外轮廓与内孔的边不相交、距离不小于gap，且各边中点都在内孔中时，
+ * 零件完全位于该内孔中。只比较与零件外包矩形相交的内孔边，几何数据不平移
+ * @param piece 另一零件
+ * @param gap 零件间距
+ * @return 内孔序号，不在任何内孔中时返回-1
+ */
+int Piece::holeContainingPiece(const Piece &piece, qreal gap) const
 {
-    // 水平方向靠接
-    qreal stepX = compactStep;  // 默认移动的单位距离
-    QPointF pos = getPosition();  // 获取零件质心,该点为零件初始位置
-    QPointF posOld = pos;  // 记录之前的位置
-    //qDebug() << "origin pos: " << pos;
-    while(stepX > compactAccuracy){
-        QPointF posTemp = pos;
-        QPointF forwardPos(posTemp.rx()-stepX, posTemp.ry());  // 水平方向移动
-        //qDebug() << "move to" << forwardPos;
-        if(forwardPos.rx() < p.getPosition().rx()){
-            //qDebug() << "forwardPos.rx() < p.getPosition().rx()";
-            break;
+    const PieceGeometry &geometry1 = *geometry;
+    if(geometry1.collisionHolesList.isEmpty()){
+        return -1;
+    }
+    const PieceGeometry &geometry2 = *piece.geometry;
+    const QVector<QPointF> &pList = geometry2.collisionPointsList.isEmpty() ? geometry2.pointsList : geometry2.collisionPointsList;
+    int len = pList.length();
+    if(len < 3){
+        return -1;
+    }
+    qreal epsilon = qPow(10.0, -precision);
+    QPointF offset1 = geometryOffset();
+    QPointF relativeOffset = piece.geometryOffset() - offset1;  // 另一零件相对于本零件几何数据的平移量
+    // 原多边形的外包矩形在内孔包络矩形内才可能位于内孔中，与内孔的边求交时按碰撞检测外轮廓的外包矩形筛选
+    QRectF pieceRect = piece.boundingRect.translated(-offset1).adjusted(-gap, -gap, gap, gap);
+    QRectF rect = piece.collisionBoundingRect().translated(-offset1).adjusted(-gap, -gap, gap, gap);
+    for(int k=0; k<geometry1.collisionHolesList.length(); k++){
+        if(!boundingRectContain(geometry1.collisionHoleRectList[k], pieceRect)){
+            continue;
+        }
+        const QVector<QPointF> &hole = geometry1.collisionHolesList[k];
+        bool inside = true;
+        for(int i=0; i<hole.length() && inside; i++){
+            const QPointF &a = hole[i];
+            const QPointF &b = hole[(i+1)%hole.length()];
+            if(qMax(a.x(), b.x()) < rect.left() || qMin(a.x(), b.x()) > rect.right()
+                    || qMax(a.y(), b.y()) < rect.top() || qMin(a.y(), b.y()) > rect.bottom()){
+                continue;
+            }
+            for(int j=0; j<len; j++){
+                QPointF c = pList[j] + relativeOffset;
+                QPointF d = pList[(j+1)%len] + relativeOffset;
+                if(segmentsCross(a, b, c, d, epsilon)){
+                    inside = false;
+                    break;
+                }
+                if(gap > 0 && qMin(qMin(pointToSegmentDistance(a, c, d), pointToSegmentDistance(b, c, d)),
+                                   qMin(pointToSegmentDistance(c, a, b), pointToSegmentDistance(d, a, b))) < gap - epsilon){
+                    inside = false;
+                    break;
+                }
+            }
+        }
+        // 与内孔的边不相交时，外轮廓的每条边整体在内孔内部或外部
+        for(int j=0; j<len && inside; j++){
+            inside = pointInsideLoop(hole, 0.5 * (pList[j] + pList[(j+1)%len]) + relativeOffset, epsilon);
         }
-        moveTo(forwardPos);  // 将零件移至新位置
-        if(collidesWithPiece(p)){
-            // 往右移
-            stepX /= 2;
+        if(inside){
+            return k;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Piece::collidesWithPieces
+ * 与collidesWithPiece的判断相同，用于一个移动零件与多个已排零件的检测：
+ * 本零件的分离轴与投影只计算一次，已排零件按指针传入，不再逐个拷贝；
+ * 各零件的几何数据不平移，投影时加上各自的平移量，候选位置上的零件拷贝不必复制点集
+ * @param pieceList 已移动、旋转至排放位置的零件列表
+ * @param gap 零件间距，距离小于gap时视为碰撞
+ * @return 第一个与本零件碰撞的零件在pieceList中的序号，都不碰撞时返回-1
+ */
+int Piece::collidesWithPieces(const QVector<const Piece *> &pieceList, qreal gap) const
+{
+    if(geometry->convexPartsList.isEmpty()){
+        return -1;
+    }
+    SATBatch batch(geometry->convexPartsList, geometry->convexPartRectList, geometry->convexPartCircleList,
+                   precision, gap, geometryOffset(), getFixedPartsList());
+    QRectF gapRect = collisionBoundingRect().adjusted(-gap, -gap, gap, gap);  // 按间距扩大的外包矩形
+    int ret = -1;
+    for(int i=0; i<pieceList.length(); i++){
+        const Piece &piece = *pieceList[i];
+        QRectF rect = piece.collisionBoundingRect();
+        if(boundingRectSeperate(gapRect, rect)){
             continue;
         }
-        pos.setX(pos.rx() - stepX);
+        if(batch.collidesWith(piece.geometry->convexPartsList, piece.geometry->convexPartRectList,
+                              piece.geometry->convexPartCircleList, rect, piece.geometryOffset(),
+                              piece.getFixedPartsList())
+                && holeContainingPiece(piece, gap) < 0 && piece.holeContainingPiece(*this, gap) < 0){  // 位于内孔中时不碰撞
+            ret = i;
+            break;
+        }
     }
+#ifdef COLLISIONSTATISTICS
+    partPairTestCount.fetchAndAddRelaxed(batch.getPartPairTestCount());
+    partPairCulledCount.fetchAndAddRelaxed(batch.getPartPairCulledCount());
+#endif
+    return ret;
+}
 
-    moveTo(pos);
-    qreal step = posOld.rx() - pos.rx();
-    return step;
+/**
+ * @brief Piece::penetrationWithPiece
+ * 与collidesWithPiece的检测过程相同，同时返回穿透信息：
+ * 碰撞时给出本零件移出碰撞的最小平移向量；
+ * 不碰撞时给出能分离两零件的轴，作为下一次检测的hintAxis
+ * @param piece 另一零件
+ * @param hintAxis 优先检测的分离轴，一般为上一次检测得到的分离轴
+ * @param direction 指定移出方向(单位向量)，为空时取最小平移向量
+ * @param gap 零件间距，距离小于gap时视为碰撞，移出后两零件的距离为gap
+ * @return
+ */
+CollisionDectect::CollisionInfo Piece::penetrationWithPiece(const Piece &piece,
+                                                            const QPointF &hintAxis,
+                                                            const QPointF &direction,
+                                                            qreal gap) const
+{
+    CollisionDectect::CollisionInfo info;
+    QRectF boundingRect0 = collisionBoundingRect();
+    QRectF boundingRect1 = piece.collisionBoundingRect().adjusted(-gap, -gap, gap, gap);  // 按间距扩大的外包矩形
+    if(boundingRectSeperate(boundingRect0, boundingRect1)){
+        bool xSeperate = boundingRect0.right() <= boundingRect1.left() || boundingRect0.left() >= boundingRect1.right();
+        info.axis = xSeperate ? QPointF(1, 0) : QPointF(0, 1);
+        return info;
+    }
+    if(holeContainingPiece(piece, gap) >= 0 || piece.holeContainingPiece(*this, gap) >= 0){  // 位于内孔中，没有分离轴
+        return info;
+    }
+    QExplicitlySharedDataPointer<PieceGeometry> current1 = currentGeometry();  // 已平移的几何数据，不修改共享的零件
+    QExplicitlySharedDataPointer<PieceGeometry> current2 = piece.currentGeometry();
+    const PieceGeometry &geometry1 = *current1;
+    const PieceGeometry &geometry2 = *current2;
+    qreal epsilon = qPow(10.0, -precision);
+    const QVector<QPointF> &pList1 = geometry1.collisionPointsList.isEmpty() ? geometry1.pointsList : geometry1.collisionPointsList;
+    const QVector<QPointF> &pList2 = geometry2.collisionPointsList.isEmpty() ? geometry2.pointsList : geometry2.collisionPointsList;
+    // 先检测上一次的分离轴，零件每次只移动一小段距离，大概率仍然分离
+    if(!hintAxis.isNull() && CollisionDectect::separatedOnAxis(pList1, pList2, hintAxis, gap, epsilon)){
+        info.axis = hintAxis;
+        return info;
+    }
+
+    // 与collidesWithPiece相同，先用包络矩形、包络圆剔除凸多边形对，再逐对求穿透信息后合并
+    CollisionDectect collisionDectect(geometry1.convexPartsList, geometry2.convexPartsList, precision);
+    collisionDectect.setPartsBound(geometry1.convexPartRectList, geometry1.convexPartCircleList,
+                                   geometry2.convexPartRectList, geometry2.convexPartCircleList);
+    QVector<QPointF> separatingAxisList;  // 各凸多边形对的分离轴
+    info = collisionDectect.convexPartsPenetration(QPointF(), direction, gap, &separatingAxisList);
+    if(info.collided){
+        return info;
+    }
+
+    // 不碰撞时，从各凸多边形对的分离轴中找出能分离两零件的轴
+    info.axis = QPointF();
+    for(int k=0; k<separatingAxisList.length(); k++){
+        if(CollisionDectect::separatedOnAxis(pList1, pList2, separatingAxisList[k], gap, epsilon)){
+            info.axis = separatingAxisList[k];
+            break;
+        }
+    }
+    return info;
 }
 
-qreal Piece::compactToOnVD(Piece p, qreal compactStep, qreal compactAccuracy)
+/**
+ * @brief Piece::slideDistance
+ * 计算零件沿direction方向平移至与零件p接触的距离。
+ * 从本零件各顶点沿direction、从零件p各顶点沿-direction分别向对方的边发射射线，
+ * 只统计从外部进入对方多边形的交点，取最小距离，一次遍历即可得到结果。
+ * 射线恰好经过对方顶点时可能只是擦边而过(如上下相邻的矩形水平滑动)，
+ * 这类交点需在稍远处做一次碰撞检测确认。
+ * gap大于0时，对每对凸多边形求平移至距离小于gap的距离(与collidesWithPieces的判断一致)，取最小值
+ * @param p 靠接目标零件，两零件不能重叠
+ * @param direction 平移方向，单位向量
+ * @param gap 零件间距
+ * @return 接触距离，沿该方向永不接触时返回std::numeric_limits<qreal>::max()
+ */
+qreal Piece::slideDistance(const Piece &p, const QPointF &direction, qreal gap) const
 {
-    // 重力方向靠接
-    qreal stepY = compactStep;  // 默认移动的单位距离
-    QPointF pos = getPosition();  // 获取零件质心,该点为零件初始位置
-    QPointF posOld = pos;  // 记录之前的位置
-    //qDebug() << "初始位置: " << pos;
-    while(stepY > compactAccuracy){
-        QPointF posTemp = pos;
-        QPointF forwardPos(posTemp.rx(), posTemp.ry()-stepY);  // 重力反方向移动
-        //qDebug() << "移动至：" << forwardPos;
-        moveTo(forwardPos);  // 将零件移至前进位置
-        if(collidesWithPiece(p)){
-            // 往下移
-            stepY /= 2;
+    // 两零件在垂直于平移方向的轴上投影不重叠，则永不接触
+    QPointF axis(-direction.y(), direction.x());
+    QRectF rect1 = collisionBoundingRect().adjusted(-gap, -gap, gap, gap);
+    QRectF rect2 = p.collisionBoundingRect();
+    const qreal maxValue = std::numeric_limits<qreal>::max();
+    qreal min1 = maxValue, max1 = -maxValue, min2 = maxValue, max2 = -maxValue;
+    QPointF corners1[4] = {rect1.topLeft(), rect1.topRight(), rect1.bottomLeft(), rect1.bottomRight()};
+    QPointF corners2[4] = {rect2.topLeft(), rect2.topRight(), rect2.bottomLeft(), rect2.bottomRight()};
+    for(int i=0; i<4; i++){
+        qreal d1 = corners1[i].x() * axis.x() + corners1[i].y() * axis.y();
+        qreal d2 = corners2[i].x() * axis.x() + corners2[i].y() * axis.y();
+        min1 = qMin(min1, d1);
+        max1 = qMax(max1, d1);
+        min2 = qMin(min2, d2);
+        max2 = qMax(max2, d2);
+    }
+    if(min1 >= max2 || min2 >= max1){
+        return std::numeric_limits<qreal>::max();
+    }
+    QExplicitlySharedDataPointer<PieceGeometry> current1 = currentGeometry();  // 已平移的几何数据，不修改共享的零件
+    QExplicitlySharedDataPointer<PieceGeometry> current2 = p.currentGeometry();
+    const PieceGeometry &geometry1 = *current1;
+    const PieceGeometry &geometry2 = *current2;
+
+    // 一个零件位于另一零件的内孔中时，平移至与内孔的边接触
+    int holeIndex = p.holeContainingPiece(*this, gap);
+    int ownHoleIndex = holeIndex < 0 ? holeContainingPiece(p, gap) : -1;
+    bool inHole = holeIndex >= 0 || ownHoleIndex >= 0;
+    if(inHole && gap > 0){
+        return 0;  // 有间距时不在内孔中平移
+    }
+
+    if(gap > 0){
+        qreal epsilon = qPow(10.0, -precision);
+        qreal minDis = std::numeric_limits<qreal>::max();
+        for(int i=0; i<geometry1.convexPartsList.length(); i++){
+            for(int j=0; j<geometry2.convexPartsList.length(); j++){
+                minDis = qMin(minDis, CollisionDectect::sweptDistance(geometry1.convexPartsList[i], geometry2.convexPartsList[j],
+                                                                      direction, gap, epsilon));
+            }
+        }
+        return minDis;
+    }
+
+    qreal tolerance = qPow(10, 1 - precision);  // 坐标保留precision位小数带来的误差
+    QVector<qreal> vertexHitList;  // 经过顶点的交点距离，需要确认
+    const QVector<QPointF> &outline1 = geometry1.collisionPointsList.isEmpty() ? geometry1.pointsList : geometry1.collisionPointsList;
+    const QVector<QPointF> &outline2 = geometry2.collisionPointsList.isEmpty() ? geometry2.pointsList : geometry2.collisionPointsList;
+    const QVector<QPointF> &pList1 = ownHoleIndex >= 0 ? geometry1.collisionHolesList[ownHoleIndex] : outline1;
+    const QVector<QPointF> &pList2 = holeIndex >= 0 ? geometry2.collisionHolesList[holeIndex] : outline2;
+    qreal dis1 = rayCastDistance(pList1, pList2, direction, tolerance, vertexHitList, holeIndex >= 0);
+    qreal dis2 = rayCastDistance(pList2, pList1, -direction, tolerance, vertexHitList, ownHoleIndex >= 0);
+    qreal minDis = qMin(dis1, dis2);
+
+    std::sort(vertexHitList.begin(), vertexHitList.end());
+    qreal delta = qPow(10, 3 - precision);  // 确认时的前进量
+    qreal lastDis = -std::numeric_limits<qreal>::max();
+    QPointF pos = getPosition();
+    for(int i=0; i<vertexHitList.length() && vertexHitList[i] < minDis; i++){
+        if(vertexHitList[i] - lastDis <= tolerance){
             continue;
         }
-        pos.setY(pos.ry() - stepY);
+        lastDis = vertexHitList[i];
+        Piece piece = *this;
+        piece.moveTo(pos + (lastDis + delta) * direction);
+        if(piece.collidesWithPiece(p)){
+            return lastDis;
+        }
+    }
+    return minDis;
+}
+
+/**
+ * @brief Piece::rayCastDistance
+ * pList1各顶点沿direction发射射线，求进入pList2的最近距离
+ * @param pList1 移动多边形
+ * @param pList2 固定多边形
+ * @param direction 平移方向
+ * @param tolerance 误差
+ * @param vertexHitList 射线经过pList2顶点附近的交点距离
+ * @param inner pList2为内孔，射线从环内射向环的边
+ * @return 射线与pList2边内部相交的最小距离
+ */
+qreal Piece::rayCastDistance(const QVector<QPointF> &pList1, const QVector<QPointF> &pList2,
+                             const QPointF &direction, const qreal tolerance, QVector<qreal> &vertexHitList,
+                             bool inner)
+{
+    qreal minDis = std::numeric_limits<qreal>::max();
+    int len2 = pList2.length();
+    if(pList1.isEmpty() || len2 < 3){
+        return minDis;
+    }
+
+    // 根据有向面积确定边的外法线方向
+    qreal area2 = 0;
+    for(int i=0; i<len2; i++){
+        const QPointF &a = pList2[i];
+        const QPointF &b = pList2[(i+1)%len2];
+        area2 += a.x() * b.y() - b.x() * a.y();
+    }
+    qreal sign = (area2 > 0) != inner ? 1 : -1;  // 内孔的实体在环外，外法线指向环内
+
+    for(int i=0; i<len2; i++){
+        const QPointF &a = pList2[i];
+        QPointF e = pList2[(i+1)%len2] - a;
+        qreal length = qSqrt(e.x() * e.x() + e.y() * e.y());
+        if(length == 0){  // 首尾重复点
+            continue;
+        }
+        // 只有射线从外部进入该边时才可能接触，即方向与外法线(sign*ey, -sign*ex)夹角大于90度，平行时不会进入
+        qreal denom = direction.x() * e.y() - direction.y() * e.x();
+        if(sign * denom >= -1e-12 * length){
+            continue;
+        }
+        // 顶点已越过该边时按垂直于边的深度判断误差，边与方向接近平行时t远大于实际深度，
+        // 接触后沿该边滑动(如先垂直靠接再水平靠接)不能漏掉这类交点
+        qreal cosine = -sign * denom / length;
+        for(int j=0; j<pList1.length(); j++){
+            QPointF w = a - pList1[j];
+            qreal t = (w.x() * e.y() - w.y() * e.x()) / denom;  // 射线参数
+            if(t * cosine < -tolerance || t >= minDis){
+                continue;
+            }
+            qreal s = (w.x() * direction.y() - w.y() * direction.x()) / denom * length;  // 交点到边起点的距离
+            if(s < -tolerance || s > length + tolerance){
+                continue;
+            }
+            t = qMax(t, qreal(0));
+            if(s <= tolerance || s >= length - tolerance){
+                vertexHitList.append(t);
+            } else{
+                minDis = t;
+            }
+        }
+    }
+    return minDis;
+}
+
+qreal Piece::compactToOnHD(const Piece &p)
+{
+    // 水平方向靠接，直接计算接触距离，不越过零件p的参考点
+    QPointF pos = getPosition();  // 获取零件质心,该点为零件初始位置
+    qreal maxStep = pos.rx() - p.getPosition().rx();
+    if(maxStep <= 0 || collidesWithPiece(p)){
+        return 0;
     }
+    qreal step = qMin(slideDistance(p, QPointF(-1, 0)), maxStep);
+    moveTo(QPointF(pos.rx() - step, pos.ry()));
+    return step;
+}
 
-    moveTo(pos);
-    qreal step = posOld.ry() - pos.ry();
+qreal Piece::compactToOnVD(const Piece &p)
+{
+    // 重力方向靠接，直接计算接触距离
+    QPointF pos = getPosition();  // 获取零件质心,该点为零件初始位置
+    if(collidesWithPiece(p)){
+        return 0;
+    }
+    qreal step = slideDistance(p, QPointF(0, -1));
+    if(step == std::numeric_limits<qreal>::max()){  // 永不接触
+        return 0;
+    }
+    moveTo(QPointF(pos.rx(), pos.ry() - step));
     return step;
 }
 
-QPointF Piece::compactToOnAlpha(Piece p, qreal alpha, qreal compactStep, qreal compactAccuracy)
+QPointF Piece::compactToOnAlpha(const Piece &p, qreal alpha)
 {
-    // alpha方向靠接
-    qreal step = compactStep;  // 默认移动的单位距离
+    // alpha方向靠接，直接计算接触距离
     QPointF pos = getPosition();  // 获取零件质心,该点为零件初始位置
-    QPointF posOld = pos;  // 记录之前的位置
-    qDebug() << "初始位置: " << pos;
-    while(step > compactAccuracy){
-        if(pos.ry() < p.getBoundingRect().top() - p.getBoundingRect().height()
-                || pos.rx() < p.getBoundingRect().right() - p.getBoundingRect().width()){
-            break;
+    if(collidesWithPiece(p)){
+        return QPointF(0, 0);
+    }
+    QPointF direction(-qAbs(qCos(alpha)), -qSin(alpha));
+    qreal step = slideDistance(p, direction);
+
+    // 移动范围限制：不越过零件p的左边界，不高于零件p上方一个零件高度
+    QRectF rect = p.getBoundingRect();
+    if(direction.x() < 0){
+        step = qMin(step, (pos.rx() - rect.left()) / -direction.x());
+    }
+    if(direction.y() < 0){
+        step = qMin(step, (pos.ry() - rect.top() + rect.height()) / -direction.y());
+    }
+    if(step <= 0 || step == std::numeric_limits<qreal>::max()){
+        return QPointF(0, 0);
+    }
+    moveTo(pos + step * direction);
+    return -step * direction;
+}
+
+/**
+ * @brief Piece::initConvexParts 将零件分解为凸多边形并缓存，
+ * 之后的碰撞检测直接使用缓存结果，不再重复分解
+ */
+void Piece::initConvexParts()
+{
+    geometry->convexPartsList.clear();
+    QVector<QPointF> points = geometry->collisionPointsList.isEmpty() ? geometry->pointsList : geometry->collisionPointsList;
+    if(points.length() > 1 && points.first() == points.last()){  // 首尾相连时，删除最后一点
+        points.removeLast();
+    }
+    if(points.length() >= 3){
+        ConcavePolygon concavePoly(points);  // 构造时会将点集统一为逆时针
+        if(!concavePoly.isConcavePolygon(points)){
+            geometry->convexPartsList.append(points);
+        } else{
+            QMap<int, QVector<QPointF>> splitRes = concavePoly.onSeparateConcavePoly(points);
+            for(int i=0; i<splitRes.size(); i++){
+                geometry->convexPartsList.append(splitRes[i]);
+            }
         }
-        qreal stepX = qAbs(step * qCos(alpha));  // 水平方向偏移量
-        qreal stepY = step * qSin(alpha);  // 垂直方向偏移量
-
-        qDebug() << "step: " << step;
-        qDebug() << "stepX: " << stepX;
-        qDebug() << "stepY: " << stepY;
-        QPointF posTemp = pos;
-        QPointF forwardPos(posTemp.rx()-stepX, posTemp.ry()-stepY);  // 水平方向移动
-        qDebug() << "移动至：" << forwardPos;
-        moveTo(forwardPos);  // 将零件移至新位置
-        if(collidesWithPiece(p)){
-            // 往右移
-            qDebug() << "碰撞";
-            step /= 2;
-            continue;
+    }
+#ifdef FIXEDPOINTGEOMETRY
+    initFixedPoints();  // 分解产生的新点也取整到定点网格
+#endif
+    initConvexPartBounds();
+}
+
+#ifdef FIXEDPOINTGEOMETRY
+/**
+ * @brief Piece::initFixedPoints
+ * 导入、旋转、简化、偏移等产生新坐标之后，将各点集取整到定点网格并保存定点坐标，
+ * 之后的平移由translateGeometry对定点坐标做整数加法，不再由浮点坐标重新取整
+ */
+void Piece::initFixedPoints()
+{
+    snapToFixedPoints(geometry->pointsList, geometry->fixedPointsList);
+    snapToFixedPoints(geometry->collisionPointsList, geometry->fixedCollisionPointsList);
+    geometry->fixedHolesList.resize(geometry->holesList.length());
+    for(int i=0; i<geometry->holesList.length(); i++){
+        snapToFixedPoints(geometry->holesList[i], geometry->fixedHolesList[i]);
+    }
+    geometry->fixedCollisionHolesList.resize(geometry->collisionHolesList.length());
+    for(int i=0; i<geometry->collisionHolesList.length(); i++){
+        snapToFixedPoints(geometry->collisionHolesList[i], geometry->fixedCollisionHolesList[i]);
+    }
+    geometry->fixedPartsList.resize(geometry->convexPartsList.length());
+    for(int i=0; i<geometry->convexPartsList.length(); i++){
+        snapToFixedPoints(geometry->convexPartsList[i], geometry->fixedPartsList[i]);
+    }
+}
+#endif
+
+/**
+ * @brief Piece::translateGeometry
+ * 平移多边形点集、凸多边形分解结果、内孔与参考线，
+ * 使用定点坐标时偏移量先取整到定点网格，各点集的定点坐标做精确的整数加法，浮点坐标由定点坐标换算
+ * @param geometry 几何数据，调用者保证未被共享
+ * @param offset 偏移量
+ * @param precision 精度
+ * @return 实际使用的偏移量
+ */
+QPointF Piece::translateGeometry(PieceGeometry &geometry, const QPointF &offset, short precision)
+{
+    return translateGeometry(geometry, geometry, offset, precision);
+}
+
+/**
+ * @brief Piece::translateGeometry
+ * 由source平移得到geometry，逐点写入geometry原有的缓冲区，不重新分配。
+ * geometry须为source的拷贝(各点集长度相同)，或与source为同一对象
+ * @param source 平移前的几何数据
+ * @param geometry 平移结果，调用者保证未被共享
+ * @param offset 偏移量
+ * @param precision 精度
+ * @return 实际使用的偏移量
+ */
+QPointF Piece::translateGeometry(const PieceGeometry &source, PieceGeometry &geometry, const QPointF &offset, short precision)
+{
+#ifdef FIXEDPOINTGEOMETRY
+    FixedPoint fixedOffset = toFixedPoint(offset);
+    QPointF offsetPcs = toPointF(fixedOffset);
+    translateFixedPoints(source.fixedPointsList, geometry.pointsList, geometry.fixedPointsList, fixedOffset);
+    translateFixedPoints(source.fixedCollisionPointsList, geometry.collisionPointsList, geometry.fixedCollisionPointsList, fixedOffset);
+    for(int i=0; i<source.fixedPartsList.length(); i++){
+        translateFixedPoints(source.fixedPartsList[i], geometry.convexPartsList[i], geometry.fixedPartsList[i], fixedOffset);
+    }
+    for(int i=0; i<source.fixedHolesList.length(); i++){
+        translateFixedPoints(source.fixedHolesList[i], geometry.holesList[i], geometry.fixedHolesList[i], fixedOffset);
+    }
+    for(int i=0; i<source.fixedCollisionHolesList.length(); i++){
+        translateFixedPoints(source.fixedCollisionHolesList[i], geometry.collisionHolesList[i],
+                             geometry.fixedCollisionHolesList[i], fixedOffset);
+    }
+#else
+    QPointF offsetPcs = offset;
+    for(int i=0; i<source.pointsList.length(); i++){
+        geometry.pointsList[i] = pointPrecision(source.pointsList[i] + offsetPcs, precision);  // 保留i位小数位
+    }
+    for(int i=0; i<source.collisionPointsList.length(); i++){
+        geometry.collisionPointsList[i] = pointPrecision(source.collisionPointsList[i] + offsetPcs, precision);  // 保留i位小数位
+    }
+    for(int i=0; i<source.convexPartsList.length(); i++){
+        const QVector<QPointF> &sourcePart = source.convexPartsList[i];
+        QVector<QPointF> &part = geometry.convexPartsList[i];
+        for(int j=0; j<sourcePart.length(); j++){
+            part[j] = pointPrecision(sourcePart[j] + offsetPcs, precision);  // 保留i位小数位
+        }
+    }
+    for(int i=0; i<source.holesList.length(); i++){
+        const QVector<QPointF> &sourceHole = source.holesList[i];
+        QVector<QPointF> &hole = geometry.holesList[i];
+        for(int j=0; j<sourceHole.length(); j++){
+            hole[j] = pointPrecision(sourceHole[j] + offsetPcs, precision);  // 保留i位小数位
+        }
+    }
+    for(int i=0; i<source.collisionHolesList.length(); i++){
+        const QVector<QPointF> &sourceHole = source.collisionHolesList[i];
+        QVector<QPointF> &hole = geometry.collisionHolesList[i];
+        for(int j=0; j<sourceHole.length(); j++){
+            hole[j] = pointPrecision(sourceHole[j] + offsetPcs, precision);  // 保留i位小数位
+        }
+    }
+#endif
+    for(int i=0; i<source.convexPartsList.length(); i++){
+        geometry.convexPartRectList[i] = source.convexPartRectList[i].translated(offsetPcs);
+        geometry.convexPartCircleList[i].center = source.convexPartCircleList[i].center + offsetPcs;
+    }
+    for(int i=0; i<source.collisionHoleRectList.length(); i++){
+        geometry.collisionHoleRectList[i] = source.collisionHoleRectList[i].translated(offsetPcs);
+    }
+    for(int i=0; i<source.referenceLines.length(); i++){
+        const QLineF &line = source.referenceLines[i];
+        geometry.referenceLines[i] = linePrecision(QLineF(line.p1() + offsetPcs, line.p2() + offsetPcs), precision);  // 保留i位小数位
+    }
+    return offsetPcs;
+}
+
+/**
+ * @brief Piece::deferTranslate
+ * 延迟平移：累计平移量，同步更新质心与包络矩形。
+ * 平移量不取整，使用定点坐标时在应用到几何数据时才取整(见geometryOffset)
+ * @param offset 平移量
+ * @param position 外包矩形中心的目标位置
+ */
+void Piece::deferTranslate(const QPointF &offset, const QPointF &position)
+{
+    pendingOffset += offset;
+    centerPoint += offset; // 更新多边形质心
+    minBoundingRect.moveCenter(position);  // 更新最小包络矩形
+    boundingRect.moveCenter(position);  // 更新外包矩形
+}
+
+/**
+ * @brief Piece::detachGeometry
+ * 几何数据与其他拷贝共享时复制一份，之后的修改不影响其他拷贝；
+ * 只有平移、旋转、简化等修改几何数据时才调用，拷贝零件本身只增加引用计数。
+ * 几何数据即将改变，已平移的缓存随之失效
+ */
+void Piece::detachGeometry()
+{
+    translatedGeometry.clear();
+    geometry.detach();
+}
+
+/**
+ * @brief Piece::updateGeometry
+ * 将累计的平移量一次性应用到点集、凸多边形分解结果与参考线，
+ * 几何数据未被共享时在原有的缓冲区上逐点平移，不重新分配。
+ * 零件交给多个线程只读共享之前调用，之后const函数不再复制几何数据
+ */
+void Piece::updateGeometry()
+{
+    if(pendingOffset.isNull()){
+        return;
+    }
+    detachGeometry();
+    QPointF offset = translateGeometry(*geometry, geometryOffset(), precision);
+#ifdef FIXEDPOINTGEOMETRY
+    fixedResidual += pendingOffset - offset;  // 取整余量计入下一次平移
+#else
+    Q_UNUSED(offset);
+#endif
+    pendingOffset = QPointF();
+}
+
+/**
+ * @brief Piece::currentGeometry
+ * const函数使用的几何数据：没有累计平移量时直接返回共享的数据，
+ * 否则返回应用了平移量的缓存。同一平移量只平移一次；平移量改变时，
+ * 缓存未被调用者持有则在原有的缓冲区上重新平移，否则另建一份。
+ * 不修改共享的几何数据，多个线程可以同时调用
+ * @return
+ */
+QExplicitlySharedDataPointer<PieceGeometry> Piece::currentGeometry() const
+{
+    if(pendingOffset.isNull()){
+        return geometry;
+    }
+    QPointF offset = geometryOffset();
+    QMutexLocker locker(&translatedGeometry.mutex);
+    QExplicitlySharedDataPointer<PieceGeometry> &current = translatedGeometry.geometry;
+    if(current && translatedGeometry.offset == offset){
+        return current;
+    }
+    if(!current || current->ref.load() != 1){
+        current = new PieceGeometry(*geometry);
+    }
+    translateGeometry(*geometry, *current, offset, precision);
+    translatedGeometry.offset = offset;
+    return current;
+}
+
+/**
+ * @brief Piece::geometryOffset
+ * 累计平移量应用到几何数据时实际使用的平移量。
+ * 使用定点坐标时，累计平移量加上之前的取整余量后取整到定点网格，
+ * 几何数据与零件位置的偏差始终不超过半个网格，不随平移次数累积
+ * @return
+ */
+QPointF Piece::geometryOffset() const
+{
+#ifdef FIXEDPOINTGEOMETRY
+    return toPointF(toFixedPoint(pendingOffset + fixedResidual));
+#else
+    return pendingOffset;
+#endif
+}
+
+const QVector<QVector<FixedPoint>> *Piece::getFixedPartsList() const
+{
+#ifdef FIXEDPOINTGEOMETRY
+    return &geometry->fixedPartsList;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Piece::rotatePoints
+ * 旋转多边形点集与凸多边形分解结果，
+ * 旋转结果取整到定点网格(或保留i位小数位)，之后重新计算各凸多边形的包络
+ * @param cPoint 旋转中心
+ * @param alpha 旋转角度
+ */
+void Piece::rotatePoints(const QPointF &cPoint, const qreal alpha)
+{
+    detachGeometry();
+    for(int i=0; i<geometry->pointsList.length(); i++){
+        QPointF newPoint = transformRotate(cPoint, geometry->pointsList[i], alpha);  // 旋转之后的点
+        geometry->pointsList[i] = roundedPoint(newPoint, precision);
+    }
+    for(int i=0; i<geometry->collisionPointsList.length(); i++){
+        QPointF newPoint = transformRotate(cPoint, geometry->collisionPointsList[i], alpha);  // 旋转之后的点
+        geometry->collisionPointsList[i] = roundedPoint(newPoint, precision);
+    }
+    for(int i=0; i<geometry->convexPartsList.length(); i++){
+        QVector<QPointF> &part = geometry->convexPartsList[i];
+        for(int j=0; j<part.length(); j++){
+            part[j] = roundedPoint(transformRotate(cPoint, part[j], alpha), precision);
         }
-        pos.setX(pos.rx() - stepX);
-        pos.setY(pos.ry() - stepY);
     }
+    for(int i=0; i<geometry->holesList.length(); i++){
+        QVector<QPointF> &hole = geometry->holesList[i];
+        for(int j=0; j<hole.length(); j++){
+            hole[j] = roundedPoint(transformRotate(cPoint, hole[j], alpha), precision);
+        }
+    }
+    for(int i=0; i<geometry->collisionHolesList.length(); i++){
+        QVector<QPointF> &hole = geometry->collisionHolesList[i];
+        for(int j=0; j<hole.length(); j++){
+            hole[j] = roundedPoint(transformRotate(cPoint, hole[j], alpha), precision);
+        }
+    }
+#ifdef FIXEDPOINTGEOMETRY
+    initFixedPoints();  // 旋转后重新取整，之前的取整余量不再有意义
+    fixedResidual = QPointF();
+#endif
+    initConvexPartBounds();
+    initHoleBounds();
+}
 
-    moveTo(pos);
-    qDebug() << "返回偏移：" << posOld - pos;
-    return posOld - pos;
+/**
+ * @brief Piece::initConvexPartBounds
+ * 零件包络矩形之下的第二层包络：每个凸多边形的包络矩形与包络圆，
+ * 平移时直接平移，旋转后重新计算
+ */
+void Piece::initConvexPartBounds()
+{
+    geometry->convexPartRectList.clear();
+    geometry->convexPartCircleList.clear();
+    for(int i=0; i<geometry->convexPartsList.length(); i++){
+        const QVector<QPointF> &part = geometry->convexPartsList[i];
+        QRectF rect = calculatePolygonBoundingRect(part);
+        QPointF center = rect.center();
+        qreal radius = 0;
+        for(int j=0; j<part.length(); j++){
+            radius = qMax(radius, getDistance(center, part[j]));
+        }
+        geometry->convexPartRectList.append(rect);
+        geometry->convexPartCircleList.append(CollisionDectect::CircleInfo(center, radius));
+    }
+}
+
+void Piece::initHoleBounds()
+{
+    geometry->collisionHoleRectList.clear();
+    for(int i=0; i<geometry->collisionHolesList.length(); i++){
+        geometry->collisionHoleRectList.append(calculatePolygonBoundingRect(geometry->collisionHolesList[i]));
+    }
+}
+
+void Piece::resetCollisionStatistics()
+{
+    partPairTestCount.store(0);
+    partPairCulledCount.store(0);
+}
+
+int Piece::getPartPairTestCount()
+{
+    return partPairTestCount.load();
+}
+
+int Piece::getPartPairCulledCount()
+{
+    return partPairCulledCount.load();
 }
@@ -2,17 +2,73 @@
 #define PIECE_H
 
 #include <QObject>
+#include <QAtomicInt>
+#include <QSharedData>
+#include <QMutex>
+#include <QExplicitlySharedDataPointer>
+#include <QPair>
 #include <polyline.h>
 #include <sheet.h>
 #include "collisiondectect.h"
+#include "fixedpoint.h"
+#include "polygonoffset.h"
+#include "debug.h"
 #include "quadtreenode.h"
 
+/**
+ * @brief The PieceGeometry class
+ * 零件的几何数据：点集、内孔、碰撞检测外轮廓、凸多边形分解结果及其包络、参考线。
+ * 同一零件的各个拷贝共享同一份数据，拷贝零件只增加引用计数；
+ * 零件的位置(平移量)保存在各零件对象中，旋转、简化等修改几何数据时才复制一份
+ */
+class PieceGeometry : public QSharedData
+{
+public:
+    QVector<QPointF> pointsList;  // 多边形点集
+    QVector<QPointF> collisionPointsList;  // 碰撞检测用的简化外轮廓，包含原多边形，为空时使用pointsList
+    QVector<QVector<QPointF>> holesList;  // 内孔点集，首尾相连
+    QVector<QVector<QPointF>> collisionHolesList;  // 碰撞检测用的内孔，外轮廓向外偏移时同步向内收缩，可能分裂或消失
+    QVector<QRectF> collisionHoleRectList;  // 各碰撞检测内孔的包络矩形
+    QVector<QVector<QPointF>> convexPartsList;  // 凸多边形分解结果
+    QVector<QRectF> convexPartRectList;  // 各凸多边形的包络矩形
+    QVector<CollisionDectect::CircleInfo> convexPartCircleList;  // 各凸多边形的包络圆
+#ifdef FIXEDPOINTGEOMETRY
+    // 定点坐标与对应的浮点点集一一对应，产生新坐标时取整一次，平移时只做整数加法
+    QVector<FixedPoint> fixedPointsList;  // 多边形点集的定点坐标
+    QVector<FixedPoint> fixedCollisionPointsList;  // 碰撞检测外轮廓的定点坐标
+    QVector<QVector<FixedPoint>> fixedHolesList;  // 内孔的定点坐标
+    QVector<QVector<FixedPoint>> fixedCollisionHolesList;  // 碰撞检测内孔的定点坐标
+    QVector<QVector<FixedPoint>> fixedPartsList;  // 凸多边形分解结果的定点坐标
+#endif
+    QVector<QLineF> referenceLines;  // 上插线集合
+};
+
+/**
+ * @brief The TranslatedGeometryCache class
+ * const函数使用的已平移几何数据，按平移量缓存：同一平移量只平移一次，
+ * 平移量改变时在原有的缓冲区上由共享的几何数据重新平移，不重新分配。
+ * 每个零件对象各有一份，拷贝零件时不复制；几何数据改变时由零件清空
+ */
+class TranslatedGeometryCache
+{
+public:
+    TranslatedGeometryCache() {}
+    TranslatedGeometryCache(const TranslatedGeometryCache &) {}  // 拷贝零件时不复制缓存
+    TranslatedGeometryCache &operator=(const TranslatedGeometryCache &) { clear(); return *this; }
+    void clear() { QMutexLocker locker(&mutex); geometry.reset(); }
+
+    QMutex mutex;  // 多个线程同时读取零件时保护缓存
+    QExplicitlySharedDataPointer<PieceGeometry> geometry;  // 已平移的几何数据
+    QPointF offset;  // 缓存对应的平移量
+};
+
 class Piece
 {
 public:
     enum CollisionsMode{
         BoundingRectCollisionMode,
-        ShapeCollisionMode
+        ShapeCollisionMode,
+        RasterCollisionMode  // 占用栅格粗判，只用于排版引擎排除候选位置，两零件之间仍按形状检测
     };
 
     enum PointRealtionToPiece{
@@ -40,10 +96,20 @@ public:
     void setPairType(PairType type);  // 设置零件类型
     PairType getPairType() const;  // 获取零件类型
 
-    QVector<QPointF> &getPointsList();
+    QVector<QPointF> getPointsList() const;
+    QVector<QVector<QPointF>> getConvexPartsList() const;  // 获取凸多边形分解结果
+    bool simplify(const qreal tolerance);  // 简化碰撞检测用的外轮廓，原点集保留用于输出
+    bool offsetCollisionOutline(const qreal delta, const PolygonOffset &polygonOffset = PolygonOffset());  // 碰撞检测用的外轮廓向外偏移delta
+    QVector<QPointF> getCollisionPointsList() const;  // 获取碰撞检测用的外轮廓
+    qreal getCollisionMargin() const;  // 碰撞检测外轮廓超出原多边形的最大距离
+    void setHolesList(const QVector<QVector<QPointF>> &holes);  // 设置内孔，零件面积减去内孔面积
+    QVector<QVector<QPointF>> getHolesList() const;  // 获取内孔
+    QVector<QVector<QPointF>> getCollisionHolesList() const;  // 获取碰撞检测用的内孔
+    QVector<QVector<QPointF>> getCollisionLoopsList() const;  // 碰撞检测用的外轮廓与内孔，外轮廓在前
+    bool hasHoles() const;  // 是否有可排放其他零件的内孔
 
     void setReferenceLinesList(QVector<QLineF> lines);
-    QVector<QLineF> getReferenceLinesList();
+    QVector<QLineF> getReferenceLinesList() const;
     qreal getArea() const;
     QRectF getMinBoundingRect() const;
     QRectF getBoundingRect() const;
@@ -59,6 +125,7 @@ public:
     int getCount() const;
 
     QVector<QPointF> getOffset();  // 获取偏移量
+    QVector<QVector<QPointF>> getHolesOffset();  // 获取内孔的偏移量
 
     void setPrecision(const short i);
     short getPrecision() const;
@@ -70,7 +137,8 @@ public:
 
     QPointF refLineCenterToMinBoundRectCenter() const;  // 参考线中心与最小矩形的相对关系
 
-    void moveTo(const QPointF position);  // 移动零件至给定位置
+    void moveTo(const QPointF position);  // 移动零件至给定位置，点集延迟到使用时再平移
+    void updateGeometry();  // 将累计的平移量应用到点集，在零件被多个线程共享之前调用
     void rotate(const QPointF cPoint, const qreal alpha);  // 将零件旋转alpha度
 
     void moveToByReferenceLine(const QPointF position);  // 移动零件至给定位置
@@ -79,20 +147,62 @@ public:
     QPointF getOffsetForReferenceLine(const QRectF layoutRect, QPointF &gPoint);  // 对于参考线，得到排放零件的偏移量
     QPointF getOffsetForReferenceLine(const QRectF layoutRect);  // 对于参考线，得到排放零件的偏移量
 
-    bool hasRelationToPoint(const QPointF &point);  // 点与零件有关系
-    PointRealtionToPiece relationToPoint(const QPointF &point);  // 返回点与零件的关系
-    bool inBoundingRect(const QPointF &point);  // 点在零件的包络矩形范围内
-    bool contains(const QPointF &point);  // 判断零件是否包含某点
-    bool onBoundary(const QPointF &point);  // 判断点是否在零件的边上
-    bool containsInSheet(const Sheet &sheet);  // 判断该零件是否在材料内部
-    bool collidesWithPiece(Piece piece, const CollisionsMode mode = ShapeCollisionMode);  // 判断该零件是否与给定零件碰撞
-    qreal compactToOnHD(Piece p, qreal compactStep, qreal compactAccuracy);  // 向零件水平靠接
-    qreal compactToOnVD(Piece p, qreal compactStep, qreal compactAccuracy);  // 向零件垂直靠接
-    QPointF compactToOnAlpha(Piece p, qreal alpha, qreal compactStep, qreal compactAccuracy);  // 向零件alpha方向靠接
+    bool hasRelationToPoint(const QPointF &point) const;  // 点与零件有关系
+    PointRealtionToPiece relationToPoint(const QPointF &point) const;  // 返回点与零件的关系
+    bool inBoundingRect(const QPointF &point) const;  // 点在零件的包络矩形范围内
+    bool contains(const QPointF &point) const;  // 判断零件是否包含某点
+    bool onBoundary(const QPointF &point) const;  // 判断点是否在零件的边上
+    QVector<QPair<qreal, qreal>> scanlineIntervals(qreal y) const;  // 水平扫描线与零件(含边界)相交的x区间
+    bool containsInSheet(const Sheet &sheet) const;  // 判断该零件是否在材料内部
+    bool collidesWithPiece(const Piece &piece, const CollisionsMode mode = ShapeCollisionMode) const;  // 判断该零件是否与给定零件碰撞
+    int holeContainingPiece(const Piece &piece, qreal gap = 0) const;  // 给定零件完全位于本零件的哪个内孔中，不在内孔中时返回-1
+    int collidesWithPieces(const QVector<const Piece *> &pieceList, qreal gap = 0) const;  // 批量判断该零件是否与给定零件碰撞，返回第一个碰撞零件的序号
+    qreal compactToOnHD(const Piece &p);  // 向零件水平靠接
+    qreal compactToOnVD(const Piece &p);  // 向零件垂直靠接
+    QPointF compactToOnAlpha(const Piece &p, qreal alpha);  // 向零件alpha方向靠接
+    qreal slideDistance(const Piece &p, const QPointF &direction, qreal gap = 0) const;  // 沿direction方向平移至与零件p接触(距离为gap)的距离
+    CollisionDectect::CollisionInfo penetrationWithPiece(const Piece &piece,
+                                                         const QPointF &hintAxis = QPointF(),
+                                                         const QPointF &direction = QPointF(),
+                                                         qreal gap = 0) const;  // 碰撞检测，同时返回穿透信息
+
+    static void resetCollisionStatistics();  // 清空碰撞检测统计
+    static int getPartPairTestCount();  // 凸多边形对的检测次数
+    static int getPartPairCulledCount();  // 凸多边形对被包络矩形/包络圆剔除的次数
 private:
+    void initConvexPartBounds();  // 计算各凸多边形的包络矩形与包络圆
+    void initHoleBounds();  // 计算各碰撞检测内孔的包络矩形
+    QRectF collisionBoundingRect() const;  // 按collisionMargin扩大的外包矩形，包含碰撞检测外轮廓
+    void detachGeometry();  // 修改几何数据之前，与其他拷贝共享时复制一份
+    QExplicitlySharedDataPointer<PieceGeometry> currentGeometry() const;  // 已应用平移量的几何数据，const函数使用，不修改本零件
+    static QPointF translateGeometry(PieceGeometry &geometry, const QPointF &offset, short precision);  // 平移点集、凸多边形分解结果与参考线，返回实际偏移量
+    static QPointF translateGeometry(const PieceGeometry &source, PieceGeometry &geometry,
+                                     const QPointF &offset, short precision);  // 由source平移得到geometry，写入原有的缓冲区
+    QPointF geometryOffset() const;  // 应用到几何数据时实际使用的平移量
+    const QVector<QVector<FixedPoint>> *getFixedPartsList() const;  // 凸多边形的定点坐标，未使用定点坐标时为空
+    void deferTranslate(const QPointF &offset, const QPointF &position);  // 累计平移量，更新质心与包络矩形
+    void rotatePoints(const QPointF &cPoint, const qreal alpha);  // 旋转点集与凸多边形分解结果
+    static qreal rayCastDistance(const QVector<QPointF> &pList1, const QVector<QPointF> &pList2,
+                                 const QPointF &direction, const qreal tolerance, QVector<qreal> &vertexHitList,
+                                 bool inner = false);  // 顶点射线与边求交的最小距离
+    void initConvexParts();  // 凸多边形分解，只在构造时计算一次
+#ifdef FIXEDPOINTGEOMETRY
+    void initFixedPoints();  // 各点集取整到定点网格并保存定点坐标
+#endif
+
     PairType pairType;  // 零件类型：左支/右支
-    QVector<QPointF> pointsList;  // 多边形点集
-    QVector<QLineF> referenceLines;  // 上插线集合
+    // 几何数据在moveTo时不平移，坐标加上pendingOffset为实际位置。
+    // 非const函数使用前由updateGeometry应用pendingOffset；const函数不修改几何数据，
+    // 由currentGeometry得到平移后的数据(按平移量缓存)，同一零件可以被多个线程同时读取
+    QExplicitlySharedDataPointer<PieceGeometry> geometry;  // 共享的几何数据
+    QPointF pendingOffset;  // 尚未应用到几何数据的平移量
+    mutable TranslatedGeometryCache translatedGeometry;  // 已应用pendingOffset的几何数据缓存
+#ifdef FIXEDPOINTGEOMETRY
+    QPointF fixedResidual;  // 已应用的平移量取整到定点网格后的余量，计入下一次平移，多次平移不会漂移
+#endif
+    static QAtomicInt partPairTestCount;  // 凸多边形对的检测次数
+    static QAtomicInt partPairCulledCount;  // 凸多边形对被剔除的次数
+    qreal collisionMargin;  // 简化外轮廓超出原多边形的最大距离
     qreal area;  // 零件面积
     QRectF minBoundingRect;  // 零件对应的最小包络矩形,其中心为参考点
     QRectF boundingRect;  // 零件对应的包络矩形
@@ -0,0 +1,110 @@
+﻿#include "piecepreprocessor.h"
+#include <QtConcurrent>
+
+namespace {
+// QtConcurrent::mapped使用的函数对象
+struct PreprocessFunctor
+{
+    typedef Piece *result_type;
+
+    PreprocessFunctor(const QVector<QLineF> &l, qreal t) :
+        lines(l),
+        tolerance(t)
+    {
+
+    }
+
+    Piece *operator()(const PiecePreprocessor::PieceSource &source) const
+    {
+        return PiecePreprocessor::preprocessPiece(source, lines, tolerance);
+    }
+
+    QVector<QLineF> lines;  // 参考线
+    qreal tolerance;  // 外轮廓简化误差
+};
+}
+
+PiecePreprocessor::PiecePreprocessor(QObject *parent) :
+    QObject(parent),
+    simplifyTolerance(0)
+{
+    connect(&watcher, &QFutureWatcher<Piece*>::progressValueChanged, this, &PiecePreprocessor::onProgressValueChanged);
+    connect(&watcher, &QFutureWatcher<Piece*>::finished, this, &PiecePreprocessor::finished);
+}
+
+PiecePreprocessor::~PiecePreprocessor()
+{
+    // 未取出的零件在此释放
+    watcher.waitForFinished();
+    qDeleteAll(watcher.future().results());
+}
+
+void PiecePreprocessor::setReferenceLines(const QVector<QLineF> &lines)
+{
+    referenceLines = lines;
+}
+
+void PiecePreprocessor::setSimplifyTolerance(qreal tolerance)
+{
+    simplifyTolerance = tolerance;
+}
+
+void PiecePreprocessor::start(const QVector<PieceSource> &sourceList)
+{
+    if(watcher.isRunning()){
+        return;
+    }
+    qDeleteAll(watcher.future().results());
+    watcher.setFuture(QtConcurrent::mapped(sourceList, PreprocessFunctor(referenceLines, simplifyTolerance)));
+}
+
+void PiecePreprocessor::waitForFinished()
+{
+    watcher.waitForFinished();
+}
+
+bool PiecePreprocessor::isRunning() const
+{
+    return watcher.isRunning();
+}
+
+QVector<Piece*> PiecePreprocessor::takePieceList()
+{
+    watcher.waitForFinished();
+    QVector<Piece*> pieceList = watcher.future().results().toVector();
+    watcher.setFuture(QFuture<Piece*>());  // 零件交由调用者管理
+    return pieceList;
+}
+
+/**
+ * @brief PiecePreprocessor::preprocessPiece
+ * 在工作线程中构造零件，只读入点集，不访问图元
+ * @param source 外轮廓与内孔
+ * @param lines 参考线，两端点都在零件边上的第一条作为零件的参考线
+ * @param simplifyTolerance 外轮廓简化误差
+ * @return 新建的零件
+ */
+Piece *PiecePreprocessor::preprocessPiece(const PieceSource &source, const QVector<QLineF> &lines, qreal simplifyTolerance)
+{
+    Piece *piece = new Piece(source.points);  // 切割件个数默认为1，默认精确到6位
+    piece->setHolesList(source.holes);
+    foreach (QLineF line, lines) {
+        if(piece->onBoundary(line.p1()) &&
+                piece->onBoundary(line.p2())){
+            QVector<QLineF> rLines;
+            rLines.append(line);
+            piece->setReferenceLinesList(rLines);
+            break;
+        }
+    }
+    if(simplifyTolerance > 0){  // 碰撞检测使用简化外轮廓，输出仍为原多边形
+        piece->simplify(simplifyTolerance);
+    }
+    return piece;
+}
+
+void PiecePreprocessor::onProgressValueChanged(int value)
+{
+    int total = qMax(watcher.progressMaximum() - watcher.progressMinimum(), 1);
+    emit progress((value - watcher.progressMinimum()) * 100 / total);
+}
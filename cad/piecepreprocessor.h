@@ -0,0 +1,63 @@
+﻿#ifndef PIECEPREPROCESSOR_H
+#define PIECEPREPROCESSOR_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QVector>
+#include <QLineF>
+#include "piece.h"
+
+/**
+ * @brief The PiecePreprocessor class
+ * 切割件预处理，在线程池中并行构造导入的零件。
+ * 每个零件计算面积、最小包络矩形(凸包上旋转卡壳)、外包矩形、方正度、质心、凸多边形分解，
+ * 并设置内孔、检测参考线、简化碰撞检测外轮廓。
+ * 通过progress信号报告进度，全部完成后发出finished信号，再由takePieceList按输入顺序取出零件
+ */
+class PiecePreprocessor : public QObject
+{
+    Q_OBJECT
+public:
+    struct PieceSource
+    {
+        PieceSource()
+        {
+
+        }
+        PieceSource(QVector<QPointF> p, QVector<QVector<QPointF>> h) :
+            points(p),
+            holes(h)
+        {
+
+        }
+
+        QVector<QPointF> points;  // 外轮廓
+        QVector<QVector<QPointF>> holes;  // 内孔
+    };
+
+    explicit PiecePreprocessor(QObject *parent = 0);
+    ~PiecePreprocessor();
+
+    void setReferenceLines(const QVector<QLineF> &lines);  // 设置待检测的参考线
+    void setSimplifyTolerance(qreal tolerance);  // 设置外轮廓简化误差，不大于0时不简化
+    void start(const QVector<PieceSource> &sourceList);  // 开始预处理
+    void waitForFinished();  // 等待预处理结束
+    bool isRunning() const;  // 是否正在预处理
+    QVector<Piece*> takePieceList();  // 取出预处理后的零件，由调用者释放
+
+    static Piece *preprocessPiece(const PieceSource &source, const QVector<QLineF> &lines, qreal simplifyTolerance);  // 预处理单个零件
+
+signals:
+    void progress(int percent);  // 预处理进度
+    void finished();  // 预处理结束
+
+private slots:
+    void onProgressValueChanged(int value);  // 转换为百分比
+
+private:
+    QFutureWatcher<Piece*> watcher;  // 监视线程池中的预处理任务
+    QVector<QLineF> referenceLines;  // 参考线
+    qreal simplifyTolerance;  // 外轮廓简化误差
+};
+
+#endif // PIECEPREPROCESSOR_H
@@ -10,7 +10,8 @@ Project::Project(QObject *parent) :
     name(""),
     saved(false),
     modified(false),
-    entityFlag(false)
+    entityFlag(false),
+    tessellationTolerance(0.01)
 {
     
 }
@@ -225,6 +226,16 @@ QString Project::getSceneName(const int i)
     return sceneList.at(i)->getName();
 }
 
+void Project::setTessellationTolerance(const qreal tolerance)
+{
+    tessellationTolerance = tolerance;
+}
+
+qreal Project::getTessellationTolerance()
+{
+    return tessellationTolerance;
+}
+
 void Project::resetDxfFilter()
 {
     dxfFilter.reset();
@@ -285,6 +296,9 @@ void Project::dxfFileReader(const QString fileName)
         //  读取Text实体
         dxfTextReader(dxfFilter);
 
+        //  连接开放曲线
+        dxfOpenChainReader();
+
         if(!entityFlag){
             throw(tr("导入文件中不含有效实体！"));
         }
@@ -427,6 +441,21 @@ void Project::dxfLineReader(const DxfFilter dxfFilter)
         qDebug() << "width：" << width;
 #endif
 
+        // 排样项目中直线(方向轴、中心轴除外)留待与圆弧等连接，否则直线与圆弧组成的轮廓无法闭合
+        if(type == Nest && attr.getLinetype().compare("DIRECTION") != 0
+                && attr.getLinetype().compare("MIDDLEAXIS") != 0){
+            QVector<QPointF> points;
+            points.append(QPointF(x1, y1));
+            points.append(QPointF(x2, y2));
+            if(isDxfHole(layer, attr)){
+                openHoleChainMap[sceneActive].append(points);
+            } else{
+                openChainMap[sceneActive].append(points);
+            }
+            entityFlag = true;
+            continue;
+        }
+
         // 添加直线元素
         Line *line = new Line;
         if(attr.getLinetype().compare("LINE") == 0){
@@ -473,14 +502,24 @@ void Project::dxfPolylineReader(const DxfFilter dxfFilter)
         // 获取polyline的基本信息
         QList<DL_VertexData> v = dxfFilter.polylines.at(i).vertexList;
         QVector<QPointF> points;
+        QVector<qreal> bulges;
+        bool hasBulge = false;
         for(int j=0; j<v.length(); j++){
             // 获取vertex基本信息
             qreal px = v.at(j).x;
             qreal py = v.at(j).y;
             points.append(QPointF(px, py));
+            bulges.append(v.at(j).bulge);
+            if(v.at(j).bulge != 0){
+                hasBulge = true;
+            }
         }
         int flag = dxfFilter.polylines.at(i).polyline.flags;
         double elevation = dxfFilter.polylines.at(i).polyline.elevation;
+        bool closed = flag & 1;  // 闭合多段线
+        if(hasBulge){  // 凸度不为0的线段为圆弧，按弦高误差离散
+            points = tessellatePolylineBulge(points, bulges, closed, tessellationTolerance);
+        }
 
 #ifndef DISCARD_DXF_ENTITY_PROPERTITY
         // 获取polyline属性
@@ -498,9 +537,21 @@ void Project::dxfPolylineReader(const DxfFilter dxfFilter)
         qDebug() << "width：" << width;
 #endif
 
+        // 排样项目中开放的多段线留待与圆弧等连接
+        bool hole = type == Nest && isDxfHole(layer, attr);
+        if(type == Nest && !closed && points.length() > 1 && points.first() != points.last()){
+            if(hole){
+                openHoleChainMap[sceneActive].append(points);
+            } else{
+                openChainMap[sceneActive].append(points);
+            }
+            entityFlag = true;
+            continue;
+        }
+
         // 添加多边形元素
         Polyline *polyline = new Polyline;
-        polyline->setShapeType(Shape::Polyline);
+        polyline->setShapeType(hole ? Shape::Hole : Shape::Polyline);
         sceneActive->addCustomPolylineItem(polyline);
         polyline->setPolyline(points, flag, elevation);
 
@@ -559,6 +610,18 @@ void Project::dxfArcReader(const DxfFilter dxfFilter)
         qDebug() << "width：" << width;
 #endif
 
+        // 排样项目中圆弧离散为折线，留待与其他开放曲线连接
+        if(type == Nest){
+            QVector<QPointF> points = tessellateArc(QPointF(cx, cy), r, angle1, angle2, tessellationTolerance);
+            if(isDxfHole(layer, attr)){
+                openHoleChainMap[sceneActive].append(points);
+            } else{
+                openChainMap[sceneActive].append(points);
+            }
+            entityFlag = true;
+            continue;
+        }
+
         // 添加arc元素
         Arc *arc = new Arc;
         arc->setShapeType(Shape::Arc);
@@ -615,6 +678,14 @@ void Project::dxfCircleReader(const DxfFilter dxfFilter)
         qDebug() << "width：" << width;
 #endif
 
+        // 排样项目中圆离散为闭合折线，孔标记为内孔，导入时作为所在零件的内孔
+        if(type == Nest){
+            addDxfPolylineItem(sceneActive, tessellateArc(QPointF(cx, cy), r, 0, 360, tessellationTolerance), 1,
+                               isDxfHole(layer, attr) ? Shape::Hole : Shape::Polyline);
+            entityFlag = true;
+            continue;
+        }
+
         // 添加circle元素
         Circle *circle = new Circle;
         if(attr.getLinetype().compare("CIRCLE") == 0){
@@ -681,6 +752,22 @@ void Project::dxfEllipseReader(const DxfFilter dxfFilter)
         qDebug() << "width：" << width;
 #endif
 
+        // 排样项目中椭圆离散为折线，DXF中长轴端点为相对中心的坐标
+        if(type == Nest){
+            QVector<QPointF> points = tessellateEllipse(QPointF(cx, cy), QPointF(mx, my), ratio,
+                                                        angle1, angle2, tessellationTolerance);
+            bool hole = isDxfHole(layer, attr);
+            if(points.first() == points.last()){
+                addDxfPolylineItem(sceneActive, points, 1, hole ? Shape::Hole : Shape::Polyline);
+            } else if(hole){
+                openHoleChainMap[sceneActive].append(points);
+            } else{
+                openChainMap[sceneActive].append(points);
+            }
+            entityFlag = true;
+            continue;
+        }
+
         // 添加ellipse元素
         Ellipse *ellipse = new Ellipse;
         ellipse->setShapeType(Shape::Ellipse);
@@ -710,6 +797,78 @@ void Project::dxfEllipseReader(const DxfFilter dxfFilter)
     }
 }
 
+void Project::dxfOpenChainReader()
+{
+    qreal tolerance = qMax(tessellationTolerance, qreal(1e-6));  // 端点距离不超过该值视为相接
+    QMap<Scene *, QList<QVector<QPointF> > > *chainMaps[2] = {&openChainMap, &openHoleChainMap};
+    for(int k=0; k<2; k++){
+        Shape::ShapeType shapeType = k == 0 ? Shape::Polyline : Shape::Hole;  // 内孔曲线只与内孔曲线连接
+        foreach (Scene *scene, chainMaps[k]->keys()) {
+            QList<QVector<QPointF> > chainList = chainMaps[k]->value(scene);
+            while(!chainList.isEmpty()){
+                QVector<QPointF> chain = chainList.takeFirst();
+                bool reversed = false;  // 尾端无法延长时，反向后从另一端继续
+                while(getDistance(chain.first(), chain.last()) > tolerance){
+                    bool joined = false;
+                    for(int j=0; j<chainList.length(); j++){
+                        QVector<QPointF> next = chainList[j];
+                        if(getDistance(chain.last(), next.last()) <= tolerance){
+                            std::reverse(next.begin(), next.end());
+                        }
+                        if(getDistance(chain.last(), next.first()) <= tolerance){
+                            chain.removeLast();
+                            chain += next;
+                            chainList.removeAt(j);
+                            joined = true;
+                            break;
+                        }
+                    }
+                    if(!joined){
+                        if(reversed){
+                            break;
+                        }
+                        std::reverse(chain.begin(), chain.end());
+                        reversed = true;
+                    }
+                }
+                if(chain.length() > 2 && getDistance(chain.first(), chain.last()) <= tolerance){
+                    chain.last() = chain.first();
+                    addDxfPolylineItem(scene, chain, 1, shapeType);
+                } else if(chain.length() == 2){  // 无法连接的单条直线仍作为直线(可能是参考线)
+                    Line *line = new Line;
+                    line->setShapeType(Shape::Line);
+                    scene->addCustomLineItem(line);
+                    line->setCustomLine(QLineF(chain.first(), chain.last()));
+                } else{  // 无法闭合的曲线按开放多段线加入
+                    addDxfPolylineItem(scene, chain, 0);
+                }
+            }
+        }
+    }
+    openChainMap.clear();
+    openHoleChainMap.clear();
+}
+
+/**
+ * @brief Project::isDxfHole
+ * 线型为HOLE或位于HOLE图层的实体为内孔
+ * @param layer 图层名
+ * @param attr 实体属性
+ * @return
+ */
+bool Project::isDxfHole(const QString &layer, DL_Attributes attr)
+{
+    return attr.getLinetype().compare("HOLE") == 0 || layer.compare("HOLE", Qt::CaseInsensitive) == 0;
+}
+
+void Project::addDxfPolylineItem(Scene *scene, const QVector<QPointF> &points, int flag, Shape::ShapeType shapeType)
+{
+    Polyline *polyline = new Polyline;
+    polyline->setShapeType(shapeType);
+    scene->addCustomPolylineItem(polyline);
+    polyline->setPolyline(points, flag);
+}
+
 void Project::dxfTextReader(const DxfFilter dxfFilter)
 {
     for(int i=0; i<dxfFilter.texts.length();i++){
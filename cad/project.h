@@ -8,6 +8,7 @@
 #include <QWidget>
 #include <QString>
 #include <QList>
+#include <QMap>
 
 class Project : public QObject
 {
@@ -44,6 +45,8 @@ public:
     QString getNewSceneName();  // 获取新图层名称
     QString getSceneName(Scene *Scene);  // 获取图层名称
     QString getSceneName(const int i);  // 获取第i层图层名称
+    void setTessellationTolerance(const qreal tolerance);  // 设置曲线离散为折线的弦高误差
+    qreal getTessellationTolerance();  // 获取曲线离散为折线的弦高误差
 
     // dxf 重置
     void resetDxfFilter();
@@ -58,6 +61,7 @@ public:
     void dxfCircleReader(const DxfFilter dxfFilter);  // 解析circle实体
     void dxfEllipseReader(const DxfFilter dxfFilter);  // 解析ellipse实体
     void dxfTextReader(const DxfFilter dxfFilter);  // 解析text实体
+    void dxfOpenChainReader();  // 排样项目中首尾相接的开放曲线连接为轮廓
 
     // dxf 写
     void dxfFileWriter(const QString fileName);  // 存储dxf文件
@@ -89,6 +93,13 @@ private:
     NF_Tnf tnf;
     QList<QString> offLayers; // 关闭的layer
     bool entityFlag;  // 实体标识，有实体的话为true
+    qreal tessellationTolerance;  // 圆弧、圆、椭圆离散为折线的弦高误差
+    QMap<Scene *, QList<QVector<QPointF> > > openChainMap;  // 排样项目中待连接的开放曲线，按图层存放
+    QMap<Scene *, QList<QVector<QPointF> > > openHoleChainMap;  // 排样项目中待连接的内孔开放曲线，按图层存放
+
+    bool isDxfHole(const QString &layer, DL_Attributes attr);  // 实体是否为内孔(HOLE线型或HOLE图层)
+    void addDxfPolylineItem(Scene *scene, const QVector<QPointF> &points, int flag=1,
+                            Shape::ShapeType shapeType=Shape::Polyline);  // 排样项目中曲线离散后作为多边形加入图层
 
     QList<Sheet *> sheetList;  // 材料列表
 signals:
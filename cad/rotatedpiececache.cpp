@@ -0,0 +1,146 @@
+﻿#include "rotatedpiececache.h"
+#include "nofitpolygon.h"
+
+#define ROTATED_PIECE_CACHE_MAX_BYTES (64 * 1024 * 1024)  // 默认缓存大小上限64MB
+
+RotatedPieceCache::RotatedPieceCache() :
+    bytes(0),
+    maxBytes(ROTATED_PIECE_CACHE_MAX_BYTES)
+{
+
+}
+
+/**
+ * @brief RotatedPieceCache::rotatePiece
+ * 与排版时的方式一致：移至原点，绕外包矩形中心旋转，旋转后外包矩形中心仍在原点
+ * @param piece 零件
+ * @param alpha 旋转角度
+ * @return
+ */
+Piece RotatedPieceCache::rotatePiece(const Piece &piece, qreal alpha)
+{
+    QPointF origin(0, 0);
+    Piece rotatedPiece = piece;
+    rotatedPiece.moveTo(origin);
+    rotatedPiece.rotate(origin, alpha);
+    rotatedPiece.updateGeometry();
+    return rotatedPiece;
+}
+
+qint64 RotatedPieceCache::estimateBytes(const Piece &piece)
+{
+    qint64 ret = sizeof(Piece) + sizeof(PieceGeometry) + piece.getPointsList().length() * sizeof(QPointF);
+    const QVector<QVector<QPointF>> &partsList = piece.getConvexPartsList();
+    for(int i=0; i<partsList.length(); i++){
+        ret += partsList[i].length() * sizeof(QPointF)
+                + sizeof(QRectF) + sizeof(CollisionDectect::CircleInfo);
+    }
+    const QVector<QVector<QPointF>> &holesList = piece.getHolesList();
+    const QVector<QVector<QPointF>> &collisionHolesList = piece.getCollisionHolesList();
+    for(int i=0; i<holesList.length(); i++){
+        ret += holesList[i].length() * sizeof(QPointF);
+    }
+    for(int i=0; i<collisionHolesList.length(); i++){
+        ret += collisionHolesList[i].length() * sizeof(QPointF) + sizeof(QRectF);
+    }
+    return ret;
+}
+
+/**
+ * @brief RotatedPieceCache::value
+ * 零件按量化后的角度旋转，同一个键对应的零件与最先请求的角度无关，不缓存时同样按量化角度旋转。
+ * 命中时只加读锁；未命中时在锁外旋转，再加写锁插入，
+ * 多个线程同时未命中同一个键时只保留先插入的结果
+ * @param typeID 零件类型
+ * @param alpha 旋转角度
+ * @param piece 未旋转的零件
+ * @return
+ */
+Piece RotatedPieceCache::value(int typeID, qreal alpha, const Piece &piece)
+{
+    int angle = NoFitPolygonCache::quantizeAngle(alpha);  // 单位为0.001度
+    qreal quantizedAlpha = angle / 1000.0;
+    if(typeID < 0){
+        return rotatePiece(piece, quantizedAlpha);
+    }
+    Key key(typeID, angle);
+    {
+        QReadLocker locker(&lock);
+        QMap<Key, Piece>::const_iterator it = pieceMap.constFind(key);
+        if(it != pieceMap.constEnd()){
+            hitCount.ref();
+            return it.value();
+        }
+    }
+    missCount.ref();
+    Piece rotatedPiece = rotatePiece(piece, quantizedAlpha);
+    qint64 pieceBytes = estimateBytes(rotatedPiece);
+
+    QWriteLocker locker(&lock);
+    if(pieceMap.contains(key)){
+        return pieceMap.value(key);
+    }
+    pieceMap.insert(key, rotatedPiece);
+    bytesMap.insert(key, pieceBytes);
+    keyQueue.enqueue(key);
+    bytes += pieceBytes;
+    // 超出上限时淘汰最早插入的零件，至少保留刚插入的零件
+    while(bytes > maxBytes && keyQueue.length() > 1){
+        Key oldKey = keyQueue.dequeue();
+        bytes -= bytesMap.take(oldKey);
+        pieceMap.remove(oldKey);
+        evictionCount.ref();
+    }
+    return rotatedPiece;
+}
+
+void RotatedPieceCache::clear()
+{
+    QWriteLocker locker(&lock);
+    pieceMap.clear();
+    bytesMap.clear();
+    keyQueue.clear();
+    bytes = 0;
+    hitCount.store(0);
+    missCount.store(0);
+    evictionCount.store(0);
+}
+
+void RotatedPieceCache::setMaxBytes(qint64 bytes)
+{
+    QWriteLocker locker(&lock);
+    maxBytes = bytes;
+}
+
+qint64 RotatedPieceCache::getMaxBytes() const
+{
+    QReadLocker locker(&lock);
+    return maxBytes;
+}
+
+qint64 RotatedPieceCache::getBytes() const
+{
+    QReadLocker locker(&lock);
+    return bytes;
+}
+
+int RotatedPieceCache::size() const
+{
+    QReadLocker locker(&lock);
+    return pieceMap.size();
+}
+
+int RotatedPieceCache::getHitCount() const
+{
+    return hitCount.load();
+}
+
+int RotatedPieceCache::getMissCount() const
+{
+    return missCount.load();
+}
+
+int RotatedPieceCache::getEvictionCount() const
+{
+    return evictionCount.load();
+}
@@ -0,0 +1,53 @@
+﻿#ifndef ROTATEDPIECECACHE_H
+#define ROTATEDPIECECACHE_H
+
+#include <QMap>
+#include <QPair>
+#include <QQueue>
+#include <QAtomicInt>
+#include <QReadWriteLock>
+#include "piece.h"
+
+/**
+ * @brief The RotatedPieceCache class
+ * 旋转零件缓存，键为(零件类型, 量化角度)，零件按量化角度旋转。
+ * 零件先移至原点再绕原点旋转，与NestEngine::getNoFitPolygon的方式一致，
+ * 缓存的零件包含旋转后的点集、外包矩形、凸多边形分解结果与质心，
+ * 使用时只需moveTo至目标位置。
+ * 可被多个线程同时访问；返回零件的拷贝，点集为隐式共享，拷贝不逐点复制。
+ * 缓存总大小超过上限时，按插入顺序淘汰最早的零件
+ */
+class RotatedPieceCache
+{
+public:
+    typedef QPair<int, int> Key;  // (零件类型, 量化角度)
+
+    RotatedPieceCache();
+
+    static Piece rotatePiece(const Piece &piece, qreal alpha);  // 零件移至原点后绕原点旋转alpha度
+    static qint64 estimateBytes(const Piece &piece);  // 估算零件点集占用的内存
+
+    Piece value(int typeID, qreal alpha, const Piece &piece);  // 获取旋转后的零件，未缓存时由piece旋转得到；typeID<0时不缓存
+    void clear();  // 清空缓存
+
+    void setMaxBytes(qint64 bytes);  // 设置缓存大小上限
+    qint64 getMaxBytes() const;  // 缓存大小上限
+    qint64 getBytes() const;  // 当前缓存大小
+    int size() const;  // 缓存个数
+    int getHitCount() const;  // 命中次数
+    int getMissCount() const;  // 未命中次数
+    int getEvictionCount() const;  // 淘汰次数
+
+private:
+    mutable QReadWriteLock lock;  // 读写锁
+    QMap<Key, Piece> pieceMap;  // 旋转零件缓存
+    QMap<Key, qint64> bytesMap;  // 各零件占用的内存
+    QQueue<Key> keyQueue;  // 插入顺序，用于淘汰
+    qint64 bytes;  // 当前缓存大小
+    qint64 maxBytes;  // 缓存大小上限
+    QAtomicInt hitCount;  // 命中次数
+    QAtomicInt missCount;  // 未命中次数
+    QAtomicInt evictionCount;  // 淘汰次数
+};
+
+#endif // ROTATEDPIECECACHE_H
@@ -6,7 +6,7 @@
 #include "polygondialog.h"
 #include "trapeziumdialog.h"
 #include "itemproperties.h"
-#include "insertoffsetdialog.h"
+#include "polygonoffset.h"
 
 #include <QDockWidget>
 #include <QToolButton>
@@ -2054,11 +2054,35 @@ void Sketch::onActionDrawScannerVectorizeImage()
 void Sketch::onActionInsertOffset()
 {
     qDebug() << "创建偏移";
-    InsertOffsetDialog *insertoffsetdialog =new InsertOffsetDialog();
-    //设置窗口显示在最前面
-    insertoffsetdialog->setWindowFlags(insertoffsetdialog->windowFlags() | Qt::WindowStaysOnTopHint);
-    insertoffsetdialog->showNormal();
-    insertoffsetdialog->show();
+    // 获取选中的闭合多边形
+    QList<Polyline*> polylineList;
+    foreach (Polyline *p, scene_active->getPolylineList()) {
+        QVector<QPointF> points = p->getPoints();
+        if(p->isSelectedCus() && points.length() > 3 && points.first() == points.last()){
+            polylineList.append(p);
+        }
+    }
+    if(polylineList.isEmpty()){
+        QMessageBox::warning(this, tr("错误"), tr("请先选择闭合多边形！"));
+        return;
+    }
+    bool ok;
+    double delta = QInputDialog::getDouble(this, tr("创建偏移"),
+                                           tr("偏移距离(负值向内偏移):"), 10, -10000, 10000, 3,
+                                           &ok);
+    if(!ok || delta == 0){
+        return;
+    }
+    // 圆弧连接，自相交部分由PolygonOffset消除，一个多边形可能得到多个环
+    PolygonOffset polygonOffset(PolygonOffset::RoundJoin);
+    foreach (Polyline *p, polylineList) {
+        foreach (QVector<QPointF> loop, polygonOffset.execute(p->getPoints(), delta)) {
+            loop.append(loop.first());
+            Polyline *polyline = new Polyline;
+            polyline->setPolyline(loop, Polyline::line);
+            scene_active->addCustomPolylineItem(polyline);
+        }
+    }
 }
 
 void Sketch::onActionInsertAdvancedOffset()
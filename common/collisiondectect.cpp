@@ -1,6 +1,9 @@
 ﻿#include "collisiondectect.h"
 #include "common.h"
+#include "satkernel.h"
+#include "fixedpoint.h"
 #include <qmath.h>
+#include <limits>
 
 #include <QDebug>
 
@@ -21,6 +24,15 @@ CollisionDectect::CollisionDectect(QVector<QPointF> pList1, QVector<QPointF> pLi
     this->precision = precision;
 }
 
+CollisionDectect::CollisionDectect(const QVector<QVector<QPointF>> &partsList1, const QVector<QVector<QPointF>> &partsList2, short precision) :
+    partsList1(partsList1),
+    partsList2(partsList2),
+    isCircle1(false),
+    isCircle2(false),
+    precision(precision)
+{
+}
+
 /**
  * @brief CollisionDectect::getBoundingRect
  * 包围盒碰撞检测.顺序:左上右下四个值→Xmin,Ymin,Xmax,Ymax
@@ -261,6 +273,78 @@ bool CollisionDectect::convexPolygonCollision(QVector<QPointF> pList1, QVector<Q
         return circleHit(pList1, pList2);
     }
 
+#ifdef FIXEDPOINTGEOMETRY
+    // 两个都是多边形时，使用定点坐标精确检测
+    if(!isCircle1 && !isCircle2){
+        return fixedConvexPolygonCollision(pList1, pList2);
+    }
+#endif
+
+#ifdef SAT_SIMD_KERNEL
+    // 两个都是多边形时，使用向量化分离轴内核
+    if(!isCircle1 && !isCircle2
+            && pList1.length() <= SAT_MAX_VERTICES && pList2.length() <= SAT_MAX_VERTICES){
+        bool ret = SATKernel::convexPolygonCollision(pList1, pList2, precision);
+#ifdef SATKERNELCHECK
+        // 与标量内核使用相同的容差对比，只反映向量化实现本身的差异
+        if(ret != SATKernel::convexPolygonCollision(pList1, pList2, precision, SATKernel::ScalarKernel)){
+            qDebug() << "SAT kernel mismatch:" << SATKernel::kernelType() << pList1 << pList2;
+        }
+#endif
+        return ret;
+    }
+#endif
+
+    return separatingAxisCollision(pList1, pList2, isCircle1, isCircle2);
+}
+
+/**
+ * @brief CollisionDectect::convexPolygonCollision
+ * 凸多边形2平移offset2后与凸多边形1的碰撞检测，平移量在载入顶点或投影时加上，
+ * 与先平移点集再检测的结果一致
+ * @param pList1 凸多边形1
+ * @param pList2 凸多边形2
+ * @param offset2 凸多边形2的平移量
+ * @return
+ */
+bool CollisionDectect::convexPolygonCollision(const QVector<QPointF> &pList1, const QVector<QPointF> &pList2, const QPointF &offset2)
+{
+    if(pList1.length() < 1 && pList2.length() < 1){
+        return false;
+    }
+
+#ifdef FIXEDPOINTGEOMETRY
+    return fixedConvexPolygonCollision(pList1, pList2, offset2);
+#else
+#ifdef SAT_SIMD_KERNEL
+    if(pList1.length() <= SAT_MAX_VERTICES && pList2.length() <= SAT_MAX_VERTICES){
+        bool ret = SATKernel::convexPolygonCollision(pList1, pList2, precision, offset2);
+#ifdef SATKERNELCHECK
+        if(ret != SATKernel::convexPolygonCollision(pList1, pList2, precision, SATKernel::ScalarKernel, offset2)){
+            qDebug() << "SAT kernel mismatch:" << SATKernel::kernelType() << pList1 << pList2 << offset2;
+        }
+#endif
+        return ret;
+    }
+#endif
+
+    return separatingAxisCollision(pList1, pList2, false, false, offset2);
+#endif
+}
+
+/**
+ * @brief CollisionDectect::separatingAxisCollision
+ * 分离轴检测原实现，支持圆形
+ * @param pList1
+ * @param pList2
+ * @param isCircle1
+ * @param isCircle2
+ * @param offset2 图形2的平移量，分离轴不变，投影整体平移
+ * @return
+ */
+bool CollisionDectect::separatingAxisCollision(const QVector<QPointF> &pList1, const QVector<QPointF> &pList2, bool isCircle1, bool isCircle2,
+                                               const QPointF &offset2)
+{
     // 如果至少有一个不是圆，则需要利用分离轴进行碰撞检测
     QVector<QPointF> separatingAxis;
     if(!isCircle1){
@@ -291,6 +375,10 @@ bool CollisionDectect::convexPolygonCollision(QVector<QPointF> pList1, QVector<Q
         } else{
             extreme2 = getPolygonProjection(pList2, separatingAxis[i]);
         }
+        if(!offset2.isNull()){
+            qreal shift = dotProduct(offset2, separatingAxis[i]);
+            extreme2 += QPointF(shift, shift);
+        }
         //qDebug() << "第一个图形的投影极值为："
                  // << extreme2.rx() << "  " << extreme2.ry();
         if(!overlap(extreme1, extreme2)){
@@ -302,6 +390,503 @@ bool CollisionDectect::convexPolygonCollision(QVector<QPointF> pList1, QVector<Q
     return true;
 }
 
+/**
+ * @brief CollisionDectect::convexPartsCollision
+ * 两图形均已分解为凸多边形，只需对凸多边形两两进行分离轴检测
+ * @return
+ */
+bool CollisionDectect::convexPartsCollision()
+{
+    for(int i=0; i<partsList1.length(); i++){
+        for(int j=0; j<partsList2.length(); j++){
+            if(convexPolygonCollision(partsList1[i], partsList2[j])){
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static QPointF projectionRange(const QVector<QPointF> &pList, const QPointF &axis, const QPointF &offset = QPointF())
+{
+    qreal min = pList[0].x() * axis.x() + pList[0].y() * axis.y();
+    qreal max = min;
+    for(int i=1; i<pList.length(); i++){
+        qreal d = pList[i].x() * axis.x() + pList[i].y() * axis.y();
+        min = qMin(min, d);
+        max = qMax(max, d);
+    }
+    qreal shift = offset.x() * axis.x() + offset.y() * axis.y();  // 点集平移offset后，投影整体平移
+    return QPointF(min + shift, max + shift);
+}
+
+/**
+ * @brief CollisionDectect::convexPolygonPenetration
+ * 分离轴检测，同时记录重叠量最小的轴。
+ * 对凸多边形而言，各边法线中重叠量最小者即为最小平移向量的方向，
+ * 重叠量不超过10^-precision时视为接触(不碰撞)
+ * @param pList1 凸多边形1(移动图形)
+ * @param pList2 凸多边形2
+ * @param hintAxis 优先检测的分离轴，一般为上一次检测得到的分离轴
+ * @param gap 最小间距，投影间隔小于gap时视为重叠
+ * @return
+ */
+CollisionDectect::CollisionInfo CollisionDectect::convexPolygonPenetration(const QVector<QPointF> &pList1,
+                                                                          const QVector<QPointF> &pList2,
+                                                                          const QPointF &hintAxis,
+                                                                          qreal gap) const
+{
+    CollisionInfo info;
+    if(pList1.length() < 1 || pList2.length() < 1){
+        return info;
+    }
+    qreal epsilon = qPow(10.0, -precision);
+    // 先检测上一次的分离轴，零件每次只移动一小段距离，大概率仍然分离
+    if(!hintAxis.isNull()){
+        QPointF s1 = projectionRange(pList1, hintAxis);
+        QPointF s2 = projectionRange(pList2, hintAxis);
+        if(s1.x() >= s2.y() + gap - epsilon || s2.x() >= s1.y() + gap - epsilon){
+            info.axis = hintAxis;
+            return info;
+        }
+    }
+
+    qreal minOverlap = LONG_MAX;
+    const QVector<QPointF> *polygons[2] = {&pList1, &pList2};
+    for(int k=0; k<2; k++){
+        const QVector<QPointF> &pList = *polygons[k];
+        int len = pList.length();
+        for(int i=0; i<len; i++){
+            QPointF edge = pList[(i+1)%len] - pList[i];
+            qreal length = qSqrt(edge.x() * edge.x() + edge.y() * edge.y());
+            if(length == 0){  // 防止前后两点重复导致错误
+                continue;
+            }
+            QPointF axis(edge.y() / length, -edge.x() / length);  // 单位法线向量
+            QPointF s1 = projectionRange(pList1, axis);
+            QPointF s2 = projectionRange(pList2, axis);
+            qreal overlap = qMin(s1.y(), s2.y()) - qMax(s1.x(), s2.x()) + gap;
+            if(overlap <= epsilon){
+                info.collided = false;
+                info.depth = 0;
+                info.mtv = QPointF();
+                info.axis = axis;
+                return info;
+            }
+            // 图形1投影中心在图形2之后时沿轴正向移出，否则沿反向移出
+            qreal push1 = s2.y() + gap - s1.x();  // 沿轴正向移出的距离
+            qreal push2 = s1.y() + gap - s2.x();  // 沿轴反向移出的距离
+            qreal depth = qMin(push1, push2);
+            if(depth < minOverlap){
+                minOverlap = depth;
+                info.axis = push1 <= push2 ? axis : -axis;
+            }
+        }
+    }
+    info.collided = true;
+    info.depth = minOverlap;
+    info.mtv = info.axis * minOverlap;
+    return info;
+}
+
+/**
+ * @brief CollisionDectect::setPartsBound
+ * 设置两图形各凸多边形的包络矩形、包络圆(与分解结果一一对应)，
+ * convexPartsPenetration中先用其剔除不可能碰撞的凸多边形对
+ * @param partRectList1 第一个图形各凸多边形的包络矩形
+ * @param partCircleList1 第一个图形各凸多边形的包络圆
+ * @param partRectList2 第二个图形各凸多边形的包络矩形
+ * @param partCircleList2 第二个图形各凸多边形的包络圆
+ */
+void CollisionDectect::setPartsBound(const QVector<QRectF> &partRectList1, const QVector<CircleInfo> &partCircleList1,
+                                     const QVector<QRectF> &partRectList2, const QVector<CircleInfo> &partCircleList2)
+{
+    this->partRectList1 = partRectList1;
+    this->partCircleList1 = partCircleList1;
+    this->partRectList2 = partRectList2;
+    this->partCircleList2 = partCircleList2;
+}
+
+/**
+ * @brief CollisionDectect::convexPartsPenetration
+ * 两图形均已分解为凸多边形，对各对凸多边形求穿透信息后合并。
+ * 设置了包络矩形、包络圆时，先用其剔除凸多边形对
+ * @param hintAxis 优先检测的分离轴
+ * @param direction 指定移出方向(单位向量)，为空时取最小平移向量
+ * @param gap 最小间距
+ * @param separatingAxisList 不为空时，记录各未碰撞凸多边形对的分离轴
+ * @return
+ */
+CollisionDectect::CollisionInfo CollisionDectect::convexPartsPenetration(const QPointF &hintAxis,
+                                                                        const QPointF &direction,
+                                                                        qreal gap,
+                                                                        QVector<QPointF> *separatingAxisList) const
+{
+    QVector<const QVector<QPointF>*> overlapList1, overlapList2;
+    QVector<CollisionInfo> infoList;
+    CollisionInfo info;
+    bool cull = partRectList1.length() == partsList1.length() && partRectList2.length() == partsList2.length()
+            && partCircleList1.length() == partsList1.length() && partCircleList2.length() == partsList2.length();
+    for(int i=0; i<partsList1.length(); i++){
+        for(int j=0; j<partsList2.length(); j++){
+            if(cull){
+                QRectF rect2 = partRectList2[j].adjusted(-gap, -gap, gap, gap);
+                const QRectF &rect1 = partRectList1[i];
+                if(rect1.right() <= rect2.left() || rect1.left() >= rect2.right()
+                        || rect1.bottom() <= rect2.top() || rect1.top() >= rect2.bottom()){
+                    continue;
+                }
+                QPointF d = partCircleList1[i].center - partCircleList2[j].center;
+                qreal r = partCircleList1[i].radius + partCircleList2[j].radius + gap;
+                if(d.x() * d.x() + d.y() * d.y() >= r * r){
+                    continue;
+                }
+            }
+            CollisionInfo partInfo = convexPolygonPenetration(partsList1[i], partsList2[j], hintAxis, gap);
+            if(partInfo.collided){
+                overlapList1.append(&partsList1[i]);
+                overlapList2.append(&partsList2[j]);
+                infoList.append(partInfo);
+            } else{
+                if(info.axis.isNull()){
+                    info.axis = partInfo.axis;
+                }
+                if(separatingAxisList){
+                    separatingAxisList->append(partInfo.axis);
+                }
+            }
+        }
+    }
+    if(infoList.isEmpty()){
+        return info;
+    }
+    return combinePenetration(overlapList1, overlapList2, infoList, direction, gap);
+}
+
+/**
+ * @brief CollisionDectect::separatedOnAxis
+ * 两图形在axis上的投影间隔是否不小于gap，图形可以是凹多边形
+ * @param pList1 图形1
+ * @param pList2 图形2
+ * @param axis 投影轴(单位向量)
+ * @param gap 最小间距
+ * @param epsilon 间隔比gap小不超过epsilon时仍视为分离
+ * @return
+ */
+bool CollisionDectect::separatedOnAxis(const QVector<QPointF> &pList1, const QVector<QPointF> &pList2,
+                                       const QPointF &axis, qreal gap, qreal epsilon)
+{
+    if(pList1.isEmpty() || pList2.isEmpty()){
+        return true;
+    }
+    QPointF s1 = projectionRange(pList1, axis);
+    QPointF s2 = projectionRange(pList2, axis);
+    return s1.x() >= s2.y() + gap - epsilon || s2.x() >= s1.y() + gap - epsilon;
+}
+
+/**
+ * @brief CollisionDectect::penetrationAlong
+ * 凸多边形1沿direction平移，移出与凸多边形2(两侧各扩大gap)碰撞所需的距离。
+ * 与sweptDistance相同，每条分离轴上投影重叠的平移距离构成一个区间，
+ * 所有区间的交集为碰撞的平移距离，交集的终点即为移出距离，与convexPolygonPenetration的判断一致。
+ * 不能只用direction上的投影计算，斜向移出时会偏大
+ * @param pList1 移动的凸多边形
+ * @param pList2 固定的凸多边形
+ * @param direction 平移方向(单位向量)
+ * @param gap 最小间距
+ * @return 不需要平移时返回0
+ */
+qreal CollisionDectect::penetrationAlong(const QVector<QPointF> &pList1, const QVector<QPointF> &pList2,
+                                         const QPointF &direction, qreal gap)
+{
+    if(pList1.isEmpty() || pList2.isEmpty()){
+        return 0;
+    }
+    qreal tEnter = -LONG_MAX;
+    qreal tLeave = LONG_MAX;
+    const QVector<QPointF> *polygons[2] = {&pList1, &pList2};
+    for(int k=0; k<2; k++){
+        const QVector<QPointF> &pList = *polygons[k];
+        int len = pList.length();
+        for(int i=0; i<len; i++){
+            QPointF edge = pList[(i+1)%len] - pList[i];
+            qreal length = qSqrt(edge.x() * edge.x() + edge.y() * edge.y());
+            if(length == 0){
+                continue;
+            }
+            QPointF axis(edge.y() / length, -edge.x() / length);
+            QPointF p1 = projectionRange(pList1, axis);
+            QPointF p2 = projectionRange(pList2, axis);
+            qreal low = p2.x() - gap - p1.y();  // 重叠时 low < t*v < high
+            qreal high = p2.y() + gap - p1.x();
+            qreal v = direction.x() * axis.x() + direction.y() * axis.y();
+            if(qAbs(v) < 1e-12){
+                if(low >= 0 || high <= 0){  // 该轴上始终分离
+                    return 0;
+                }
+                continue;
+            }
+            qreal t1 = low / v;
+            qreal t2 = high / v;
+            if(t1 > t2){
+                qSwap(t1, t2);
+            }
+            tEnter = qMax(tEnter, t1);
+            tLeave = qMin(tLeave, t2);
+            if(tEnter >= 0 || tLeave <= 0){  // 当前位置已分离
+                return 0;
+            }
+        }
+    }
+    if(tLeave == LONG_MAX){  // 没有有效的分离轴(退化图形)，按direction上的投影分离计算
+        QPointF s1 = projectionRange(pList1, direction);
+        QPointF s2 = projectionRange(pList2, direction);
+        return qMax(qreal(0), s2.y() + gap - s1.x());
+    }
+    return tLeave;
+}
+
+/**
+ * @brief CollisionDectect::combinePenetration
+ * 多对凸多边形同时重叠时，以各对的最小穿透方向为候选方向，
+ * 每个候选方向上的穿透深度取各对沿该方向移出所需距离(penetrationAlong)的最大值，
+ * 再取深度最小的候选方向作为整体的最小平移向量。
+ * 指定direction时只沿该方向移出
+ * @param overlapList1 重叠的凸多边形对中属于图形1的部分
+ * @param overlapList2 重叠的凸多边形对中属于图形2的部分
+ * @param infoList 各对的穿透信息
+ * @param direction 指定的移出方向(单位向量)
+ * @param gap 最小间距
+ * @return
+ */
+CollisionDectect::CollisionInfo CollisionDectect::combinePenetration(const QVector<const QVector<QPointF>*> &overlapList1,
+                                                                    const QVector<const QVector<QPointF>*> &overlapList2,
+                                                                    const QVector<CollisionInfo> &infoList,
+                                                                    const QPointF &direction,
+                                                                    qreal gap)
+{
+    CollisionInfo info;
+    if(infoList.isEmpty()){
+        return info;
+    }
+    if(infoList.length() == 1 && direction.isNull()){
+        return infoList.first();
+    }
+    QVector<QPointF> candidateList;
+    if(direction.isNull()){
+        for(int i=0; i<infoList.length(); i++){
+            candidateList.append(infoList[i].axis);
+        }
+    } else{
+        candidateList.append(direction);
+    }
+    info.collided = true;
+    info.depth = LONG_MAX;
+    for(int k=0; k<candidateList.length(); k++){
+        qreal depth = 0;
+        for(int i=0; i<infoList.length(); i++){
+            depth = qMax(depth, penetrationAlong(*overlapList1[i], *overlapList2[i], candidateList[k], gap));
+            if(depth >= info.depth){
+                break;
+            }
+        }
+        if(depth < info.depth){
+            info.depth = depth;
+            info.axis = candidateList[k];
+        }
+    }
+    info.mtv = info.axis * info.depth;
+    return info;
+}
+
+/**
+ * @brief CollisionDectect::sweptDistance
+ * 凸多边形1沿direction平移t时，在每条分离轴上与凸多边形2(两侧各扩大gap)的投影
+ * 重叠的t构成一个区间，所有区间的交集即为分离轴检测判为碰撞的平移距离，
+ * 交集的起点就是平移至距离小于gap时的距离
+ * @param pList1 移动的凸多边形
+ * @param pList2 固定的凸多边形
+ * @param direction 平移方向(单位向量)
+ * @param gap 最小间距
+ * @param epsilon 重叠量不超过epsilon时视为接触
+ * @return 平移距离，已碰撞时返回0，不会碰撞时返回std::numeric_limits<qreal>::max()
+ */
+qreal CollisionDectect::sweptDistance(const QVector<QPointF> &pList1, const QVector<QPointF> &pList2,
+                                      const QPointF &direction, qreal gap, qreal epsilon)
+{
+    if(pList1.length() < 1 || pList2.length() < 1){
+        return std::numeric_limits<qreal>::max();
+    }
+    qreal tEnter = -std::numeric_limits<qreal>::max();
+    qreal tLeave = std::numeric_limits<qreal>::max();
+    const QVector<QPointF> *polygons[2] = {&pList1, &pList2};
+    for(int k=0; k<2; k++){
+        const QVector<QPointF> &pList = *polygons[k];
+        int len = pList.length();
+        for(int i=0; i<len; i++){
+            QPointF edge = pList[(i+1)%len] - pList[i];
+            qreal length = qSqrt(edge.x() * edge.x() + edge.y() * edge.y());
+            if(length == 0){
+                continue;
+            }
+            QPointF axis(edge.y() / length, -edge.x() / length);
+            QPointF s1 = projectionRange(pList1, axis);
+            QPointF s2 = projectionRange(pList2, axis);
+            qreal low = s2.x() - gap - s1.y() + epsilon;  // 重叠时 low < t*v < high
+            qreal high = s2.y() + gap - s1.x() - epsilon;
+            qreal v = direction.x() * axis.x() + direction.y() * axis.y();
+            if(qAbs(v) < 1e-12){
+                if(low >= 0 || high <= 0){  // 平移时该轴上始终分离
+                    return std::numeric_limits<qreal>::max();
+                }
+                continue;
+            }
+            qreal t1 = low / v;
+            qreal t2 = high / v;
+            if(t1 > t2){
+                qSwap(t1, t2);
+            }
+            tEnter = qMax(tEnter, t1);
+            tLeave = qMin(tLeave, t2);
+            if(tEnter >= tLeave || tLeave <= 0){
+                return std::numeric_limits<qreal>::max();
+            }
+        }
+    }
+    return qMax(tEnter, qreal(0));
+}
+
+SATBatch::SATBatch(const QVector<QVector<QPointF>> &partsList,
+                   const QVector<QRectF> &partRectList,
+                   const QVector<CollisionDectect::CircleInfo> &partCircleList,
+                   short precision,
+                   qreal gap,
+                   const QPointF &offset,
+                   const QVector<QVector<FixedPoint>> *fixedPartsList) :
+    offset(offset),
+    epsilon(qPow(10.0, -precision)),
+    gap(qMax(gap, qreal(0))),
+    partPairTestCount(0),
+    partPairCulledCount(0)
+{
+    for(int i=0; i<partsList.length(); i++){
+        const QVector<QPointF> &pList = partsList[i];
+        MovingPart part;
+        part.points = &pList;
+        part.rect = partRectList[i].translated(offset);
+        part.circle = CollisionDectect::CircleInfo(partCircleList[i].center + offset, partCircleList[i].radius);
+        part.prepared = SATKernel::preparePolygon(pList, part.polygon, offset);
+        part.fixedPoints = fixedPartsList ? &fixedPartsList->at(i) : 0;
+        movingPartList.append(part);
+    }
+}
+
+/**
+ * @brief SATBatch::collidesWith
+ * 先用已排图形的包络矩形剔除移动图形的凸多边形，
+ * 再对每对凸多边形用包络矩形、包络圆剔除，剩下的进行分离轴检测
+ * @param partsList 已排图形的凸多边形分解结果
+ * @param partRectList 已排图形各凸多边形的包络矩形
+ * @param partCircleList 已排图形各凸多边形的包络圆
+ * @param boundingRect 已排图形的包络矩形(已平移)
+ * @param partsOffset 已排图形的平移量，凸多边形及其包络加上该平移量为实际位置
+ * @param fixedPartsList 已排图形凸多边形的定点坐标，两图形都提供时使用整数精确检测
+ * @return
+ */
+bool SATBatch::collidesWith(const QVector<QVector<QPointF>> &partsList,
+                            const QVector<QRectF> &partRectList,
+                            const QVector<CollisionDectect::CircleInfo> &partCircleList,
+                            const QRectF &boundingRect,
+                            const QPointF &partsOffset,
+                            const QVector<QVector<FixedPoint>> *fixedPartsList) const
+{
+    QRectF gapRect = boundingRect.adjusted(-gap, -gap, gap, gap);  // 按间距扩大的包络矩形
+    for(int i=0; i<movingPartList.length(); i++){
+        const MovingPart &part = movingPartList[i];
+        if(boundingRectSeperate(part.rect, gapRect)){
+            partPairTestCount += partsList.length();
+            partPairCulledCount += partsList.length();
+            continue;
+        }
+        for(int j=0; j<partsList.length(); j++){
+            partPairTestCount++;
+            if(boundingRectSeperate(part.rect, partRectList[j].translated(partsOffset).adjusted(-gap, -gap, gap, gap))){
+                partPairCulledCount++;
+                continue;
+            }
+            const CollisionDectect::CircleInfo &circle = partCircleList[j];
+            QPointF d = part.circle.center - circle.center - partsOffset;
+            qreal r = part.circle.radius + circle.radius + gap;
+            if(d.x() * d.x() + d.y() * d.y() >= r * r){
+                partPairCulledCount++;
+                continue;
+            }
+            if(partCollision(part, partsList[j], partsOffset, fixedPartsList ? &fixedPartsList->at(j) : 0)){
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int SATBatch::getPartPairTestCount() const
+{
+    return partPairTestCount;
+}
+
+int SATBatch::getPartPairCulledCount() const
+{
+    return partPairCulledCount;
+}
+
+bool SATBatch::partCollision(const SATBatch::MovingPart &part, const QVector<QPointF> &pList,
+                             const QPointF &partsOffset, const QVector<FixedPoint> *fixedList) const
+{
+    if(part.points->isEmpty() || pList.isEmpty()){
+        return false;
+    }
+#ifdef FIXEDPOINTGEOMETRY
+    if(gap == 0 && part.fixedPoints && fixedList){
+        // 平移量已取整到定点网格，只按相对平移量投影，不复制点集
+        return fixedConvexPolygonCollision(*part.fixedPoints, *fixedList, toFixedPoint(partsOffset) - toFixedPoint(offset));
+    }
+#else
+    Q_UNUSED(fixedList);
+#endif
+    if(part.prepared){
+        bool ok = false;
+        bool ret = SATKernel::convexPolygonCollision(part.polygon, pList, partsOffset, gap, epsilon, &ok);
+        if(ok){
+            return ret;
+        }
+    }
+    return partCollisionScalar(part, pList, partsOffset);
+}
+
+bool SATBatch::partCollisionScalar(const SATBatch::MovingPart &part, const QVector<QPointF> &pList,
+                                   const QPointF &partsOffset) const
+{
+    const QVector<QPointF> *polygons[2] = {part.points, &pList};
+    for(int k=0; k<2; k++){
+        const QVector<QPointF> &edgeList = *polygons[k];
+        int len = edgeList.length();
+        for(int i=0; i<len; i++){
+            QPointF edge = edgeList[(i+1)%len] - edgeList[i];
+            qreal length = qSqrt(edge.x() * edge.x() + edge.y() * edge.y());
+            if(length == 0){  // 防止前后两点重复导致错误
+                continue;
+            }
+            QPointF axis(edge.y() / length, -edge.x() / length);
+            QPointF s1 = projectionRange(*part.points, axis, offset);
+            QPointF s2 = projectionRange(pList, axis, partsOffset);
+            if(s1.x() >= s2.y() + gap - epsilon || s2.x() >= s1.y() + gap - epsilon){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 ConcavePolygon::ConcavePolygon(QVector<QPointF> &list) :
     coordinateSystem(LeftHandRuleCS)
 {
@@ -627,8 +1212,13 @@ bool ConcavePolygon::getSplitPointByVertexRegion(QVector<QPointF> pList, int con
 
 ConcavePolygon::PolyDirection ConcavePolygon::getMutiPtClockDir(QPointF p1, QPointF p2, QPointF p3)
 {
+#ifdef FIXEDPOINTGEOMETRY
+    // (p1-p2)x(p3-p1) = (p1-p2)x(p3-p2)
+    qint64 ret = fixedCross(toFixedPoint(p2), toFixedPoint(p1), toFixedPoint(p3));
+#else
     qreal ret = (p1.rx() - p2.rx()) * (p3.ry() - p1.ry())
             - (p3.rx() - p1.rx()) * (p1.ry() - p2.ry());
+#endif
     return ret > 0 ? Anticlockwise : (ret < 0 ? Clockwise : InALine);
 }
 
@@ -648,8 +1238,12 @@ bool ConcavePolygon::isAntiClockDir(QVector<QPointF> pList)
     for(int i=0; i<len; i++){
         int nextIndex1 = (i + 1) % len;
         int nextIndex2 = (i + 2) % len;
+#ifdef FIXEDPOINTGEOMETRY
+        qint64 n = fixedCross(toFixedPoint(pList[i]), toFixedPoint(pList[nextIndex1]), toFixedPoint(pList[nextIndex2]));
+#else
         int n = (pList[nextIndex1].rx() - pList[i].rx()) * (pList[nextIndex2].ry() - pList[nextIndex1].ry());
         n -= (pList[nextIndex1].ry() - pList[i].ry()) * (pList[nextIndex2].rx() - pList[nextIndex1].rx());
+#endif
         if(n < 0){
             count--;
         } else if(n > 0){
@@ -675,10 +1269,14 @@ void ConcavePolygon::conversPoly(QVector<QPointF> &pList)
 bool ConcavePolygon::isVectorInsection(QPointF p1, QPointF d1, QPointF p2, QPointF d2)
 {
     //qDebug() << p1 << ", " << d1 << ", " << p2 << ", " << d2;
+#ifdef FIXEDPOINTGEOMETRY
+    return fixedSegmentIntersect(toFixedPoint(p1), toFixedPoint(d1), toFixedPoint(p2), toFixedPoint(d2));
+#else
     QLineF l1(p1, d1);
     QLineF l2(p2, d2);
     QPointF intersection;
     return getLineIntersection(l1, l2, intersection);
+#endif
 #if 0
     QPointF ePoint(p2.rx()-p1.rx(), p2.ry()-p1.ry());
     qreal cross = d1.rx() * d2.ry() - d1.ry() * d2.rx();
@@ -834,10 +1432,14 @@ bool ConcavePolygon::getCrossByRadialAndSegment(QPointF p1, QPointF d1, QPointF
 
 ConcavePolygon::PointRelationToLine ConcavePolygon::GetPosRelationToLine(QPointF sPoint, QPointF ePoint, QPointF p)
 {
+#ifdef FIXEDPOINTGEOMETRY
+    qint64 ret = -fixedCross(toFixedPoint(sPoint), toFixedPoint(ePoint), toFixedPoint(p));
+#else
     qreal ret = p.rx() * (ePoint.ry() - sPoint.ry())
             + p.ry() * (sPoint.rx() - ePoint.rx())
             + sPoint.ry() * ePoint.rx()
             - sPoint.rx() * ePoint.ry();
+#endif
     return ret > 0 ? RightLine : (ret < 0 ? LeftLine : InLine) ;
 }
 
@@ -6,6 +6,8 @@
 #include <QRectF>
 #include <QLineF>
 #include <QMap>
+#include "satkernel.h"
+#include "fixedpoint.h"
 
 /***
  * @brief The CollisionDectect class
@@ -37,7 +39,29 @@ public:
         qreal radius;
     };
 
+    /**
+     * @brief The CollisionInfo struct
+     * 带穿透信息的碰撞检测结果：
+     * 碰撞时，mtv为第一个图形移出碰撞的最小平移向量，depth为其长度，axis为其方向；
+     * 不碰撞时，axis为找到的分离轴，下一次检测时可作为优先检测的分离轴
+     */
+    struct CollisionInfo
+    {
+        CollisionInfo() :
+            collided(false),
+            depth(0),
+            mtv(QPointF()),
+            axis(QPointF())
+        {}
+
+        bool collided;  // 是否碰撞
+        qreal depth;  // 穿透深度
+        QPointF mtv;  // 最小平移向量
+        QPointF axis;  // 分离轴或最小穿透轴(单位向量)
+    };
+
     CollisionDectect(QVector<QPointF> pList1, QVector<QPointF> pList2, bool isCircle1=false, bool isCircle2=false, short precision = 6);
+    CollisionDectect(const QVector<QVector<QPointF>> &partsList1, const QVector<QVector<QPointF>> &partsList2, short precision = 6);  // 使用已分解的凸多边形构造
     QVector<qreal> getBoundingRect(QVector<QPointF> pList);  // 获取包络矩形
     CircleInfo getBoundingCircle(QVector<QPointF> pList);  // 获取包络矩形
     qreal dotProduct(QPointF v1, QPointF v2);  // 点乘
@@ -52,15 +76,103 @@ public:
 
     bool collision();  // 返回碰撞检测结果
     bool convexPolygonCollision(QVector<QPointF> pList1, QVector<QPointF> pList2, bool isCircle1=false, bool isCircle2=false);  // 返回凸多边形碰撞检测结果
+    bool convexPolygonCollision(const QVector<QPointF> &pList1, const QVector<QPointF> &pList2, const QPointF &offset2);  // 凸多边形2平移offset2后的碰撞检测结果，不复制点集
+    bool convexPartsCollision();  // 返回已分解凸多边形组的碰撞检测结果
+    CollisionInfo convexPolygonPenetration(const QVector<QPointF> &pList1, const QVector<QPointF> &pList2,
+                                           const QPointF &hintAxis = QPointF(),
+                                           qreal gap = 0) const;  // 返回凸多边形碰撞检测结果及穿透信息
+    void setPartsBound(const QVector<QRectF> &partRectList1, const QVector<CircleInfo> &partCircleList1,
+                       const QVector<QRectF> &partRectList2, const QVector<CircleInfo> &partCircleList2);  // 设置各凸多边形的包络矩形、包络圆，用于剔除
+    CollisionInfo convexPartsPenetration(const QPointF &hintAxis = QPointF(),
+                                         const QPointF &direction = QPointF(),
+                                         qreal gap = 0,
+                                         QVector<QPointF> *separatingAxisList = 0) const;  // 返回已分解凸多边形组的碰撞检测结果及穿透信息
+
+    static bool separatedOnAxis(const QVector<QPointF> &pList1, const QVector<QPointF> &pList2,
+                                const QPointF &axis, qreal gap = 0, qreal epsilon = 0);  // 两图形在axis上的投影间隔是否不小于gap
+    static qreal penetrationAlong(const QVector<QPointF> &pList1, const QVector<QPointF> &pList2,
+                                  const QPointF &direction, qreal gap = 0);  // 凸多边形1沿direction移出与凸多边形2碰撞的距离
+    static CollisionInfo combinePenetration(const QVector<const QVector<QPointF>*> &overlapList1,
+                                            const QVector<const QVector<QPointF>*> &overlapList2,
+                                            const QVector<CollisionInfo> &infoList,
+                                            const QPointF &direction = QPointF(),
+                                            qreal gap = 0);  // 合并多对重叠凸多边形的穿透信息
+    static qreal sweptDistance(const QVector<QPointF> &pList1, const QVector<QPointF> &pList2,
+                               const QPointF &direction, qreal gap = 0, qreal epsilon = 0);  // 凸多边形1沿direction平移至与凸多边形2的距离小于gap时的距离
 
 private:
+    bool separatingAxisCollision(const QVector<QPointF> &pList1, const QVector<QPointF> &pList2, bool isCircle1, bool isCircle2,
+                                 const QPointF &offset2 = QPointF());  // 分离轴检测原实现
+
     QVector<QPointF> pList1;  // 第一个图形的点集
     QVector<QPointF> pList2;  // 第二个图形的点集
+    QVector<QVector<QPointF>> partsList1;  // 第一个图形的凸多边形分解结果
+    QVector<QVector<QPointF>> partsList2;  // 第二个图形的凸多边形分解结果
+    QVector<QRectF> partRectList1;  // 第一个图形各凸多边形的包络矩形，为空时不剔除
+    QVector<QRectF> partRectList2;  // 第二个图形各凸多边形的包络矩形
+    QVector<CircleInfo> partCircleList1;  // 第一个图形各凸多边形的包络圆
+    QVector<CircleInfo> partCircleList2;  // 第二个图形各凸多边形的包络圆
     bool isCircle1;  // 第一个图形是否为圆
     bool isCircle2;  // 第二个图形是否为圆
     short precision;  // 精确度
 };
 
+/**
+ * @brief The SATBatch class
+ * 一个移动图形与多个已排图形的批量分离轴检测，图形均已分解为凸多边形。
+ * 移动图形各凸多边形在构造时载入分离轴内核(SATKernel)，顶点与分离轴只计算一次，
+ * 之后与每个已排图形检测时直接复用，检测时不分配内存，已排图形只需传入引用，不需要拷贝。
+ * 构造时传入的点集需在SATBatch使用期间保持有效。
+ * 两图形的点集可以未平移，分别给出平移量，投影时直接加上平移量在分离轴上的分量，不必复制点集。
+ * gap大于0时为间距检测：两图形在某一分离轴上的投影间隔不小于gap才视为分离，
+ * 相当于将图形按斜接方式向外偏移gap/2之后再检测，结果偏保守
+ */
+class SATBatch
+{
+public:
+    SATBatch(const QVector<QVector<QPointF>> &partsList,
+             const QVector<QRectF> &partRectList,
+             const QVector<CollisionDectect::CircleInfo> &partCircleList,
+             short precision = 6,
+             qreal gap = 0,
+             const QPointF &offset = QPointF(),
+             const QVector<QVector<FixedPoint>> *fixedPartsList = 0);
+
+    bool collidesWith(const QVector<QVector<QPointF>> &partsList,
+                      const QVector<QRectF> &partRectList,
+                      const QVector<CollisionDectect::CircleInfo> &partCircleList,
+                      const QRectF &boundingRect,
+                      const QPointF &partsOffset = QPointF(),
+                      const QVector<QVector<FixedPoint>> *fixedPartsList = 0) const;  // 与一个已排图形是否碰撞
+
+    int getPartPairTestCount() const;  // 凸多边形对的检测次数
+    int getPartPairCulledCount() const;  // 凸多边形对被包络矩形/包络圆剔除的次数
+
+private:
+    struct MovingPart
+    {
+        const QVector<QPointF> *points;  // 凸多边形点集
+        QRectF rect;  // 包络矩形，已平移
+        CollisionDectect::CircleInfo circle;  // 包络圆，已平移
+        bool prepared;  // 是否已载入分离轴内核，顶点数超过SAT_MAX_VERTICES时为false
+        SATKernel::PreparedPolygon polygon;  // 平移后的顶点与分离轴，构造时计算一次
+        const QVector<FixedPoint> *fixedPoints;  // 凸多边形的定点坐标(未平移)，未提供时为空
+    };
+
+    bool partCollision(const MovingPart &part, const QVector<QPointF> &pList,
+                       const QPointF &partsOffset,
+                       const QVector<FixedPoint> *fixedList) const;  // 移动图形的一个凸多边形与给定凸多边形是否碰撞
+    bool partCollisionScalar(const MovingPart &part, const QVector<QPointF> &pList,
+                             const QPointF &partsOffset) const;  // 顶点数超出分离轴内核时的逐轴检测
+
+    QVector<MovingPart> movingPartList;  // 移动图形的凸多边形
+    QPointF offset;  // 移动图形的平移量
+    qreal epsilon;  // 重叠量不超过epsilon时视为接触
+    qreal gap;  // 最小间距，距离小于gap时视为碰撞
+    mutable int partPairTestCount;  // 凸多边形对的检测次数
+    mutable int partPairCulledCount;  // 凸多边形对被剔除的次数
+};
+
 
 /**
  * @brief The ConcavePolygonDecompose class
@@ -1,25 +1,12 @@
 ﻿#include "common.h"
+#include "debug.h"
+#include "nofitpolygon.h"
+#include "polygonoffset.h"
+#include <QPair>
 #include <QDebug>
 #include <iostream>
 #include <iomanip>//要加入头文件
-
-void str2int(int &int_temp, const std::string &string_temp)
-{
-    std::stringstream stream(string_temp);
-    stream>>int_temp;
-}
-
-void str2float(float &float_temp, const std::string &string_temp)
-{
-    std::stringstream stream(string_temp);
-    stream>>float_temp;
-}
-
-void str2double(double &double_temp, const std::string &string_temp)
-{
-    std::stringstream stream(string_temp);
-    stream>>double_temp;
-}
+#include <algorithm>
 
 void str2int(int &int_temp, const std::string &string_temp)
 {
@@ -311,6 +298,53 @@ bool pointContainsInRect(const QRectF &rect, const QPointF &point)
     return pointContainsInPolygon(pList, point) || pointOnPolygonBoundary(pList, point);
 }
 
+/**
+ * @brief polygonContainsPolygon
+ * inner的顶点及各边中点都在outer内或边上，且两多边形的边没有交叉时，outer完全包含inner。
+ * 只判断一个顶点时，与outer交叉或凹入部分穿出outer的多边形也会被当作被包含
+ * @param outer 外多边形
+ * @param inner 内多边形
+ * @return 是否完全包含
+ */
+bool polygonContainsPolygon(QVector<QPointF> outer, QVector<QPointF> inner)
+{
+    if(outer.length() > 1 && outer.first() == outer.last()){  // 如果首尾相等时，删除最后一个点
+        outer.removeLast();
+    }
+    if(inner.length() > 1 && inner.first() == inner.last()){
+        inner.removeLast();
+    }
+    int n = outer.length();
+    int m = inner.length();
+    if(n < 3 || m < 1){
+        return false;
+    }
+    for(int i=0; i<m; i++){
+        QPointF a = inner[i];
+        QPointF b = inner[(i+1)%m];
+        QPointF mid = (a + b) / 2;  // 顶点都在outer边上时，边仍可能从凹入处穿出
+        if(!pointContainsInPolygon(outer, a) && !pointOnPolygonBoundary(outer, a)){
+            return false;
+        }
+        if(!pointContainsInPolygon(outer, mid) && !pointOnPolygonBoundary(outer, mid)){
+            return false;
+        }
+        for(int j=0; j<n; j++){
+            QPointF c = outer[j];
+            QPointF d = outer[(j+1)%n];
+            qreal d1 = cross(c, d, a);
+            qreal d2 = cross(c, d, b);
+            qreal d3 = cross(a, b, c);
+            qreal d4 = cross(a, b, d);
+            if(((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0))
+                    && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))){  // 两边交叉
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 qreal cross(QPointF &p1, QPointF &p2, QPointF &p3){
     qreal ret = (p2.rx() - p1.rx()) * (p3.ry() - p1.ry())
             - (p3.rx() - p1.rx()) * (p2.ry() - p1.ry());
@@ -404,6 +438,95 @@ bool lineIntersectWithPolygon(QVector<QPointF> pList, const QLineF &line, QList<
     return true;
 }
 
+/**
+ * @brief sweepHorizontalCrossings  扫描线求各查询水平线与折线各边的交点
+ * 非水平边按y最小值排序，查询按y升序处理，只保留与当前y相交的活动边，
+ * 时间复杂度为O((n+m)log(n+m)+k)，k为交点个数。
+ * 与逐边判断一致：y位于(边的y最小值, 边的y最大值]内才相交，交点按边的起点插值
+ * @param edgePoints  折线顶点，第j条边为edgePoints[j]到edgePoints[j+1]
+ * @param queryYList  查询的y坐标
+ * @param visit  对每个交点调用visit(查询序号, 交点x坐标)
+ */
+template<typename Visitor>
+static void sweepHorizontalCrossings(const QVector<QPointF> &edgePoints, const QVector<qreal> &queryYList, Visitor visit)
+{
+    int edgeCount = edgePoints.length() - 1;
+    if(edgeCount < 1 || queryYList.isEmpty()){
+        return;
+    }
+    QVector<int> edgeOrder;  // 非水平边，按y最小值升序
+    edgeOrder.reserve(edgeCount);
+    for(int j=0; j<edgeCount; j++){
+        if(edgePoints[j].y() != edgePoints[j+1].y()){
+            edgeOrder.append(j);
+        }
+    }
+    auto edgeMinY = [&edgePoints](int j){
+        return qMin(edgePoints[j].y(), edgePoints[j+1].y());
+    };
+    std::sort(edgeOrder.begin(), edgeOrder.end(), [&edgeMinY](int a, int b){
+        return edgeMinY(a) < edgeMinY(b);
+    });
+    QVector<int> queryOrder(queryYList.length());  // 查询按y升序
+    for(int i=0; i<queryOrder.length(); i++){
+        queryOrder[i] = i;
+    }
+    std::sort(queryOrder.begin(), queryOrder.end(), [&queryYList](int a, int b){
+        return queryYList[a] < queryYList[b];
+    });
+
+    QVector<int> activeList;  // 活动边
+    int next = 0;  // 下一条待加入的边
+    foreach (int i, queryOrder) {
+        qreal y = queryYList[i];
+        while(next < edgeOrder.length() && edgeMinY(edgeOrder[next]) < y){
+            activeList.append(edgeOrder[next++]);
+        }
+        int count = 0;
+        for(int k=0; k<activeList.length(); k++){
+            int j = activeList[k];
+            const QPointF &p1 = edgePoints[j];
+            const QPointF &p2 = edgePoints[j+1];
+            if(qMax(p1.y(), p2.y()) < y){  // 已扫过，之后的查询也不会相交
+                continue;
+            }
+            activeList[count++] = j;
+            qreal x = (p2.x()-p1.x())
+                    / (p2.y()-p1.y())
+                    * (y-p1.y())
+                    + p1.x();
+            visit(i, x);
+        }
+        activeList.resize(count);
+    }
+}
+
+/**
+ * @brief verticesToEdgesMaxMinDis  各顶点与另一折线在同一水平线上交点的水平距离的最大值与最小值
+ * @param vertexList  顶点
+ * @param edgePoints  折线顶点
+ * @param disMax  最大距离，只在更大时更新
+ * @param disMin  最小距离，只在更小时更新
+ */
+static void verticesToEdgesMaxMinDis(const QVector<QPointF> &vertexList, const QVector<QPointF> &edgePoints,
+                                     qreal &disMax, qreal &disMin)
+{
+    QVector<qreal> yList;
+    yList.reserve(vertexList.length());
+    foreach (QPointF point, vertexList) {
+        yList.append(point.ry());
+    }
+    sweepHorizontalCrossings(edgePoints, yList, [&](int i, qreal x){
+        qreal dis = qrealPrecision(qAbs(x - vertexList[i].x()), PRECISION);
+        if(dis > disMax){
+            disMax = dis;
+        }
+        if(dis < disMin){
+            disMin = dis;
+        }
+    });
+}
+
 /**
  * @brief calVerToOppSideXDis  计算多边形各顶点到其对边的最大距离，用来求送料步距
  * @param pList  点的集合
@@ -411,37 +534,17 @@ bool lineIntersectWithPolygon(QVector<QPointF> pList, const QLineF &line, QList<
  */
 qreal calVerToOppSideXDis(QVector<QPointF> pList){
     qreal disMax = LONG_MIN;
-    QVector<qreal> disMatrix;
-    int length = pList.length();  // 获取点列表长度
-    // 将x，y坐标分别保存至容器中，方便使用
-    QVector<qreal> xList;
     QVector<qreal> yList;
+    yList.reserve(pList.length());
     foreach (QPointF point, pList) {
-        xList.append(point.rx());
         yList.append(point.ry());
     }
-    int i = 0;
-    while(i<length){
-        int j=0;
-        while(j<length-1){
-            if((yList[i] <= yList[j]
-                && yList[i] > yList[j+1])
-                    || (yList[i] <= yList[j+1]
-                        && yList[i] > yList[j])){
-                qreal x1 = (xList[j+1]-xList[j])
-                        / (yList[j+1]-yList[j])
-                        * (yList[i]-yList[j])
-                        + xList[j];
-                qreal dis = qAbs(x1 - xList[i]);
-                disMatrix.append(dis);
-                if(dis > disMax){
-                    disMax = dis;
-                }
-            }
-            j++;
+    sweepHorizontalCrossings(pList, yList, [&](int i, qreal x){
+        qreal dis = qAbs(x - pList[i].x());
+        if(dis > disMax){
+            disMax = dis;
         }
-        i++;
-    }
+    });
     return qrealPrecision(disMax, PRECISION);
 }
 
@@ -457,114 +560,14 @@ qreal calVerToCrossMaxMinDiff(QVector<QPointF> pList, const qreal step, const qr
 {
     qreal disMax = 0;
     qreal disMin = LONG_MAX;
-    QVector<qreal> disMatrix;
-    int length = pList.length();  // 获取点列表长度
-    // 将多边形原始及右移之后的x，y坐标分别保存至容器中
-    QVector<qreal> xListOrigin;
-    QVector<qreal> yListOrigin;
-    QVector<qreal> xListMove;
-    QVector<qreal> yListMove;
-    foreach (QPointF point, pList) {
-        xListOrigin.append(point.rx());
-        yListOrigin.append(point.ry());
-        xListMove.append(point.rx()+step);
-        yListMove.append(point.ry()+H);
-    }
-    /*
-     * 优化方法，可降低时间复杂度
-    qreal yMaxMove = LONG_MIN;  // 移动后y最大值
-    qreal yMinMove = LONG_MAX;  // 移动后y最小值
-    qreal yMaxMoveX, yMinMoveX;  // y最大值、y最小值对应的x值
+    // 右移、错开之后的点集
+    QVector<QPointF> moveList;
+    moveList.reserve(pList.length());
     foreach (QPointF point, pList) {
-        xListOrigin.append(point.rx());
-        yListOrigin.append(point.ry());
-        xListMove.append(point.rx()+step);
-        yListMove.append(point.ry()+H);
-        if(point.ry()+H > yMaxMove){
-            yMaxMove = point.ry()+H;
-            yMaxMoveX = point.rx()+step;
-        }
-        if(point.ry()+H < yMinMove){
-            yMinMove = point.ry()+H;
-            yMinMoveX = point.rx()+step;
-        }
-    }
-
-    qDebug() << "yMax " << yMaxMove << ", yMin " << yMinMove;
-    qDebug() << "yMaxX " << yMaxMoveX << ", yMinX " << yMinMoveX;
-
-    // 确定内外顶点集合，
-    // 由上下顶点相连，组成连线L，
-    // 在L左边为内顶点，在L右边为右顶点
-    // 可通过判断同y值时x坐标大小来实现
-    // xi < x0，则为左顶点，否则为右顶点
-    QVector<int> insideVer;  // 内顶点集合
-    QVector<int> outsideVer;  // 外顶点集合
-    for(int i=0; i<length; i++){
-        qreal xi = xListMove[i];  // 获取第i个顶点x值
-        qreal yi = xListMove[i];  // 获取第i个顶点y值
-        qreal x0 = (yMaxMoveX-yMinMoveX)
-                / (yMaxMove-yMinMove)
-                * (yi-yMaxMove)
-                + yMaxMoveX;
-        if(xi <= x0){
-            insideVer.append(xi);
-        }
-        if(xi > x0){
-            outsideVer.append(xi);
-        }
-    }
-    */
-
-    int i = 0;
-    while(i<length){
-        int j=0;
-        while(j<length-1){
-            if((yListOrigin[i] <= yListMove[j]
-                && yListOrigin[i] > yListMove[j+1])
-                    || (yListOrigin[i] <= yListMove[j+1]
-                        && yListOrigin[i] > yListMove[j])){
-                qreal x1 = (xListMove[j+1]-xListMove[j])
-                        / (yListMove[j+1]-yListMove[j])
-                        * (yListOrigin[i]-yListMove[j])
-                        + xListMove[j];
-                qreal dis1 = qAbs(x1 - xListOrigin[i]);
-                dis1 = qrealPrecision(dis1, PRECISION);
-                disMatrix.append(dis1);
-                if(dis1 > disMax){
-                    disMax = dis1;
-                }
-                if(dis1 < disMin){
-                    disMin = dis1;
-                }
-            }
-            if((yListMove[i] <= yListOrigin[j]
-                && yListMove[i] > yListOrigin[j+1])
-                    || (yListMove[i] <= yListOrigin[j+1]
-                        && yListMove[i] > yListOrigin[j])){
-                qreal x2 = (xListOrigin[j+1]-xListOrigin[j])
-                        / (yListOrigin[j+1]-yListOrigin[j])
-                        * (yListMove[i]-yListOrigin[j])
-                        + xListOrigin[j];
-                qreal dis2 = qAbs(x2 - xListMove[i]);
-                dis2 = qrealPrecision(dis2, PRECISION);
-                disMatrix.append(dis2);
-                if(dis2 > disMax){
-                    disMax = dis2;
-                }
-                if(dis2 < disMin){
-                    disMin = dis2;
-                }
-            }
-            j++;
-        }
-        i++;
+        moveList.append(QPointF(point.rx()+step, point.ry()+H));
     }
-//    qDebug() << "disMax: " << disMax;
-//    qDebug() << "disMin: " << disMin;
-//    foreach (qreal d, disMatrix) {
-//        qDebug() << "d: " << d;
-//    }
+    verticesToEdgesMaxMinDis(pList, moveList, disMax, disMin);  // 原顶点到错开零件各边
+    verticesToEdgesMaxMinDis(moveList, pList, disMax, disMin);  // 错开零件顶点到原零件各边
     left = qrealPrecision(disMin, PRECISION);  // 左移距离为最小距离
     return qrealPrecision(disMax-disMin, PRECISION);
 }
@@ -583,50 +586,29 @@ qreal calVerToLeftXDis(QVector<QPointF> pList, const qreal H)
     qreal yMin = boundingRect.bottom();  // yMin
     qreal yMax = boundingRect.top();  // yMax
 
-    qreal disMax = 0;
-    QVector<qreal> disMatrix;
+    // 各顶点关于y中心的对称点的y坐标
     int length = pList.length();  // 获取点列表长度
-    // 将x，y坐标分别保存至容器中，方便使用
-    QVector<qreal> xList;
-    QVector<qreal> yList;
+    QVector<qreal> y0List;
+    y0List.reserve(length);
     foreach (QPointF point, pList) {
-        xList.append(point.rx());
-        yList.append(point.ry());
+        y0List.append(yMax + yMin + H - point.ry());
     }
-    int i = 0;
-    while(i<length){
-        qreal dis1 = xList[i] - xMin;  // 顶点到左边界的距离
-        qreal y0 = yMax + yMin + H - yList[i];  // 该顶点关于y中心的对称点的y坐标
-
-        // 下面找出纵坐标为y0时的x坐标
-        qreal dis2Max = 0;  // 平行相交最大距离
-        int j=0;
-        while(j<length-1){
-            if((y0 <= yList[j]
-                && y0 > yList[j+1])
-                    || (y0 <= yList[j+1]
-                        && y0 > yList[j])){
-                qreal x0 = (xList[j+1]-xList[j])
-                        / (yList[j+1]-yList[j])
-                        * (y0-yList[j])
-                        + xList[j];
-                qreal dis2 = qAbs(x0 - xMin);  // 计算距离
-                if(dis2 > dis2Max){
-                    dis2Max = dis2;
-                }
-            }
-            j++;
+    // 找出纵坐标为y0时的x坐标，记录平行相交最大距离
+    QVector<qreal> dis2MaxList(length, 0);
+    sweepHorizontalCrossings(pList, y0List, [&](int i, qreal x0){
+        qreal dis2 = qAbs(x0 - xMin);  // 计算距离
+        if(dis2 > dis2MaxList[i]){
+            dis2MaxList[i] = dis2;
         }
-        disMatrix.append(dis1+dis2Max);
-        if(dis1+dis2Max > disMax){
-            disMax = dis1+dis2Max;
+    });
+
+    qreal disMax = 0;
+    for(int i=0; i<length; i++){
+        qreal dis1 = pList[i].rx() - xMin;  // 顶点到左边界的距离
+        if(dis1+dis2MaxList[i] > disMax){
+            disMax = dis1+dis2MaxList[i];
         }
-        i++;
     }
-//    qDebug() << "disMax: " << disMax;
-//    foreach (qreal d, disMatrix) {
-//        qDebug() << "d: " << d;
-//    }
     return qrealPrecision(disMax, PRECISION);
 }
 
@@ -639,74 +621,9 @@ qreal calVerToLeftXDis(QVector<QPointF> pList, const qreal H)
 qreal cal2PolygonMaxMinDiff(QVector<QPointF> pList1, QVector<QPointF> pList2){
     qreal disMax = 0;
     qreal disMin = LONG_MAX;
-    QVector<qreal> disMatrix;
-    int length1 = pList1.length();  // 获取多边形1点列表长度
-    int length2 = pList2.length();  // 获取多边形2点列表长度
-    QVector<qreal> xList1;
-    QVector<qreal> yList1;
-    QVector<qreal> xList2;
-    QVector<qreal> yList2;
-    foreach (QPointF point, pList1) {
-        xList1.append(point.rx());
-        yList1.append(point.ry());
-    }
-    foreach (QPointF point, pList2) {
-        xList2.append(point.rx());
-        yList2.append(point.ry());
-    }
-    int i = 0;
-    while(i<length1){
-        int j=0;
-        while(j<length2-1){
-            if((yList1[i] <= yList2[j]
-                && yList1[i] > yList2[j+1])
-                    || (yList1[i] <= yList2[j+1]
-                        && yList1[i] > yList2[j])){
-                qreal x1 = (xList2[j+1]-xList2[j])
-                        / (yList2[j+1]-yList2[j])
-                        * (yList1[i]-yList2[j])
-                        + xList2[j];
-                qreal dis1 = qAbs(x1 - xList1[i]);
-                dis1 = qrealPrecision(dis1, PRECISION);
-                disMatrix.append(dis1);
-                if(dis1 > disMax){
-                    disMax = dis1;
-                }
-                if(dis1 < disMin){
-                    disMin = dis1;
-                }
-            }
-            j++;
-        }
-        i++;
-    }
+    verticesToEdgesMaxMinDis(pList1, pList2, disMax, disMin);  // 多边形1顶点到多边形2各边
 #if 1
-    i = 0;
-    while(i<length2){
-        int j = 0;
-        while(j<length1-1){
-            if((yList2[i] <= yList1[j]
-                && yList2[i] > yList1[j+1])
-                    || (yList2[i] <= yList1[j+1]
-                        && yList2[i] > yList1[j])){
-                qreal x2 = (xList1[j+1]-xList1[j])
-                        / (yList1[j+1]-yList1[j])
-                        * (yList2[i]-yList1[j])
-                        + xList1[j];
-                qreal dis2 = qAbs(x2 - xList2[i]);
-                dis2 = qrealPrecision(dis2, PRECISION);
-                disMatrix.append(dis2);
-                if(dis2 > disMax){
-                    disMax = dis2;
-                }
-                if(dis2 < disMin){
-                    disMin = dis2;
-                }
-            }
-            j++;
-        }
-        i++;
-    }
+    verticesToEdgesMaxMinDis(pList2, pList1, disMax, disMin);  // 多边形2顶点到多边形1各边
 #endif
     return qrealPrecision(disMax-disMin, PRECISION);
 }
@@ -777,12 +694,18 @@ bool isConcaveConvex(QPointF ppoint,QPointF cpoint,QPointF npoint,bool direction
     }
 }
 
-double calculatePloygonMinBoundingRectArea(QVector<QPointF> points, qreal &alpha, QRectF &minBoundingRect){
-    QPointF maxp,minp,centerpont = QPointF(0,0); //calculatePolygonGravityCenter(points);
+#ifdef MINBOUNDINGRECTCHECK
+/**
+ * @brief calculatePloygonMinBoundingRectAreaByEdges
+ * 原实现：对每条边将所有点旋转一次，复杂度O(n²)，只用于与旋转卡壳的结果对比
+ */
+static double calculatePloygonMinBoundingRectAreaByEdges(QVector<QPointF> points, qreal &alpha, QRectF &minBoundingRect){
+    QPointF maxp,minp,centerpont = QPointF(0,0);
     QVector<QPointF> listpoint;
-    qreal angles[points.length()];
-    double area,areas[points.length()];
-    int minid,w,h;
+    QVector<qreal> angles(points.length());
+    QVector<double> areas(points.length());
+    double area;
+    int minid = 0;
     for(int i=0;i<points.length();i++){
         QLineF line0(points[i], QPointF(points[i].rx() + 10, points[i].ry()));
         QLineF line1(points[i], points[(i+1)%points.length()]);
@@ -794,25 +717,15 @@ double calculatePloygonMinBoundingRectArea(QVector<QPointF> points, qreal &alpha
         }
         maxp = minp = cpoints[0];
         for(int j=1;j<points.length();j++){
-            if(maxp.rx() < cpoints[j].rx()){
-                maxp.rx() = cpoints[j].rx();
-            }
-            if(maxp.ry() < cpoints[j].ry()){
-                maxp.ry() = cpoints[j].ry();
-            }
-            if(minp.rx() > cpoints[j].rx()){
-                minp.rx() = cpoints[j].rx();
-            }
-            if(minp.ry() > cpoints[j].ry()){
-                minp.ry() = cpoints[j].ry();
-            }
+            maxp.rx() = qMax(maxp.rx(), cpoints[j].rx());
+            maxp.ry() = qMax(maxp.ry(), cpoints[j].ry());
+            minp.rx() = qMin(minp.rx(), cpoints[j].rx());
+            minp.ry() = qMin(minp.ry(), cpoints[j].ry());
         }
         angles[i]=angle;
         listpoint.append(maxp);
         listpoint.append(minp);
-        //qDebug() << maxp << "   " << minp;
         areas[i]= (maxp.rx()-minp.rx())*(maxp.ry()-minp.ry());
-        //qDebug()<<i<<"面积"<<areas[i];
     }
     area=areas[0];
     for(int i=0;i<points.length();i++){
@@ -822,54 +735,659 @@ double calculatePloygonMinBoundingRectArea(QVector<QPointF> points, qreal &alpha
         }
     }
     alpha=angles[minid];
-//    QVector<QPointF> cpoints;
-//    for(int j=0;j<points.length();j++){
-//        cpoints.append(transformRotate(centerpont, points[j], -alpha));
-//    }
-//    points.clear();
-//    points.append(cpoints);
-    w=abs(listpoint[minid*2].rx()-listpoint[minid*2+1].rx());
-    h=abs(listpoint[minid*2].ry()-listpoint[minid*2+1].ry());
-    minBoundingRect.setRect(listpoint[minid*2+1].rx(), listpoint[minid*2+1].ry(),w,h);
-    //qDebug()<<"最小包络id:"<<minid<<"面积:"<<area<<"角度："<<angles[minid];
+    minBoundingRect.setRect(listpoint[minid*2+1].rx(), listpoint[minid*2+1].ry(),
+                            listpoint[minid*2].rx()-listpoint[minid*2+1].rx(),
+                            listpoint[minid*2].ry()-listpoint[minid*2+1].ry());
     return area;
 }
+#endif
 
-//QRectF getLineBoundingRect(QLineF line)
-//{
-//    qreal deltaX = line.p1().rx() - line.p2().rx();
-//    qreal deltaY = line.p1().rx() - line.p2().rx();
-//    qreal len = qSqrt(qPow(deltaX, 2) + qPow(deltaY, 2));
-//    if(line.angle() >= 0 || line.angle() <= 90){
-//        //setRect(line.p1().rx()-4, line.p1.rx()+4, );
-//    }
-//}
+/**
+ * @brief calculatePloygonMinBoundingRectArea
+ * 最小面积包络矩形的一条边一定与凸包的某条边共线，
+ * 先求凸包(Andrew单调链)，再用旋转卡壳依次以凸包各边为底边，
+ * 另外三个方向的支撑点随底边单调前进，总复杂度O(n log n)。
+ * 凸包与原多边形同向，与原多边形共线的底边方向一致；
+ * 面积相同时优先取不旋转(alpha为0)的结果
+ * @param points 多边形点集
+ * @param alpha 最小包络矩形对应的旋转角度，点集旋转-alpha度后包络矩形与坐标轴平行
+ * @param minBoundingRect 点集旋转-alpha度之后的外包矩形
+ * @return 最小包络矩形面积
+ */
+double calculatePloygonMinBoundingRectArea(QVector<QPointF> points, qreal &alpha, QRectF &minBoundingRect){
+    alpha = 0;
+    minBoundingRect = QRectF();
+    if(points.isEmpty()){
+        return 0;
+    }
+    QVector<QPointF> hull = NoFitPolygon::convexHull(points);
+    int h = hull.length();
+    // 凸包按原多边形的方向排列
+    qreal polygonArea = 0;
+    for(int i=0; i<points.length(); i++){
+        const QPointF &a = points[i];
+        const QPointF &b = points[(i+1)%points.length()];
+        polygonArea += a.x() * b.y() - b.x() * a.y();
+    }
+    if(polygonArea < 0){
+        std::reverse(hull.begin(), hull.end());
+    }
 
-QPointF transformY(QPointF p)
+    // 不旋转时的外包矩形
+    QPointF minp = hull[0], maxp = hull[0];
+    for(int i=1; i<h; i++){
+        minp.rx() = qMin(minp.x(), hull[i].x());
+        minp.ry() = qMin(minp.y(), hull[i].y());
+        maxp.rx() = qMax(maxp.x(), hull[i].x());
+        maxp.ry() = qMax(maxp.y(), hull[i].y());
+    }
+    double area = (maxp.x() - minp.x()) * (maxp.y() - minp.y());
+    minBoundingRect.setRect(minp.x(), minp.y(), maxp.x() - minp.x(), maxp.y() - minp.y());
+    if(h < 3){
+        return area;
+    }
+
+    // 去掉几乎重合的顶点，过短的边方向不可靠，会使支撑点停在错误的位置
+    qreal minLength = 1e-9 * qMax(maxp.x() - minp.x(), maxp.y() - minp.y());
+    QVector<QPointF> hullTmp;
+    for(int i=0; i<h; i++){
+        if(hullTmp.isEmpty() || getDistance(hullTmp.last(), hull[i]) > minLength){
+            hullTmp.append(hull[i]);
+        }
+    }
+    while(hullTmp.length() > 1 && getDistance(hullTmp.last(), hullTmp.first()) <= minLength){
+        hullTmp.removeLast();
+    }
+    hull = hullTmp;
+    h = hull.length();
+    if(h < 3){
+        return area;
+    }
+
+    // 旋转卡壳，u为底边方向，v为底边法向(指向凸包内部或外部均可，只取投影范围)
+    auto dot = [](const QPointF &p, const QPointF &d){ return p.x() * d.x() + p.y() * d.y(); };
+    double minArea = area;
+    int minEdge = -1;
+    int uMax = 0, uMin = 0, vFar = 0;  // 底边方向最远、最近与距底边最远的顶点
+    for(int i=0; i<h; i++){
+        QPointF edge = hull[(i+1)%h] - hull[i];
+        qreal length = qSqrt(edge.x() * edge.x() + edge.y() * edge.y());
+        QPointF u(edge.x() / length, edge.y() / length);
+        QPointF v(-u.y(), u.x());
+        if(i == 0){  // 第一条边，线性扫描初始化支撑点
+            for(int j=1; j<h; j++){
+                if(dot(hull[j], u) > dot(hull[uMax], u)){
+                    uMax = j;
+                }
+                if(dot(hull[j], u) < dot(hull[uMin], u)){
+                    uMin = j;
+                }
+                if(qAbs(dot(hull[j] - hull[i], v)) > qAbs(dot(hull[vFar] - hull[i], v))){
+                    vFar = j;
+                }
+            }
+        } else{
+            while(dot(hull[(uMax+1)%h], u) > dot(hull[uMax], u)){
+                uMax = (uMax + 1) % h;
+            }
+            while(qAbs(dot(hull[(vFar+1)%h] - hull[i], v)) > qAbs(dot(hull[vFar] - hull[i], v))){
+                vFar = (vFar + 1) % h;
+            }
+            while(dot(hull[(uMin+1)%h], u) < dot(hull[uMin], u)){
+                uMin = (uMin + 1) % h;
+            }
+        }
+        double edgeArea = (dot(hull[uMax], u) - dot(hull[uMin], u)) * qAbs(dot(hull[vFar] - hull[i], v));
+        if(edgeArea < minArea * (1 - 1e-12)){
+            minArea = edgeArea;
+            minEdge = i;
+        }
+    }
+
+    if(minEdge >= 0){
+        // 与原实现相同：点集旋转-alpha度之后求外包矩形
+        alpha = QLineF(hull[minEdge], hull[(minEdge+1)%h]).angle();
+        QPointF center(0, 0);
+        minp = maxp = transformRotate(center, hull[0], -alpha);
+        for(int i=1; i<h; i++){
+            QPointF p = transformRotate(center, hull[i], -alpha);
+            minp.rx() = qMin(minp.x(), p.x());
+            minp.ry() = qMin(minp.y(), p.y());
+            maxp.rx() = qMax(maxp.x(), p.x());
+            maxp.ry() = qMax(maxp.y(), p.y());
+        }
+        area = (maxp.x() - minp.x()) * (maxp.y() - minp.y());
+        minBoundingRect.setRect(minp.x(), minp.y(), maxp.x() - minp.x(), maxp.y() - minp.y());
+    }
+
+#ifdef MINBOUNDINGRECTCHECK
+    qreal checkAlpha;
+    QRectF checkRect;
+    double checkArea = calculatePloygonMinBoundingRectAreaByEdges(points, checkAlpha, checkRect);
+    if(area > checkArea * (1 + 1e-9) + 1e-9){
+        qDebug() << "min bounding rect mismatch:" << area << alpha << checkArea << checkAlpha;
+    }
+#endif
+    return area;
+}
+
+/**
+ * @brief simplifyPolylineDouglasPeucker
+ * Douglas-Peucker简化折线，保留首尾两点，删去的点到保留线段的距离不超过tolerance
+ * @param points 折线点集
+ * @param tolerance 允许误差
+ * @return 简化后的点集
+ */
+QVector<QPointF> simplifyPolylineDouglasPeucker(const QVector<QPointF> &points, qreal tolerance)
 {
-    return QPointF(p.rx(), -p.ry());
+    int n = points.length();
+    if(n < 3){
+        return points;
+    }
+    QVector<bool> keep(n, false);
+    keep[0] = keep[n-1] = true;
+    QVector<QPair<int, int>> stack;  // 待处理区间，避免递归过深
+    stack.append(qMakePair(0, n-1));
+    while(!stack.isEmpty()){
+        QPair<int, int> range = stack.takeLast();
+        const QPointF &a = points[range.first];
+        const QPointF &b = points[range.second];
+        QPointF ab = b - a;
+        qreal length = qSqrt(ab.x() * ab.x() + ab.y() * ab.y());
+        qreal maxDis = -1;
+        int index = -1;
+        for(int i=range.first+1; i<range.second; i++){
+            QPointF ap = points[i] - a;
+            qreal dis;
+            if(length == 0){
+                dis = qSqrt(ap.x() * ap.x() + ap.y() * ap.y());
+            } else{
+                qreal t = qBound(qreal(0), (ap.x() * ab.x() + ap.y() * ab.y()) / (length * length), qreal(1));
+                QPointF d = ap - t * ab;
+                dis = qSqrt(d.x() * d.x() + d.y() * d.y());  // 到线段(而不是直线)的距离
+            }
+            if(dis > maxDis){
+                maxDis = dis;
+                index = i;
+            }
+        }
+        if(index >= 0 && maxDis > tolerance){
+            keep[index] = true;
+            stack.append(qMakePair(range.first, index));
+            stack.append(qMakePair(index, range.second));
+        }
+    }
+    QVector<QPointF> res;
+    for(int i=0; i<n; i++){
+        if(keep[i]){
+            res.append(points[i]);
+        }
+    }
+    return res;
 }
 
-QPointF transformRotate(QPointF o, qreal r, qreal angle)
+/**
+ * @brief pointToSegmentDistance 点到线段的距离
+ */
+static qreal pointToSegmentDistance(const QPointF &p, const QPointF &a, const QPointF &b)
 {
-    QPointF res(o.rx()+r*qCos(M_PI*angle/180),
-                o.ry()+r*qSin(M_PI*angle/180));
+    QPointF ab = b - a;
+    QPointF ap = p - a;
+    qreal length2 = ab.x() * ab.x() + ab.y() * ab.y();
+    qreal t = length2 == 0 ? 0 : qBound(qreal(0), (ap.x() * ab.x() + ap.y() * ab.y()) / length2, qreal(1));
+    QPointF d = ap - t * ab;
+    return qSqrt(d.x() * d.x() + d.y() * d.y());
+}
+
+/**
+ * @brief segmentsIntersect 判断两线段是否相交(含端点接触)
+ */
+static bool segmentsIntersect(const QPointF &a1, const QPointF &a2, const QPointF &b1, const QPointF &b2)
+{
+    auto orient = [](const QPointF &o, const QPointF &p, const QPointF &q){
+        return (p.x() - o.x()) * (q.y() - o.y()) - (p.y() - o.y()) * (q.x() - o.x());
+    };
+    qreal d1 = orient(b1, b2, a1);
+    qreal d2 = orient(b1, b2, a2);
+    qreal d3 = orient(a1, a2, b1);
+    qreal d4 = orient(a1, a2, b2);
+    if(((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))){
+        return true;
+    }
+    auto onSegment = [](const QPointF &p, const QPointF &q, const QPointF &r){  // 共线时r在线段pq上
+        return qMin(p.x(), q.x()) <= r.x() && r.x() <= qMax(p.x(), q.x())
+                && qMin(p.y(), q.y()) <= r.y() && r.y() <= qMax(p.y(), q.y());
+    };
+    return (d1 == 0 && onSegment(b1, b2, a1)) || (d2 == 0 && onSegment(b1, b2, a2))
+            || (d3 == 0 && onSegment(a1, a2, b1)) || (d4 == 0 && onSegment(a1, a2, b2));
+}
+
+/**
+ * @brief simplifyPolygonConservative
+ * 保守简化多边形，用于碰撞检测：
+ * 1. 闭合多边形以最远的两顶点分为两段折线，分别用Douglas-Peucker简化，删去的顶点离简化轮廓不超过tolerance；
+ * 2. 简化轮廓按斜接方式向外偏移tolerance+clearance(PolygonOffset)；
+ * 3. 检查结果为简单多边形且与原多边形的边不相交、包含原多边形的顶点，即完全包含原多边形。
+ * 顶点数没有减少或检查不通过时返回空点集，调用方应继续使用原多边形
+ * @param points 多边形点集，可以首尾重复
+ * @param tolerance 简化允许误差
+ * @param margin 结果超出原多边形的最大距离，零件任意旋转后外包矩形按此值扩大即可包含简化轮廓
+ * @param clearance 额外的外扩量，用于抵消坐标取整的误差
+ * @return 首尾相连的简化轮廓，失败时为空
+ */
+QVector<QPointF> simplifyPolygonConservative(QVector<QPointF> points, qreal tolerance, qreal &margin, qreal clearance)
+{
+    margin = 0;
+    if(points.length() > 1 && points.first() == points.last()){  // 首尾相连时，删除最后一点
+        points.removeLast();
+    }
+    int n = points.length();
+    if(n < 4 || tolerance <= 0){
+        return QVector<QPointF>();
+    }
+    qreal signedArea = 0;
+    for(int i=0; i<n; i++){
+        const QPointF &a = points[i];
+        const QPointF &b = points[(i+1)%n];
+        signedArea += a.x() * b.y() - b.x() * a.y();
+    }
+    if(signedArea < 0){  // 统一为逆时针，外法线在边的右侧
+        std::reverse(points.begin(), points.end());
+    }
+
+    // Step1: 以离0号点最远的顶点为界分为两段折线分别简化
+    int far = 0;
+    qreal farDis = -1;
+    for(int i=1; i<n; i++){
+        qreal dis = getDistance(points[0], points[i]);
+        if(dis > farDis){
+            farDis = dis;
+            far = i;
+        }
+    }
+    QVector<QPointF> chain1 = points.mid(0, far + 1);
+    QVector<QPointF> chain2 = points.mid(far);
+    chain2.append(points[0]);
+    QVector<QPointF> simplified = simplifyPolylineDouglasPeucker(chain1, tolerance);
+    simplified.removeLast();
+    QVector<QPointF> simplified2 = simplifyPolylineDouglasPeucker(chain2, tolerance);
+    simplified2.removeLast();
+    simplified += simplified2;
+    int m = simplified.length();
+    if(m < 3 || m >= n){
+        return QVector<QPointF>();
+    }
+
+    // Step2: 简化轮廓向外偏移，内凹处的自相交由PolygonOffset消除
+    PolygonOffset polygonOffset(PolygonOffset::MiterJoin, 2);
+    QVector<QPointF> res = polygonOffset.outerOutline(simplified, tolerance + clearance);
+    if(res.isEmpty()){
+        return QVector<QPointF>();
+    }
+    res.removeLast();
+    if(res.length() >= n){
+        return QVector<QPointF>();
+    }
+
+    // Step3: 检查简单多边形，且与原多边形的边不相交
+    int r = res.length();
+    for(int i=0; i<r; i++){
+        const QPointF &a1 = res[i];
+        const QPointF &a2 = res[(i+1)%r];
+        for(int j=i+2; j<r; j++){
+            if(i == 0 && j == r - 1){  // 相邻边
+                continue;
+            }
+            if(segmentsIntersect(a1, a2, res[j], res[(j+1)%r])){
+                return QVector<QPointF>();
+            }
+        }
+        for(int j=0; j<n; j++){
+            if(segmentsIntersect(a1, a2, points[j], points[(j+1)%n])){
+                return QVector<QPointF>();
+            }
+        }
+    }
+    res.append(res.first());
+    if(!pointContainsInPolygon(res, points[0])){
+        return QVector<QPointF>();
+    }
+
+    // 结果超出原多边形的最大距离，外包矩形的边界总在顶点处取得，只需统计顶点
+    for(int i=0; i<r; i++){
+        qreal dis = LONG_MAX;
+        for(int j=0; j<n; j++){
+            dis = qMin(dis, pointToSegmentDistance(res[i], points[j], points[(j+1)%n]));
+        }
+        margin = qMax(margin, dis);
+    }
     return res;
 }
 
-QPointF transformRotate(QPointF o, QPointF p, qreal angle)
+/**
+ * @brief arcSegmentCount 圆弧按弦高误差离散所需的段数
+ * 圆心角为θ的弦，弦高为r(1-cos(θ/2))，故每段圆心角不超过2acos(1-tolerance/r)
+ * @param radius 半径
+ * @param sweep 圆心角(弧度)
+ * @param tolerance 弦高误差
+ * @return 段数，至少为1
+ */
+static int arcSegmentCount(qreal radius, qreal sweep, qreal tolerance)
 {
-    // 将点映射到普通平面直角坐标系
-    qreal ox = o.rx();
-    qreal oy = -o.ry();
-    qreal px = p.rx();
-    qreal py = -p.ry();
-    qreal a = M_PI*angle/180;
-    qreal rx= (px - ox)*qCos(a) - (py - oy)*qSin(a) + ox;
-    qreal ry= (px - ox)*qSin(a) + (py - oy)*qCos(a) + oy;
-    return QPointF(rx, -ry);
+    sweep = qAbs(sweep);
+    if(radius <= 0 || sweep == 0){
+        return 1;
+    }
+    qreal step = M_PI / 2;  // 每段圆心角不超过90度，避免误差很大时形状失真
+    if(tolerance > 0 && tolerance < radius){
+        step = qMin(step, 2 * qAcos(1 - tolerance / radius));
+    }
+    return qBound(1, qCeil(sweep / step), 100000);
+}
+
+/**
+ * @brief tessellateArc 圆弧离散为折线，端点在圆弧上，弦高不超过tolerance
+ * @param center 圆心
+ * @param radius 半径
+ * @param startAngle 起始角度(度)
+ * @param endAngle 终止角度(度)，从起始角度逆时针转到终止角度，两者相等时为整圆
+ * @param tolerance 弦高误差
+ * @return 从起点到终点的点集，整圆时首尾相同
+ */
+QVector<QPointF> tessellateArc(const QPointF &center, qreal radius, qreal startAngle, qreal endAngle, qreal tolerance)
+{
+    qreal sweep = endAngle - startAngle;
+    while(sweep <= 0){
+        sweep += 360;
+    }
+    while(sweep > 360){
+        sweep -= 360;
+    }
+    int n = arcSegmentCount(radius, sweep * M_PI / 180, tolerance);
+    QVector<QPointF> res;
+    res.reserve(n + 1);
+    for(int i=0; i<=n; i++){
+        res.append(transformRotate(center, radius, startAngle + sweep * i / n));
+    }
+    if(sweep == 360){
+        res[n] = res[0];
+    }
+    return res;
+}
+
+/**
+ * @brief tessellateEllipse 椭圆弧离散为折线
+ * 按曲率半径R(t)=(a²sin²t+b²cos²t)^1.5/(ab)逐段确定参数步长，曲率大处点密，曲率小处点疏
+ * @param center 中心
+ * @param majorAxis 长轴端点相对中心的向量
+ * @param ratio 短轴与长轴之比
+ * @param startParam 起始参数(弧度)
+ * @param endParam 终止参数(弧度)，两者相等时为整个椭圆
+ * @param tolerance 弦高误差
+ * @return 从起点到终点的点集，整个椭圆时首尾相同
+ */
+QVector<QPointF> tessellateEllipse(const QPointF &center, const QPointF &majorAxis, qreal ratio,
+                                   qreal startParam, qreal endParam, qreal tolerance)
+{
+    qreal a = qSqrt(majorAxis.x() * majorAxis.x() + majorAxis.y() * majorAxis.y());
+    qreal b = a * qAbs(ratio);
+    qreal sweep = endParam - startParam;
+    while(sweep <= 0){
+        sweep += 2 * M_PI;
+    }
+    while(sweep > 2 * M_PI){
+        sweep -= 2 * M_PI;
+    }
+    bool full = qAbs(sweep - 2 * M_PI) < 1e-9;
+    if(full){
+        sweep = 2 * M_PI;
+    }
+    QVector<QPointF> res;
+    if(a == 0){
+        res.append(center);
+        return res;
+    }
+    QPointF u = majorAxis / a;  // 长轴方向
+    QPointF v(-u.y(), u.x());  // 短轴方向
+    auto pointAt = [&](qreal t){
+        return center + a * qCos(t) * u + b * qSin(t) * v;
+    };
+    auto paramStep = [&](qreal t){  // 参数t处的步长，弦高不超过tolerance
+        qreal s = qSin(t), c = qCos(t);
+        qreal speed = qSqrt(a * a * s * s + b * b * c * c);
+        if(b == 0 || speed == 0){
+            return qreal(M_PI / 2);
+        }
+        qreal r = speed * speed * speed / (a * b);
+        qreal angleStep = M_PI / 2;
+        if(tolerance > 0 && tolerance < r){
+            angleStep = qMin(angleStep, 2 * qAcos(1 - tolerance / r));
+        }
+        return qMin(qreal(M_PI / 2), angleStep * r / speed);
+    };
+
+    // 曲率在每个四分之一周期内单调，步长不跨越t=kπ/2，取两端较小的步长即可保证误差
+    qreal minStep = sweep / 100000;
+    qreal t = 0;
+    res.append(pointAt(startParam));
+    while(t < sweep){
+        qreal next = (qFloor((startParam + t) / (M_PI / 2) + 1e-9) + 1) * (M_PI / 2) - startParam;
+        qreal end = qMin(next, sweep);
+        qreal dt = paramStep(startParam + t);
+        dt = qMin(dt, paramStep(startParam + qMin(t + dt, end)));
+        dt = qMax(dt, minStep);
+        t = end - t <= dt ? end : t + dt;
+        res.append(pointAt(startParam + t));
+    }
+    if(full){
+        res.last() = res.first();
+    }
+    return res;
+}
+
+/**
+ * @brief tessellatePolylineBulge 带凸度的多段线离散为折线
+ * 凸度bulge=tan(θ/4)，θ为该顶点到下一顶点的圆弧圆心角，正值逆时针，0为直线段
+ * @param points 顶点
+ * @param bulges 各顶点的凸度，长度与points相同
+ * @param closed 是否闭合，闭合时最后一个顶点的凸度作用于回到首点的线段
+ * @param tolerance 弦高误差
+ * @return 离散后的点集，闭合时首尾相同
+ */
+QVector<QPointF> tessellatePolylineBulge(const QVector<QPointF> &points, const QVector<qreal> &bulges,
+                                         bool closed, qreal tolerance)
+{
+    int n = points.length();
+    QVector<QPointF> res;
+    if(n == 0){
+        return res;
+    }
+    res.append(points[0]);
+    int segments = closed ? n : n - 1;
+    for(int i=0; i<segments; i++){
+        const QPointF &p1 = points[i];
+        const QPointF &p2 = points[(i+1)%n];
+        qreal bulge = i < bulges.length() ? bulges[i] : 0;
+        QPointF d = p2 - p1;
+        if(qAbs(bulge) < 1e-10 || d.isNull()){
+            res.append(p2);
+            continue;
+        }
+        // 圆心在弦中点沿左法线偏移d(1-bulge²)/(4bulge)处
+        QPointF center = (p1 + p2) / 2 + QPointF(-d.y(), d.x()) * (1 - bulge * bulge) / (4 * bulge);
+        qreal radius = getDistance(center, p1);
+        qreal sweep = 4 * qAtan(bulge);
+        qreal startAngle = qAtan2(p1.y() - center.y(), p1.x() - center.x());
+        int m = arcSegmentCount(radius, sweep, tolerance);
+        for(int j=1; j<m; j++){
+            qreal angle = startAngle + sweep * j / m;
+            res.append(center + radius * QPointF(qCos(angle), qSin(angle)));
+        }
+        res.append(p2);
+    }
+    return res;
+}
+
+/**
+ * @brief brentMinimize Brent法求一维函数在[a,b]上的极小值点
+ * 可行时用过最近三点的抛物线插值，否则按黄金分割缩小区间，
+ * 只接受不大于当前最小值的点，结果不差于初始点
+ * @param f 目标函数
+ * @param a 区间下限
+ * @param b 区间上限
+ * @param x 初始点，应位于[a,b]内
+ * @param fx 输入为f(x)，输出为极小值
+ * @param tolerance 极小值点的精度
+ * @param maxEvaluations 最大求值次数
+ * @param evaluations 累加实际求值次数
+ * @return 极小值点
+ */
+qreal brentMinimize(const std::function<qreal(qreal)> &f, qreal a, qreal b, qreal x, qreal &fx,
+                    qreal tolerance, int maxEvaluations, int &evaluations)
+{
+    const qreal goldenRatio = 0.3819660;  // (3-√5)/2
+    tolerance = qMax(tolerance, qreal(1e-9));
+    qreal w = x, v = x;  // 次小值点与上一次的次小值点
+    qreal fw = fx, fv = fx;
+    qreal d = 0, e = 0;  // 本次与上上次的步长
+    for(int i=0; i<maxEvaluations; i++){
+        qreal xm = (a + b) / 2;
+        qreal tol1 = tolerance / 2;
+        qreal tol2 = tolerance;
+        if(qAbs(x - xm) <= tol2 - (b - a) / 2){  // 区间已足够小
+            break;
+        }
+        bool golden = true;
+        if(qAbs(e) > tol1){  // 抛物线插值
+            qreal r = (x - w) * (fx - fv);
+            qreal q = (x - v) * (fx - fw);
+            qreal p = (x - v) * q - (x - w) * r;
+            q = 2 * (q - r);
+            if(q > 0){
+                p = -p;
+            }
+            q = qAbs(q);
+            qreal eTemp = e;
+            e = d;
+            if(qAbs(p) < qAbs(q * eTemp / 2) && p > q * (a - x) && p < q * (b - x)){
+                d = p / q;
+                qreal u = x + d;
+                if(u - a < tol2 || b - u < tol2){
+                    d = xm >= x ? tol1 : -tol1;
+                }
+                golden = false;
+            }
+        }
+        if(golden){  // 黄金分割
+            e = x >= xm ? a - x : b - x;
+            d = goldenRatio * e;
+        }
+        qreal u = qAbs(d) >= tol1 ? x + d : x + (d >= 0 ? tol1 : -tol1);
+        qreal fu = f(u);
+        evaluations++;
+        if(fu <= fx){
+            if(u >= x){
+                a = x;
+            } else{
+                b = x;
+            }
+            v = w;
+            fv = fw;
+            w = x;
+            fw = fx;
+            x = u;
+            fx = fu;
+        } else{
+            if(u < x){
+                a = u;
+            } else{
+                b = u;
+            }
+            if(fu <= fw || w == x){
+                v = w;
+                fv = fw;
+                w = u;
+                fw = fu;
+            } else if(fu <= fv || v == x || v == w){
+                v = u;
+                fv = fu;
+            }
+        }
+    }
+    return x;
+}
+
+/**
+ * @brief minimizeRotateAngle 旋转角度优化
+ * 先按coarseStep粗扫描，上限角度不在步长上时也参与扫描，再在各局部极小值两侧的粗扫描区间内用Brent法细化。
+ * 角度按0.001°取整；只接受更小的目标值，结果不差于粗扫描，coarseStep为1时不差于1°遍历
+ * @param objective 目标函数，不可行时返回不小于LONG_MAX的值
+ * @param minAngle 旋转最小角度
+ * @param maxAngle 旋转最大角度
+ * @param coarseStep 粗扫描步长
+ * @param tolerance 细化的角度精度
+ * @param maxEvaluations 每个极小值细化的最大求值次数，不大于0时只做粗扫描
+ * @param alpha 最佳旋转角度
+ * @param evaluations 累加实际求值次数
+ * @return 最小目标值，均不可行时为LONG_MAX
+ */
+qreal minimizeRotateAngle(const std::function<qreal(qreal)> &objective, int minAngle, int maxAngle, int coarseStep,
+                          qreal tolerance, int maxEvaluations, qreal &alpha, int &evaluations)
+{
+    std::function<qreal(qreal)> f = [&objective](qreal angle){
+        return objective(qRound(angle * 1000) / 1000.0);
+    };
+    coarseStep = qMax(coarseStep, 1);
+    alpha = minAngle;
+    qreal minZ = LONG_MAX;
+    QVector<int> angleList;  // 粗扫描的角度
+    QVector<qreal> valueList;  // 粗扫描的目标值
+    for(int i=minAngle; ; i+=coarseStep){
+        int angle = qMin(i, maxAngle);
+        qreal z = f(angle);
+        angleList.append(angle);
+        valueList.append(z);
+        if(z < minZ){
+            minZ = z;
+            alpha = angle;
+        }
+        if(angle >= maxAngle){
+            break;
+        }
+    }
+    evaluations += valueList.length();
+
+    for(int k=0; maxEvaluations>0 && k<valueList.length(); k++){
+        qreal z = valueList[k];
+        if(z >= LONG_MAX
+                || (k > 0 && valueList[k-1] < z)
+                || (k < valueList.length() - 1 && valueList[k+1] < z)){  // 只细化局部极小值
+            continue;
+        }
+        qreal lower = angleList[qMax(k - 1, 0)];
+        qreal upper = angleList[qMin(k + 1, angleList.length() - 1)];
+        if(upper - lower <= tolerance){
+            continue;
+        }
+        qreal angle = brentMinimize(f, lower, upper, angleList[k], z, tolerance, maxEvaluations, evaluations);
+        if(z < minZ){
+            minZ = z;
+            alpha = qRound(angle * 1000) / 1000.0;
+        }
+    }
+    return minZ;
 }
 
+//QRectF getLineBoundingRect(QLineF line)
+//{
+//    qreal deltaX = line.p1().rx() - line.p2().rx();
+//    qreal deltaY = line.p1().rx() - line.p2().rx();
+//    qreal len = qSqrt(qPow(deltaX, 2) + qPow(deltaY, 2));
+//    if(line.angle() >= 0 || line.angle() <= 90){
+//        //setRect(line.p1().rx()-4, line.p1.rx()+4, );
+//    }
+//}
+
 qreal getDistance(QPointF p1, QPointF p2)
 {
     qreal px1 = p1.rx();
@@ -946,9 +1464,6 @@ void drawLineWithArrow(QPainter *painter, QLineF line, int offset)
     QPolygonF polygon(vector);
     painter->drawPolygon(polygon);
 }
-<<<<<<< HEAD
-=======
-
 
 QRectF rectPrecision(const QRectF &rect, short iPlaces)
 {
@@ -957,4 +1472,3 @@ QRectF rectPrecision(const QRectF &rect, short iPlaces)
     qreal height = qrealPrecision(rect.height(), iPlaces);
     return QRectF(topLeft.rx(), topLeft.ry(), width, height);
 }
->>>>>>> Jeremy
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <sstream>
+#include <functional>
 #include <QColor>
 #include <QPainter>
 #include <QPointF>
@@ -17,10 +18,7 @@ enum crossType{
     normal = 1,
     upright = 2
 };
-<<<<<<< HEAD
-=======
 // 类型转换
->>>>>>> Jeremy
 void str2int(int &int_temp,const std::string &string_temp);
 void str2float(float &float_temp,const std::string &string_temp);
 void str2double(double &double_temp,const std::string &string_temp);
@@ -38,11 +36,9 @@ QVector<QLineF> linesListPrecision(const QVector<QLineF> linesList, short iPlace
 QPointF transformY(QPointF p);  // 转变纵坐标轴
 QPointF transformRotate(QPointF o, qreal r, qreal angle); // 返回旋转某一点之后的坐标
 QPointF transformRotate(QPointF o, QPointF p, qreal angle);  // 返回一点绕另一点旋转的坐标
-<<<<<<< HEAD
 //QRectF getLineBoundingRect(QLineF line);
 qreal getDistance(QPointF p1, QPointF p2);  // 获取亮点之间的距离
 qreal getLineAngle(QLineF line1, QLineF line2=QLineF(0, 0, 0, 1));  // 获取两直线夹角
-=======
 
 // 图形计算
 qreal calculatePointsDistance(QPointF p1, QPointF p2);  // 获取两点之间的距离
@@ -52,6 +48,7 @@ bool boundingRectSeperate(const QRectF rect1, const QRectF rect2);  // 判断两
 bool boundingRectContain(const QRectF rect1, const QRectF rect2);  // 判断两矩形是否包含，rect1包含rect2
 bool pointContainsInPolygon(QVector<QPointF> pList, const QPointF &point);  // 多边形包含某点
 bool pointOnPolygonBoundary(QVector<QPointF> pList, const QPointF &point);  // 点在多边形边上
+bool polygonContainsPolygon(QVector<QPointF> outer, QVector<QPointF> inner);  // 多边形outer完全包含多边形inner，允许边界接触
 bool pointContainsInRect(const QRectF &rect, const QPointF &point);  // 判断点是否在矩形内
 qreal cross(QPointF &p1, QPointF &p2, QPointF &p3);  // 计算叉积
 bool getLineIntersection(const QLineF &l1, const QLineF &l2, QPointF &intersection);  // 计算两直线交点
@@ -65,9 +62,19 @@ bool calculatePolygonDirection(QVector<QPointF> points);//多边形方向顺时
 QPointF calculatePolygonGravityCenter(QVector<QPointF> mPoints);//求多边形重心
 bool isConcaveConvex(QPointF ppoint, QPointF cpoint, QPointF npoint, bool direction);//多边形三个点凹凸性,凸为true
 double calculatePloygonMinBoundingRectArea(QVector<QPointF> points, qreal &alpha, QRectF &minBoundingRect);//多边形最小包络矩形面积
+QVector<QPointF> simplifyPolylineDouglasPeucker(const QVector<QPointF> &points, qreal tolerance);  // Douglas-Peucker简化折线
+QVector<QPointF> simplifyPolygonConservative(QVector<QPointF> points, qreal tolerance, qreal &margin, qreal clearance=0);  // 简化多边形并向外偏移，结果包含原多边形
+QVector<QPointF> tessellateArc(const QPointF &center, qreal radius, qreal startAngle, qreal endAngle, qreal tolerance);  // 圆弧按弦高误差离散为折线
+QVector<QPointF> tessellateEllipse(const QPointF &center, const QPointF &majorAxis, qreal ratio,
+                                   qreal startParam, qreal endParam, qreal tolerance);  // 椭圆弧按弦高误差离散为折线
+QVector<QPointF> tessellatePolylineBulge(const QVector<QPointF> &points, const QVector<qreal> &bulges,
+                                         bool closed, qreal tolerance);  // 带凸度的多段线离散为折线
+qreal brentMinimize(const std::function<qreal(qreal)> &f, qreal a, qreal b, qreal x, qreal &fx,
+                    qreal tolerance, int maxEvaluations, int &evaluations);  // Brent法求一维函数在[a,b]上的极小值点
+qreal minimizeRotateAngle(const std::function<qreal(qreal)> &objective, int minAngle, int maxAngle, int coarseStep,
+                          qreal tolerance, int maxEvaluations, qreal &alpha, int &evaluations);  // 粗扫描加Brent法细化求最佳旋转角度
 
 // 画特殊图形
->>>>>>> Jeremy
 void drawCrossPoint(QPainter* painter, QPointF point, int offset, crossType type);  // 画交叉点
 void drawNodePoint(QPainter* painter, QPointF point, int radius);  // 画点
 void drawRectPoint(QPainter* painter, QPointF point, int length);  // 画矩形点
@@ -27,11 +27,44 @@
 #define DEBUGNFREADER
 #endif
 
-<<<<<<< HEAD
-=======
+#if 1
+#define SAT_SIMD_KERNEL  // 使用向量化分离轴内核
+#endif
+
+#if 0
+#define SATKERNELCHECK  // 向量化内核与原实现结果对比
+#endif
+
+#if 0
+#define NFPBENCHMARK  // 临界多边形检测与分离轴检测耗时对比
+#endif
+
+#if 0
+#define COLLISIONSTATISTICS  // 统计凸多边形对被包络剔除的次数
+#endif
+
+#if 0
+#define FIXEDPOINTGEOMETRY  // 零件坐标取整到1µm定点网格，使用整数精确判断
+#endif
+
+#if 0
+#define MINBOUNDINGRECTCHECK  // 旋转卡壳最小包络矩形与原O(n²)实现结果对比
+#endif
+
+#if 0
+#define POLYGONOFFSETBENCHMARK  // 多边形偏移耗时统计
+#endif
+
+#if 0
+#define ROTATEANGLEBENCHMARK  // 旋转角度优化与1°遍历的目标值与求值次数对比
+#endif
+
+#if 0
+#define BESTNESTTYPEDEBUG  // 输出各排版策略的分析结果与并行分析用时
+#endif
+
 #if 1
 #define NESTENGINEDEBUG
 #endif
 
->>>>>>> Jeremy
 #define DISCARD_DXF_ENTITY_PROPERTITY  // 丢掉dxf文件中的实体属性
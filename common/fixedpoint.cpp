@@ -0,0 +1,199 @@
+#include "fixedpoint.h"
+#include <QVarLengthArray>
+
+FixedPoint toFixedPoint(const QPointF &point)
+{
+    return FixedPoint(qRound64(point.x() * FIXED_POINT_SCALE),
+                      qRound64(point.y() * FIXED_POINT_SCALE));
+}
+
+QPointF toPointF(const FixedPoint &point)
+{
+    return QPointF(qreal(point.x) / FIXED_POINT_SCALE,
+                   qreal(point.y) / FIXED_POINT_SCALE);
+}
+
+QVector<FixedPoint> toFixedPointsList(const QVector<QPointF> &pList)
+{
+    QVector<FixedPoint> retList;
+    retList.reserve(pList.length());
+    for(int i=0; i<pList.length(); i++){
+        retList.append(toFixedPoint(pList[i]));
+    }
+    return retList;
+}
+
+QVector<QPointF> toPointsList(const QVector<FixedPoint> &pList)
+{
+    QVector<QPointF> retList;
+    retList.reserve(pList.length());
+    for(int i=0; i<pList.length(); i++){
+        retList.append(toPointF(pList[i]));
+    }
+    return retList;
+}
+
+qint64 fixedCross(const FixedPoint &o, const FixedPoint &a, const FixedPoint &b)
+{
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+int fixedOrientation(const FixedPoint &o, const FixedPoint &a, const FixedPoint &b)
+{
+    qint64 ret = fixedCross(o, a, b);
+    return ret > 0 ? 1 : (ret < 0 ? -1 : 0);
+}
+
+/**
+ * @brief fixedSegmentIntersect
+ * 与getLineIntersection的判断方式一致，只是全部使用整数运算
+ * @param p0 线段1起点
+ * @param p1 线段1终点
+ * @param p2 线段2起点
+ * @param p3 线段2终点
+ * @return
+ */
+bool fixedSegmentIntersect(const FixedPoint &p0, const FixedPoint &p1,
+                           const FixedPoint &p2, const FixedPoint &p3)
+{
+    FixedPoint s10 = p1 - p0;
+    FixedPoint s32 = p3 - p2;
+    qint64 denom = s10.x * s32.y - s32.x * s10.y;
+    if(denom == 0){  // 平行或共线
+        return false;
+    }
+    bool denomPositive = denom > 0;
+
+    FixedPoint s02 = p0 - p2;
+    qint64 sNumer = s10.x * s02.y - s10.y * s02.x;
+    if((sNumer < 0) == denomPositive){
+        return false;
+    }
+    qint64 tNumer = s32.x * s02.y - s32.y * s02.x;
+    if((tNumer < 0) == denomPositive){
+        return false;
+    }
+    if(((sNumer > denom) == denomPositive) || ((tNumer > denom) == denomPositive)){
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief fixedConvexPolygonCollision
+ * 分离轴检测，分离轴取各边的法向量(不归一化)，投影为整数点积，
+ * 投影区间只在端点处接触时视为分离。
+ * 凸多边形2的各点加上offset2参与投影，平移不复制点集
+ * @param pList1 凸多边形1，首尾不重复
+ * @param len1 凸多边形1的顶点数
+ * @param pList2 凸多边形2，首尾不重复
+ * @param len2 凸多边形2的顶点数
+ * @param offset2 凸多边形2的平移量
+ * @return
+ */
+bool fixedConvexPolygonCollision(const FixedPoint *pList1, int len1,
+                                 const FixedPoint *pList2, int len2,
+                                 const FixedPoint &offset2)
+{
+    if(len1 < 1 || len2 < 1){
+        return false;
+    }
+    for(int k=0; k<2; k++){
+        const FixedPoint *pList = k == 0 ? pList1 : pList2;
+        int len = k == 0 ? len1 : len2;
+        for(int i=0; i<len; i++){
+            FixedPoint edge = pList[(i+1)%len] - pList[i];
+            if(edge.x == 0 && edge.y == 0){  // 防止前后两点重复导致错误
+                continue;
+            }
+            qint64 nx = -edge.y;  // 法线向量
+            qint64 ny = edge.x;
+            qint64 min1 = nx * pList1[0].x + ny * pList1[0].y;
+            qint64 max1 = min1;
+            for(int j=1; j<len1; j++){
+                qint64 d = nx * pList1[j].x + ny * pList1[j].y;
+                min1 = qMin(min1, d);
+                max1 = qMax(max1, d);
+            }
+            qint64 min2 = nx * pList2[0].x + ny * pList2[0].y;
+            qint64 max2 = min2;
+            for(int j=1; j<len2; j++){
+                qint64 d = nx * pList2[j].x + ny * pList2[j].y;
+                min2 = qMin(min2, d);
+                max2 = qMax(max2, d);
+            }
+            qint64 shift = nx * offset2.x + ny * offset2.y;  // 平移量在该轴上的投影
+            min2 += shift;
+            max2 += shift;
+            if(min1 >= max2 || min2 >= max1){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool fixedConvexPolygonCollision(const QVector<FixedPoint> &pList1,
+                                 const QVector<FixedPoint> &pList2,
+                                 const FixedPoint &offset2)
+{
+    return fixedConvexPolygonCollision(pList1.constData(), pList1.length(),
+                                       pList2.constData(), pList2.length(), offset2);
+}
+
+/**
+ * @brief fixedConvexPolygonCollision
+ * 浮点点集已在定点网格上，转换是精确的；顶点数不多时缓冲区在栈上，不分配内存
+ * @param pList1 凸多边形1，首尾不重复
+ * @param pList2 凸多边形2，首尾不重复
+ * @param offset2 凸多边形2的平移量，取整到定点网格后按整数平移
+ * @return
+ */
+bool fixedConvexPolygonCollision(const QVector<QPointF> &pList1,
+                                 const QVector<QPointF> &pList2,
+                                 const QPointF &offset2)
+{
+    QVarLengthArray<FixedPoint, 64> fixedList1(pList1.length());
+    QVarLengthArray<FixedPoint, 64> fixedList2(pList2.length());
+    for(int i=0; i<pList1.length(); i++){
+        fixedList1[i] = toFixedPoint(pList1[i]);
+    }
+    for(int i=0; i<pList2.length(); i++){
+        fixedList2[i] = toFixedPoint(pList2[i]);
+    }
+    return fixedConvexPolygonCollision(fixedList1.constData(), fixedList1.length(),
+                                       fixedList2.constData(), fixedList2.length(), toFixedPoint(offset2));
+}
+
+/**
+ * @brief snapToFixedPoints
+ * 导入、旋转、偏移等产生新坐标之后调用一次，之后的平移只做整数加法，
+ * 浮点坐标由定点坐标换算，不会因为反复取整而漂移
+ * @param pList 浮点点集，取整到定点网格
+ * @param fixedList 对应的定点坐标，复用原有缓冲区
+ */
+void snapToFixedPoints(QVector<QPointF> &pList, QVector<FixedPoint> &fixedList)
+{
+    fixedList.resize(pList.length());
+    for(int i=0; i<pList.length(); i++){
+        fixedList[i] = toFixedPoint(pList[i]);
+        pList[i] = toPointF(fixedList[i]);
+    }
+}
+
+/**
+ * @brief translateFixedPoints
+ * 平移前的定点坐标加上整数平移量，浮点坐标由定点坐标换算，结果写入原有的缓冲区
+ * @param source 平移前的定点坐标，可以与fixedList为同一点集
+ * @param pList 浮点点集
+ * @param fixedList 定点坐标，与pList一一对应，长度与source相同
+ * @param offset 平移量
+ */
+void translateFixedPoints(const QVector<FixedPoint> &source, QVector<QPointF> &pList, QVector<FixedPoint> &fixedList,
+                          const FixedPoint &offset)
+{
+    for(int i=0; i<source.length(); i++){
+        fixedList[i] = source[i] + offset;
+        pList[i] = toPointF(fixedList[i]);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef FIXEDPOINT_H
+#define FIXEDPOINT_H
+
+#include <QtGlobal>
+#include <QPointF>
+#include <QVector>
+
+/**
+ * 定点坐标
+ * 坐标单位为mm，定点坐标以1µm为单位保存为int64，
+ * 坐标范围在±10^8µm(100m)以内时，叉积、点积都不会溢出，
+ * 因此方向判断、线段相交、分离轴检测的结果都是精确的。
+ * 平移为整数加法，不需要逐点保留小数位；
+ * 只有导入零件和旋转时需要将浮点坐标取整到定点网格上。
+ */
+#define FIXED_POINT_SCALE 1000  // 1mm = 1000µm
+
+struct FixedPoint
+{
+    FixedPoint() :
+        x(0),
+        y(0)
+    {}
+
+    FixedPoint(qint64 _x, qint64 _y) :
+        x(_x),
+        y(_y)
+    {}
+
+    FixedPoint operator+(const FixedPoint &p) const { return FixedPoint(x + p.x, y + p.y); }
+    FixedPoint operator-(const FixedPoint &p) const { return FixedPoint(x - p.x, y - p.y); }
+    FixedPoint &operator+=(const FixedPoint &p) { x += p.x; y += p.y; return *this; }
+    bool operator==(const FixedPoint &p) const { return x == p.x && y == p.y; }
+    bool operator!=(const FixedPoint &p) const { return x != p.x || y != p.y; }
+
+    qint64 x;  // x坐标，单位µm
+    qint64 y;  // y坐标，单位µm
+};
+
+FixedPoint toFixedPoint(const QPointF &point);  // 浮点坐标转为定点坐标
+QPointF toPointF(const FixedPoint &point);  // 定点坐标转为浮点坐标
+QVector<FixedPoint> toFixedPointsList(const QVector<QPointF> &pList);  // 点集转为定点坐标
+QVector<QPointF> toPointsList(const QVector<FixedPoint> &pList);  // 点集转为浮点坐标
+
+qint64 fixedCross(const FixedPoint &o, const FixedPoint &a, const FixedPoint &b);  // 叉积(a-o)x(b-o)
+int fixedOrientation(const FixedPoint &o, const FixedPoint &a, const FixedPoint &b);  // 三点方向，1/-1/0
+bool fixedSegmentIntersect(const FixedPoint &p0, const FixedPoint &p1,
+                           const FixedPoint &p2, const FixedPoint &p3);  // 线段p0p1与p2p3是否相交，共线时不算相交
+bool fixedConvexPolygonCollision(const FixedPoint *pList1, int len1,
+                                 const FixedPoint *pList2, int len2,
+                                 const FixedPoint &offset2 = FixedPoint());  // 凸多边形碰撞检测，边界接触不算碰撞
+bool fixedConvexPolygonCollision(const QVector<FixedPoint> &pList1,
+                                 const QVector<FixedPoint> &pList2,
+                                 const FixedPoint &offset2 = FixedPoint());  // 凸多边形2平移offset2后检测，不复制点集
+bool fixedConvexPolygonCollision(const QVector<QPointF> &pList1,
+                                 const QVector<QPointF> &pList2,
+                                 const QPointF &offset2 = QPointF());  // 已在定点网格上的浮点点集，转换到栈上的缓冲区后检测
+void snapToFixedPoints(QVector<QPointF> &pList, QVector<FixedPoint> &fixedList);  // 点集取整到定点网格，同时保存定点坐标
+void translateFixedPoints(const QVector<FixedPoint> &source, QVector<QPointF> &pList, QVector<FixedPoint> &fixedList,
+                          const FixedPoint &offset);  // 定点坐标按整数平移，浮点坐标由定点坐标换算
+
+#endif // FIXEDPOINT_H
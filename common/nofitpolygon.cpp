@@ -0,0 +1,320 @@
+#include "nofitpolygon.h"
+#include <QPolygonF>
+#include <qmath.h>
+#include <algorithm>
+
+#define NO_FIT_POLYGON_CACHE_MAX_BYTES (64 * 1024 * 1024)  // 默认缓存大小上限64MB
+
+static qreal crossProduct(const QPointF &o, const QPointF &a, const QPointF &b)
+{
+    return (a.x() - o.x()) * (b.y() - o.y()) - (a.y() - o.y()) * (b.x() - o.x());
+}
+
+static bool pointLessThan(const QPointF &p1, const QPointF &p2)
+{
+    return p1.x() < p2.x() || (p1.x() == p2.x() && p1.y() < p2.y());
+}
+
+NoFitPolygon::NoFitPolygon() :
+    epsilon(1e-6)
+{
+
+}
+
+/**
+ * @brief NoFitPolygon::NoFitPolygon
+ * @param fixedPartsList 固定零件的凸多边形分解，参考点位于原点
+ * @param movingPartsList 移动零件的凸多边形分解，参考点位于原点
+ * @param precision 精度，重叠量不超过10^-precision时视为接触
+ */
+NoFitPolygon::NoFitPolygon(const QVector<QVector<QPointF>> &fixedPartsList,
+                           const QVector<QVector<QPointF>> &movingPartsList,
+                           short precision) :
+    epsilon(qPow(10.0, -precision))
+{
+    // 移动零件关于原点取反
+    QVector<QVector<QPointF>> negPartsList;
+    for(int i=0; i<movingPartsList.length(); i++){
+        QVector<QPointF> negPart;
+        for(int j=0; j<movingPartsList[i].length(); j++){
+            negPart.append(-movingPartsList[i][j]);
+        }
+        negPartsList.append(negPart);
+    }
+
+    for(int i=0; i<fixedPartsList.length(); i++){
+        for(int j=0; j<negPartsList.length(); j++){
+            QVector<QPointF> part = minkowskiSum(fixedPartsList[i], negPartsList[j]);
+            if(part.length() < 3){
+                continue;
+            }
+            QRectF rect = QPolygonF(part).boundingRect();
+            partsList.append(part);
+            partRectList.append(rect);
+            boundingRect = boundingRect.isNull() ? rect : boundingRect.united(rect);
+        }
+    }
+}
+
+bool NoFitPolygon::isEmpty() const
+{
+    return partsList.isEmpty();
+}
+
+/**
+ * @brief NoFitPolygon::contains
+ * 点到凸多边形各边的距离都大于epsilon时，认为点在其内部
+ * @param point 移动零件参考点相对固定零件参考点的位置
+ * @return
+ */
+bool NoFitPolygon::contains(const QPointF &point) const
+{
+    if(point.x() <= boundingRect.left() || point.x() >= boundingRect.right()
+            || point.y() <= boundingRect.top() || point.y() >= boundingRect.bottom()){
+        return false;
+    }
+    for(int i=0; i<partsList.length(); i++){
+        const QRectF &rect = partRectList[i];
+        if(point.x() <= rect.left() || point.x() >= rect.right()
+                || point.y() <= rect.top() || point.y() >= rect.bottom()){
+            continue;
+        }
+        const QVector<QPointF> &part = partsList[i];
+        int len = part.length();
+        bool inside = true;
+        for(int j=0; j<len; j++){
+            const QPointF &p1 = part[j];
+            const QPointF &p2 = part[(j+1)%len];
+            qreal length = qSqrt((p2.x()-p1.x())*(p2.x()-p1.x()) + (p2.y()-p1.y())*(p2.y()-p1.y()));
+            if(crossProduct(p1, p2, point) <= epsilon * length){
+                inside = false;
+                break;
+            }
+        }
+        if(inside){
+            return true;
+        }
+    }
+    return false;
+}
+
+QRectF NoFitPolygon::getBoundingRect() const
+{
+    return boundingRect;
+}
+
+const QVector<QVector<QPointF>> &NoFitPolygon::getPartsList() const
+{
+    return partsList;
+}
+
+qint64 NoFitPolygon::estimateBytes() const
+{
+    qint64 ret = sizeof(NoFitPolygon);
+    for(int i=0; i<partsList.length(); i++){
+        ret += partsList[i].length() * sizeof(QPointF) + sizeof(QRectF);
+    }
+    return ret;
+}
+
+/**
+ * @brief NoFitPolygon::convexHull
+ * Andrew单调链算法，去掉共线点，首尾不重复
+ * @param points
+ * @return
+ */
+QVector<QPointF> NoFitPolygon::convexHull(QVector<QPointF> points)
+{
+    std::sort(points.begin(), points.end(), pointLessThan);
+    points.erase(std::unique(points.begin(), points.end()), points.end());
+    int n = points.length();
+    if(n < 3){
+        return points;
+    }
+
+    QVector<QPointF> hull(2 * n);
+    int k = 0;
+    for(int i=0; i<n; i++){  // 下凸链
+        while(k >= 2 && crossProduct(hull[k-2], hull[k-1], points[i]) <= 0){
+            k--;
+        }
+        hull[k++] = points[i];
+    }
+    for(int i=n-2, t=k+1; i>=0; i--){  // 上凸链
+        while(k >= t && crossProduct(hull[k-2], hull[k-1], points[i]) <= 0){
+            k--;
+        }
+        hull[k++] = points[i];
+    }
+    hull.resize(k-1);
+    return hull;
+}
+
+/**
+ * @brief NoFitPolygon::minkowskiSum
+ * 两凸多边形按边的极角归并，复杂度O(n+m)
+ * @param part1
+ * @param part2
+ * @return
+ */
+QVector<QPointF> NoFitPolygon::minkowskiSum(const QVector<QPointF> &part1, const QVector<QPointF> &part2)
+{
+    QVector<QPointF> hull1 = convexHull(part1);
+    QVector<QPointF> hull2 = convexHull(part2);
+    int n = hull1.length();
+    int m = hull2.length();
+    if(n == 0 || m == 0){
+        return QVector<QPointF>();
+    }
+    if(n < 3 || m < 3){  // 退化情况，直接对所有点对之和求凸包
+        QVector<QPointF> sums;
+        for(int i=0; i<n; i++){
+            for(int j=0; j<m; j++){
+                sums.append(hull1[i] + hull2[j]);
+            }
+        }
+        return convexHull(sums);
+    }
+
+    // 从最低点(y最小，x最小)开始
+    int start1 = 0, start2 = 0;
+    for(int i=1; i<n; i++){
+        if(hull1[i].y() < hull1[start1].y() || (hull1[i].y() == hull1[start1].y() && hull1[i].x() < hull1[start1].x())){
+            start1 = i;
+        }
+    }
+    for(int i=1; i<m; i++){
+        if(hull2[i].y() < hull2[start2].y() || (hull2[i].y() == hull2[start2].y() && hull2[i].x() < hull2[start2].x())){
+            start2 = i;
+        }
+    }
+
+    QVector<QPointF> sum;
+    int i = 0, j = 0;
+    while(i < n || j < m){
+        const QPointF &p1 = hull1[(start1+i)%n];
+        const QPointF &p2 = hull2[(start2+j)%m];
+        sum.append(p1 + p2);
+        QPointF e1 = hull1[(start1+i+1)%n] - p1;
+        QPointF e2 = hull2[(start2+j+1)%m] - p2;
+        qreal c = e1.x() * e2.y() - e1.y() * e2.x();
+        if(c >= 0 && i < n){
+            i++;
+        }
+        if(c <= 0 && j < m){
+            j++;
+        }
+    }
+    return convexHull(sum);  // 去掉平行边产生的共线点
+}
+
+bool NoFitPolygonCache::Key::operator<(const NoFitPolygonCache::Key &key) const
+{
+    if(fixedTypeID != key.fixedTypeID){
+        return fixedTypeID < key.fixedTypeID;
+    }
+    if(fixedAngle != key.fixedAngle){
+        return fixedAngle < key.fixedAngle;
+    }
+    if(movingTypeID != key.movingTypeID){
+        return movingTypeID < key.movingTypeID;
+    }
+    return movingAngle < key.movingAngle;
+}
+
+NoFitPolygonCache::NoFitPolygonCache() :
+    bytes(0),
+    maxBytes(NO_FIT_POLYGON_CACHE_MAX_BYTES),
+    hitCount(0),
+    missCount(0),
+    evictionCount(0)
+{
+
+}
+
+int NoFitPolygonCache::quantizeAngle(qreal alpha)
+{
+    int angle = qRound(alpha * 1000) % 360000;
+    if(angle < 0){
+        angle += 360000;
+    }
+    return angle;
+}
+
+bool NoFitPolygonCache::contains(const NoFitPolygonCache::Key &key) const
+{
+    return nfpMap.contains(key);
+}
+
+NoFitPolygon NoFitPolygonCache::value(const NoFitPolygonCache::Key &key)
+{
+    hitCount++;
+    return nfpMap.value(key);
+}
+
+NoFitPolygon NoFitPolygonCache::insert(const NoFitPolygonCache::Key &key, const NoFitPolygon &nfp)
+{
+    missCount++;
+    if(nfpMap.contains(key)){
+        return nfpMap.value(key);
+    }
+    qint64 nfpBytes = nfp.estimateBytes();
+    nfpMap.insert(key, nfp);
+    bytesMap.insert(key, nfpBytes);
+    keyQueue.enqueue(key);
+    bytes += nfpBytes;
+    // 超出上限时淘汰最早插入的NFP，至少保留刚插入的NFP
+    while(bytes > maxBytes && keyQueue.length() > 1){
+        Key oldKey = keyQueue.dequeue();
+        bytes -= bytesMap.take(oldKey);
+        nfpMap.remove(oldKey);
+        evictionCount++;
+    }
+    return nfp;
+}
+
+void NoFitPolygonCache::clear()
+{
+    nfpMap.clear();
+    bytesMap.clear();
+    keyQueue.clear();
+    bytes = 0;
+    hitCount = 0;
+    missCount = 0;
+    evictionCount = 0;
+}
+
+void NoFitPolygonCache::setMaxBytes(qint64 bytes)
+{
+    maxBytes = bytes;
+}
+
+qint64 NoFitPolygonCache::getMaxBytes() const
+{
+    return maxBytes;
+}
+
+qint64 NoFitPolygonCache::getBytes() const
+{
+    return bytes;
+}
+
+int NoFitPolygonCache::size() const
+{
+    return nfpMap.size();
+}
+
+int NoFitPolygonCache::getHitCount() const
+{
+    return hitCount;
+}
+
+int NoFitPolygonCache::getMissCount() const
+{
+    return missCount;
+}
+
+int NoFitPolygonCache::getEvictionCount() const
+{
+    return evictionCount;
+}
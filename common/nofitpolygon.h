@@ -0,0 +1,106 @@
+#ifndef NOFITPOLYGON_H
+#define NOFITPOLYGON_H
+
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+#include <QMap>
+#include <QQueue>
+
+/**
+ * @brief The NoFitPolygon class
+ * 临界多边形(NFP)
+ * 固定零件A与移动零件B的参考点都位于原点时，
+ * NFP(A,B) = A ⊕ (-B)，即B的参考点落在NFP内部时两零件重叠，
+ * 落在边界上时两零件接触，落在外部时两零件分离。
+ *
+ * 两零件均已分解为凸多边形，因此NFP由各凸多边形对的闵可夫斯基和组成，
+ * 每一部分都是凸多边形，不需要计算它们的并集。
+ */
+class NoFitPolygon
+{
+public:
+    NoFitPolygon();
+    NoFitPolygon(const QVector<QVector<QPointF>> &fixedPartsList,
+                 const QVector<QVector<QPointF>> &movingPartsList,
+                 short precision = 6);
+
+    bool isEmpty() const;  // 是否为空
+    bool contains(const QPointF &point) const;  // 点是否在NFP内部，边界上不算
+    QRectF getBoundingRect() const;  // 获取包络矩形
+    const QVector<QVector<QPointF>> &getPartsList() const;  // 获取NFP凸多边形列表
+    qint64 estimateBytes() const;  // 估算占用的内存
+
+    static QVector<QPointF> convexHull(QVector<QPointF> points);  // 凸包，结果按叉积为正的方向排列
+    static QVector<QPointF> minkowskiSum(const QVector<QPointF> &part1, const QVector<QPointF> &part2);  // 两凸多边形的闵可夫斯基和
+
+private:
+    QVector<QVector<QPointF>> partsList;  // NFP凸多边形列表
+    QVector<QRectF> partRectList;  // 各凸多边形的包络矩形
+    QRectF boundingRect;  // NFP包络矩形
+    qreal epsilon;  // 判断点在内部时的容差
+};
+
+/**
+ * @brief The NoFitPolygonCache class
+ * NFP缓存，以<固定零件类型, 固定零件角度, 移动零件类型, 移动零件角度>为键，
+ * 角度量化至0.001度。
+ * 与RotatedPieceCache相同，缓存总大小超过上限时，按插入顺序淘汰最早的NFP；
+ * 返回NFP的拷贝(点集隐式共享)，淘汰后之前取得的NFP仍然有效
+ */
+class NoFitPolygonCache
+{
+public:
+    struct Key
+    {
+        Key() :
+            fixedTypeID(-1),
+            fixedAngle(0),
+            movingTypeID(-1),
+            movingAngle(0)
+        {}
+
+        Key(int fType, qreal fAlpha, int mType, qreal mAlpha) :
+            fixedTypeID(fType),
+            fixedAngle(quantizeAngle(fAlpha)),
+            movingTypeID(mType),
+            movingAngle(quantizeAngle(mAlpha))
+        {}
+
+        bool operator<(const Key &key) const;
+
+        int fixedTypeID;  // 固定零件类型
+        int fixedAngle;  // 固定零件量化角度
+        int movingTypeID;  // 移动零件类型
+        int movingAngle;  // 移动零件量化角度
+    };
+
+    NoFitPolygonCache();
+
+    static int quantizeAngle(qreal alpha);  // 角度量化，单位为0.001度，范围[0, 360000)
+
+    bool contains(const Key &key) const;  // 是否已缓存
+    NoFitPolygon value(const Key &key);  // 获取缓存的NFP，同时记录命中
+    NoFitPolygon insert(const Key &key, const NoFitPolygon &nfp);  // 插入NFP，同时记录未命中
+    void clear();  // 清空缓存
+
+    void setMaxBytes(qint64 bytes);  // 设置缓存大小上限
+    qint64 getMaxBytes() const;  // 缓存大小上限
+    qint64 getBytes() const;  // 当前缓存大小
+    int size() const;  // 缓存个数
+    int getHitCount() const;  // 命中次数
+    int getMissCount() const;  // 未命中次数
+    int getEvictionCount() const;  // 淘汰次数
+
+private:
+    QMap<Key, NoFitPolygon> nfpMap;  // NFP缓存
+    QMap<Key, qint64> bytesMap;  // 各NFP占用的内存
+    QQueue<Key> keyQueue;  // 插入顺序，用于淘汰
+    qint64 bytes;  // 当前缓存大小
+    qint64 maxBytes;  // 缓存大小上限
+    int hitCount;  // 命中次数
+    int missCount;  // 未命中次数
+    int evictionCount;  // 淘汰次数
+};
+
+#endif // NOFITPOLYGON_H
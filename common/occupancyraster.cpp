@@ -0,0 +1,302 @@
+#include "occupancyraster.h"
+#include <QtAlgorithms>
+#include <qmath.h>
+#include <algorithm>
+
+OccupancyRaster::OccupancyRaster() :
+    columns(0),
+    rows(0),
+    wordsPerRow(0),
+    originColumn(0),
+    originRow(0)
+{
+
+}
+
+OccupancyRaster::OccupancyRaster(int columns, int rows, int originColumn, int originRow) :
+    columns(qMax(columns, 0)),
+    rows(qMax(rows, 0)),
+    wordsPerRow((qMax(columns, 0) + 63) / 64),
+    originColumn(originColumn),
+    originRow(originRow),
+    bits(wordsPerRow * qMax(rows, 0), 0)
+{
+
+}
+
+/**
+ * @brief OccupancyRaster::fromPolygon
+ * 零件参考点位于原点时的栅格。
+ * 零件参考点落在材料栅格(k, l)内任意位置时，
+ * 本栅格第m列覆盖的是材料栅格第m+k列，两者的相对偏移在[0, 1)格之间，
+ * 因此要求2×2格的区域[(m-1)r, (m+1)r]被零件完全覆盖，
+ * 才能保证零件平移后对应的材料栅格一定被完全覆盖
+ * @param polygon 零件点集，参考点位于原点
+ * @param resolution 栅格边长
+ * @param margin 判断完全覆盖时向外扩展的距离，用于抵消坐标取位误差
+ * @return
+ */
+OccupancyRaster OccupancyRaster::fromPolygon(const QVector<QPointF> &polygon, qreal resolution, qreal margin)
+{
+    QVector<QVector<QPointF>> loopsList;
+    loopsList.append(polygon);
+    return fromPolygon(loopsList, resolution, margin);
+}
+
+/**
+ * @brief OccupancyRaster::fromPolygon
+ * 与单个多边形相同，内孔中的栅格不标记
+ * @param loopsList 外轮廓与内孔，参考点位于原点
+ * @param resolution 栅格边长
+ * @param margin 判断完全覆盖时向外扩展的距离
+ * @return
+ */
+OccupancyRaster OccupancyRaster::fromPolygon(const QVector<QVector<QPointF>> &loopsList, qreal resolution, qreal margin)
+{
+    if(loopsList.isEmpty() || loopsList[0].length() < 3 || resolution <= 0){
+        return OccupancyRaster();
+    }
+    const QVector<QPointF> &polygon = loopsList[0];
+    qreal minX = polygon[0].x(), maxX = minX;
+    qreal minY = polygon[0].y(), maxY = minY;
+    for(int i=1; i<polygon.length(); i++){
+        minX = qMin(minX, polygon[i].x());
+        maxX = qMax(maxX, polygon[i].x());
+        minY = qMin(minY, polygon[i].y());
+        maxY = qMax(maxY, polygon[i].y());
+    }
+    int minColumn = qFloor(minX / resolution) + 1;
+    int maxColumn = qCeil(maxX / resolution) - 1;
+    int minRow = qFloor(minY / resolution) + 1;
+    int maxRow = qCeil(maxY / resolution) - 1;
+    if(maxColumn < minColumn || maxRow < minRow){
+        return OccupancyRaster();
+    }
+    OccupancyRaster raster(maxColumn - minColumn + 1, maxRow - minRow + 1, minColumn, minRow);
+    QPointF origin((minColumn - 1) * resolution, (minRow - 1) * resolution);
+    raster.fillPolygon(loopsList, origin, resolution, 2, margin);
+    return raster;
+}
+
+bool OccupancyRaster::isEmpty() const
+{
+    for(int i=0; i<bits.length(); i++){
+        if(bits[i]){
+            return false;
+        }
+    }
+    return true;
+}
+
+int OccupancyRaster::getColumns() const
+{
+    return columns;
+}
+
+int OccupancyRaster::getRows() const
+{
+    return rows;
+}
+
+int OccupancyRaster::getOriginColumn() const
+{
+    return originColumn;
+}
+
+int OccupancyRaster::getOriginRow() const
+{
+    return originRow;
+}
+
+bool OccupancyRaster::testBit(int column, int row) const
+{
+    if(column < 0 || column >= columns || row < 0 || row >= rows){
+        return false;
+    }
+    return (bits[row * wordsPerRow + column / 64] >> (column % 64)) & 1;
+}
+
+void OccupancyRaster::setBit(int column, int row)
+{
+    if(column < 0 || column >= columns || row < 0 || row >= rows){
+        return;
+    }
+    bits[row * wordsPerRow + column / 64] |= quint64(1) << (column % 64);
+}
+
+/**
+ * @brief OccupancyRaster::fillPolygon
+ * 逐行扫描：行带[y0, y1]内，竖直线段{x}×[y0, y1]完全在多边形内部的条件是
+ * 行带中线上x处在多边形内部，且x不在任何一条边落在行带内部分的x投影上。
+ * 栅格的x范围完全落在这样的区间内时，该栅格被多边形完全覆盖
+ * @param polygon 多边形点集
+ * @param origin 第0行第0列栅格的左上角
+ * @param resolution 栅格边长
+ * @param span 每个栅格覆盖的格数
+ * @param margin 判断完全覆盖时向外扩展的距离
+ */
+void OccupancyRaster::fillPolygon(const QVector<QPointF> &polygon, const QPointF &origin, qreal resolution,
+                                  int span, qreal margin)
+{
+    QVector<QVector<QPointF>> loopsList;
+    loopsList.append(polygon);
+    fillPolygon(loopsList, origin, resolution, span, margin);
+}
+
+/**
+ * @brief OccupancyRaster::fillPolygon
+ * 与单个多边形相同，各环的交点一起按奇偶规则确定内部区间，
+ * 内孔的边同样阻挡栅格，内孔中及与内孔边相交的栅格不标记
+ * @param loopsList 外轮廓与内孔，第一个环为外轮廓
+ * @param origin 第0行第0列栅格的左上角
+ * @param resolution 栅格边长
+ * @param span 每个栅格覆盖的格数
+ * @param margin 判断完全覆盖时向外扩展的距离
+ */
+void OccupancyRaster::fillPolygon(const QVector<QVector<QPointF>> &loopsList, const QPointF &origin, qreal resolution,
+                                  int span, qreal margin)
+{
+    if(loopsList.isEmpty() || loopsList[0].length() < 3 || resolution <= 0){
+        return;
+    }
+    const QVector<QPointF> &polygon = loopsList[0];
+    qreal minY = polygon[0].y(), maxY = minY;
+    for(int i=1; i<polygon.length(); i++){
+        minY = qMin(minY, polygon[i].y());
+        maxY = qMax(maxY, polygon[i].y());
+    }
+    int startRow = qMax(0, qFloor((minY - origin.y()) / resolution));
+    int endRow = qMin(rows - 1, qCeil((maxY - origin.y()) / resolution) - span);
+
+    QVector<qreal> crossList;  // 中线与各边的交点
+    QVector<QPointF> blockList;  // 各边在行带内部分的x投影
+    for(int r=startRow; r<=endRow; r++){
+        qreal y0 = origin.y() + r * resolution - margin;
+        qreal y1 = origin.y() + (r + span) * resolution + margin;
+        qreal ym = 0.5 * (y0 + y1);
+        crossList.clear();
+        blockList.clear();
+        for(int k=0; k<loopsList.length(); k++){
+            const QVector<QPointF> &loop = loopsList[k];
+            int len = loop.length();
+            if(len < 3){
+                continue;
+            }
+            for(int i=0; i<len; i++){
+                const QPointF &p1 = loop[i];
+                const QPointF &p2 = loop[(i+1)%len];
+                if((p1.y() <= ym && ym < p2.y()) || (p2.y() <= ym && ym < p1.y())){
+                    crossList.append(p1.x() + (ym - p1.y()) * (p2.x() - p1.x()) / (p2.y() - p1.y()));
+                }
+                if(qMax(p1.y(), p2.y()) < y0 || qMin(p1.y(), p2.y()) > y1){
+                    continue;
+                }
+                qreal xa = p1.x(), xb = p2.x();
+                if(p1.y() != p2.y()){
+                    qreal ta = qBound(qreal(0), (y0 - p1.y()) / (p2.y() - p1.y()), qreal(1));
+                    qreal tb = qBound(qreal(0), (y1 - p1.y()) / (p2.y() - p1.y()), qreal(1));
+                    xa = p1.x() + ta * (p2.x() - p1.x());
+                    xb = p1.x() + tb * (p2.x() - p1.x());
+                }
+                blockList.append(QPointF(qMin(xa, xb), qMax(xa, xb)));
+            }
+        }
+        std::sort(crossList.begin(), crossList.end());
+        std::sort(blockList.begin(), blockList.end(), [](const QPointF &a, const QPointF &b){
+            return a.x() < b.x();
+        });
+
+        // 中线上的内部区间，去掉被边阻挡的部分
+        int b = 0;
+        for(int i=0; i+1<crossList.length(); i+=2){
+            qreal start = crossList[i];
+            qreal end = crossList[i+1];
+            while(start < end){
+                while(b < blockList.length() && blockList[b].y() <= start){
+                    b++;
+                }
+                qreal stop = end;
+                qreal next = end;
+                if(b < blockList.length() && blockList[b].x() < end){
+                    stop = qMax(start, blockList[b].x());
+                    next = blockList[b].y();
+                }
+                // 区间[start, stop]内的栅格
+                int c0 = qMax(0, qCeil((start + margin - origin.x()) / resolution));
+                int c1 = qMin(columns - 1, qFloor((stop - margin - origin.x()) / resolution) - span);
+                for(int c=c0; c<=c1; c++){
+                    setBit(c, r);
+                }
+                start = next;
+            }
+        }
+    }
+}
+
+/**
+ * @brief OccupancyRaster::rowBits
+ * 第row行从第startColumn列开始的64列，超出范围的列为0
+ * @param row
+ * @param startColumn
+ * @return
+ */
+quint64 OccupancyRaster::rowBits(int row, int startColumn) const
+{
+    if(row < 0 || row >= rows || startColumn >= columns || startColumn <= -64){
+        return 0;
+    }
+    const quint64 *rowData = bits.constData() + row * wordsPerRow;
+    if(startColumn < 0){
+        return rowData[0] << (-startColumn);
+    }
+    int word = startColumn / 64;
+    int shift = startColumn % 64;
+    quint64 ret = rowData[word] >> shift;
+    if(shift != 0 && word + 1 < wordsPerRow){
+        ret |= rowData[word + 1] << (64 - shift);
+    }
+    return ret;
+}
+
+/**
+ * @brief OccupancyRaster::overlaps
+ * raster的第c列第r行对应本栅格的第c+columnOffset列、第r+rowOffset行，逐字按位与
+ * @param raster
+ * @param columnOffset
+ * @param rowOffset
+ * @return
+ */
+bool OccupancyRaster::overlaps(const OccupancyRaster &raster, int columnOffset, int rowOffset) const
+{
+    for(int r=0; r<raster.rows; r++){
+        int row = r + rowOffset;
+        if(row < 0 || row >= rows){
+            continue;
+        }
+        const quint64 *rowData = raster.bits.constData() + r * raster.wordsPerRow;
+        for(int w=0; w<raster.wordsPerRow; w++){
+            if(rowData[w] && (rowData[w] & rowBits(row, w * 64 + columnOffset))){
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int OccupancyRaster::overlapCount(const OccupancyRaster &raster, int columnOffset, int rowOffset) const
+{
+    int count = 0;
+    for(int r=0; r<raster.rows; r++){
+        int row = r + rowOffset;
+        if(row < 0 || row >= rows){
+            continue;
+        }
+        const quint64 *rowData = raster.bits.constData() + r * raster.wordsPerRow;
+        for(int w=0; w<raster.wordsPerRow; w++){
+            if(rowData[w]){
+                count += qPopulationCount(rowData[w] & rowBits(row, w * 64 + columnOffset));
+            }
+        }
+    }
+    return count;
+}
@@ -0,0 +1,56 @@
+#ifndef OCCUPANCYRASTER_H
+#define OCCUPANCYRASTER_H
+
+#include <QtGlobal>
+#include <QVector>
+#include <QPointF>
+
+/**
+ * @brief The OccupancyRaster class
+ * 按位存储的占用栅格，每行按64位字对齐。
+ * 只标记被多边形完全覆盖的栅格，因此两个栅格在同一位置都被标记时，
+ * 对应的两个多边形一定重叠；没有共同标记时不能说明不重叠，
+ * 只能用于排除候选位置的粗判，剩下的候选位置仍需精确检测。
+ *
+ * 栅格(c, r)覆盖的区域为
+ * [origin.x + c*resolution, origin.x + (c+span)*resolution] ×
+ * [origin.y + r*resolution, origin.y + (r+span)*resolution]
+ */
+class OccupancyRaster
+{
+public:
+    OccupancyRaster();
+    OccupancyRaster(int columns, int rows, int originColumn = 0, int originRow = 0);
+
+    static OccupancyRaster fromPolygon(const QVector<QPointF> &polygon, qreal resolution,
+                                       qreal margin = 0);  // 零件局部坐标下的栅格，零件平移任意距离后仍被完全覆盖
+    static OccupancyRaster fromPolygon(const QVector<QVector<QPointF>> &loopsList, qreal resolution,
+                                       qreal margin = 0);  // 带内孔的零件，第一个环为外轮廓
+
+    bool isEmpty() const;  // 是否没有任何标记
+    int getColumns() const;  // 列数
+    int getRows() const;  // 行数
+    int getOriginColumn() const;  // 第0列对应的栅格序号
+    int getOriginRow() const;  // 第0行对应的栅格序号
+
+    bool testBit(int column, int row) const;  // 栅格是否被标记
+    void setBit(int column, int row);  // 标记栅格
+    void fillPolygon(const QVector<QPointF> &polygon, const QPointF &origin, qreal resolution,
+                     int span = 1, qreal margin = 0);  // 标记被多边形完全覆盖的栅格
+    void fillPolygon(const QVector<QVector<QPointF>> &loopsList, const QPointF &origin, qreal resolution,
+                     int span = 1, qreal margin = 0);  // 标记被带内孔的多边形完全覆盖的栅格
+    bool overlaps(const OccupancyRaster &raster, int columnOffset, int rowOffset) const;  // raster平移后与本栅格是否有共同标记
+    int overlapCount(const OccupancyRaster &raster, int columnOffset, int rowOffset) const;  // raster平移后与本栅格共同标记的个数
+
+private:
+    quint64 rowBits(int row, int startColumn) const;  // 第row行从startColumn开始的64位
+
+    int columns;  // 列数
+    int rows;  // 行数
+    int wordsPerRow;  // 每行的64位字个数
+    int originColumn;  // 第0列对应的栅格序号
+    int originRow;  // 第0行对应的栅格序号
+    QVector<quint64> bits;  // 按行存储的标记位
+};
+
+#endif // OCCUPANCYRASTER_H
@@ -0,0 +1,404 @@
+#include "polygonoffset.h"
+#include "debug.h"
+#include <QMap>
+#include <QPair>
+#include <qmath.h>
+#include <algorithm>
+#ifdef POLYGONOFFSETBENCHMARK
+#include <QDebug>
+#include <QElapsedTimer>
+#endif
+
+namespace {
+
+// 原始偏移曲线打断后的子边
+struct SubEdge
+{
+    QPointF p1;
+    QPointF p2;
+};
+
+// 按y坐标分带的线段索引，用于求交与环绕数计算
+class SegmentBands
+{
+public:
+    SegmentBands(const QVector<QPointF> &curve) :
+        curve(curve)
+    {
+        int m = curve.length();
+        minY = maxY = curve[0].y();
+        for(int i=1; i<m; i++){
+            minY = qMin(minY, curve[i].y());
+            maxY = qMax(maxY, curve[i].y());
+        }
+        int count = qMax(1, m / 4);  // 平均每带只有少量线段
+        bandHeight = (maxY - minY) / count;
+        if(bandHeight <= 0){
+            count = 1;
+            bandHeight = 1;
+        }
+        bands.resize(count);
+        for(int i=0; i<m; i++){
+            const QPointF &a = curve[i];
+            const QPointF &b = curve[(i+1)%m];
+            int first = band(qMin(a.y(), b.y()));
+            int last = band(qMax(a.y(), b.y()));
+            for(int k=first; k<=last; k++){
+                bands[k].append(i);
+            }
+        }
+    }
+
+    int band(qreal y) const
+    {
+        return qBound(0, int((y - minY) / bandHeight), bands.length() - 1);
+    }
+
+    // 点的环绕数，逆时针环绕为正
+    int windingNumber(const QPointF &p) const
+    {
+        int m = curve.length();
+        int wn = 0;
+        const QVector<int> &list = bands[band(p.y())];
+        for(int k=0; k<list.length(); k++){
+            const QPointF &a = curve[list[k]];
+            const QPointF &b = curve[(list[k]+1)%m];
+            qreal c = (b.x() - a.x()) * (p.y() - a.y()) - (p.x() - a.x()) * (b.y() - a.y());
+            if(a.y() <= p.y()){
+                if(b.y() > p.y() && c > 0){  // 向上穿过，点在边的左侧
+                    wn++;
+                }
+            } else if(b.y() <= p.y() && c < 0){  // 向下穿过，点在边的右侧
+                wn--;
+            }
+        }
+        return wn;
+    }
+
+    const QVector<QPointF> &curve;
+    QVector<QVector<int>> bands;  // 各带内的线段序号
+    qreal minY;
+    qreal maxY;
+    qreal bandHeight;
+};
+
+qreal signedArea(const QVector<QPointF> &points)
+{
+    qreal area = 0;
+    int n = points.length();
+    for(int i=0; i<n; i++){
+        const QPointF &a = points[i];
+        const QPointF &b = points[(i+1)%n];
+        area += a.x() * b.y() - b.x() * a.y();
+    }
+    return area / 2;
+}
+
+qreal crossProduct(const QPointF &a, const QPointF &b)
+{
+    return a.x() * b.y() - a.y() * b.x();
+}
+
+qreal dotProduct(const QPointF &a, const QPointF &b)
+{
+    return a.x() * b.x() + a.y() * b.y();
+}
+
+qreal length(const QPointF &a)
+{
+    return qSqrt(a.x() * a.x() + a.y() * a.y());
+}
+
+}
+
+PolygonOffset::PolygonOffset(JoinType joinType, qreal miterLimit, qreal arcTolerance) :
+    joinType(joinType),
+    miterLimit(qMax(miterLimit, qreal(1))),
+    arcTolerance(arcTolerance)
+{
+
+}
+
+/**
+ * @brief PolygonOffset::execute
+ * @param polygon 多边形点集，可以首尾重复，方向任意
+ * @param delta 偏移量，大于0时向外偏移
+ * @return 偏移结果，外轮廓逆时针，内孔顺时针；向内偏移过多时为空
+ */
+QVector<QVector<QPointF>> PolygonOffset::execute(const QVector<QPointF> &polygon, qreal delta) const
+{
+#ifdef POLYGONOFFSETBENCHMARK
+    QElapsedTimer timer;
+    timer.start();
+#endif
+    QVector<QVector<QPointF>> res;
+    // 删除重复点，统一为逆时针
+    QVector<QPointF> points;
+    for(int i=0; i<polygon.length(); i++){
+        if(points.isEmpty() || points.last() != polygon[i]){
+            points.append(polygon[i]);
+        }
+    }
+    while(points.length() > 1 && points.first() == points.last()){
+        points.removeLast();
+    }
+    if(points.length() < 3){
+        return res;
+    }
+    if(signedArea(points) < 0){
+        std::reverse(points.begin(), points.end());
+    }
+    if(delta == 0){
+        res.append(points);
+        return res;
+    }
+
+    // Step1: 原始偏移曲线
+    QVector<QPointF> curve = rawOffsetCurve(points, delta);
+    int m = curve.length();
+    if(m < 3){
+        return res;
+    }
+    SegmentBands segmentBands(curve);
+    qreal scale = qMax(segmentBands.maxY - segmentBands.minY, qreal(1));
+    qreal snapTolerance = 1e-12 * scale;  // 交点离顶点小于该值时取顶点坐标
+
+    // Step2: 求各边之间的交点，同一交点只计算一次，保证打断后的子边首尾坐标完全相同
+    QVector<QVector<QPair<qreal, QPointF>>> splitList(m);  // 各边上的打断点<参数, 坐标>
+    for(int i=0; i<m; i++){
+        splitList[i].append(qMakePair(qreal(0), curve[i]));
+        splitList[i].append(qMakePair(qreal(1), curve[(i+1)%m]));
+    }
+    for(int k=0; k<segmentBands.bands.length(); k++){
+        const QVector<int> &list = segmentBands.bands[k];
+        for(int s=0; s<list.length(); s++){
+            int i = list[s];
+            const QPointF &a1 = curve[i];
+            const QPointF &a2 = curve[(i+1)%m];
+            QPointF da = a2 - a1;
+            for(int t=s+1; t<list.length(); t++){
+                int j = list[t];
+                if(j == (i+1)%m || i == (j+1)%m){  // 相邻边只在公共顶点相交
+                    continue;
+                }
+                const QPointF &b1 = curve[j];
+                const QPointF &b2 = curve[(j+1)%m];
+                QPointF db = b2 - b1;
+                qreal denom = crossProduct(da, db);
+                if(denom == 0){  // 平行或共线
+                    continue;
+                }
+                QPointF w = b1 - a1;
+                qreal ta = crossProduct(w, db) / denom;
+                qreal tb = crossProduct(w, da) / denom;
+                if(ta < 0 || ta > 1 || tb < 0 || tb > 1){
+                    continue;
+                }
+                QPointF p = a1 + ta * da;
+                // 交点所在的带唯一，只在该带内记录一次
+                if(segmentBands.band(p.y()) != k){
+                    continue;
+                }
+                // 交点与顶点重合时取顶点坐标
+                const QPointF *vertexList[4] = {&a1, &a2, &b1, &b2};
+                for(int v=0; v<4; v++){
+                    if(length(p - *vertexList[v]) <= snapTolerance){
+                        p = *vertexList[v];
+                        break;
+                    }
+                }
+                splitList[i].append(qMakePair(ta, p));
+                splitList[j].append(qMakePair(tb, p));
+            }
+        }
+    }
+
+    // Step3: 打断，保留右侧环绕数为0的子边
+    QVector<SubEdge> edgeList;
+    QMap<QPair<qreal, qreal>, QVector<int>> startMap;  // 子边起点 -> 子边序号
+    for(int i=0; i<m; i++){
+        QVector<QPair<qreal, QPointF>> &split = splitList[i];
+        std::sort(split.begin(), split.end(),
+                  [](const QPair<qreal, QPointF> &s1, const QPair<qreal, QPointF> &s2){ return s1.first < s2.first; });
+        for(int k=0; k+1<split.length(); k++){
+            const QPointF &p1 = split[k].second;
+            const QPointF &p2 = split[k+1].second;
+            if(p1 == p2){
+                continue;
+            }
+            QPointF d = p2 - p1;
+            qreal l = length(d);
+            qreal eps = qMin(1e-7 * scale, 0.01 * l);
+            QPointF q = (p1 + p2) / 2 + QPointF(d.y(), -d.x()) / l * eps;  // 子边右侧的点
+            if(segmentBands.windingNumber(q) != 0){
+                continue;
+            }
+            SubEdge edge;
+            edge.p1 = p1;
+            edge.p2 = p2;
+            startMap[qMakePair(p1.x(), p1.y())].append(edgeList.length());
+            edgeList.append(edge);
+        }
+    }
+
+    // Step4: 子边首尾相连成环，一点有多条出边时取最右转的一条，使接触的环相互分开
+    QVector<bool> used(edgeList.length(), false);
+    for(int e=0; e<edgeList.length(); e++){
+        if(used[e]){
+            continue;
+        }
+        QVector<QPointF> loop;
+        int cur = e;
+        bool closed = false;
+        while(true){
+            used[cur] = true;
+            loop.append(edgeList[cur].p1);
+            const QPointF &end = edgeList[cur].p2;
+            if(end == edgeList[e].p1){
+                closed = true;
+                break;
+            }
+            const QVector<int> &nextList = startMap.value(qMakePair(end.x(), end.y()));
+            QPointF dIn = end - edgeList[cur].p1;
+            int next = -1;
+            qreal minTurn = 4;
+            for(int k=0; k<nextList.length(); k++){
+                if(used[nextList[k]]){
+                    continue;
+                }
+                QPointF dOut = edgeList[nextList[k]].p2 - end;
+                qreal turn = qAtan2(crossProduct(dIn, dOut), dotProduct(dIn, dOut));
+                if(turn < minTurn){
+                    minTurn = turn;
+                    next = nextList[k];
+                }
+            }
+            if(next < 0){
+                break;
+            }
+            cur = next;
+        }
+        if(!closed || loop.length() < 3){
+            continue;
+        }
+        // 删除共线点
+        QVector<QPointF> simplified;
+        int n = loop.length();
+        for(int i=0; i<n; i++){
+            const QPointF &prev = loop[(i+n-1)%n];
+            const QPointF &next = loop[(i+1)%n];
+            QPointF d1 = loop[i] - prev;
+            QPointF d2 = next - loop[i];
+            if(qAbs(crossProduct(d1, d2)) > 1e-12 * length(d1) * length(d2) || dotProduct(d1, d2) < 0){
+                simplified.append(loop[i]);
+            }
+        }
+        if(simplified.length() >= 3 && qAbs(signedArea(simplified)) > 1e-12 * scale * scale){
+            res.append(simplified);
+        }
+    }
+#ifdef POLYGONOFFSETBENCHMARK
+    qDebug() << "polygon offset:" << points.length() << "vertices," << m << "raw edges,"
+             << edgeList.length() << "kept," << res.length() << "loops," << timer.nsecsElapsed() / 1000 << "us";
+#endif
+    return res;
+}
+
+/**
+ * @brief PolygonOffset::outerOutline
+ * 取偏移结果中面积最大的外轮廓，忽略内孔，用于零件外扩
+ * @param polygon 多边形点集
+ * @param delta 偏移量
+ * @return 首尾相连的外轮廓，失败时为空
+ */
+QVector<QPointF> PolygonOffset::outerOutline(const QVector<QPointF> &polygon, qreal delta) const
+{
+    QVector<QVector<QPointF>> loops = execute(polygon, delta);
+    int index = -1;
+    qreal maxArea = 0;
+    for(int i=0; i<loops.length(); i++){
+        qreal area = signedArea(loops[i]);
+        if(area > maxArea){
+            maxArea = area;
+            index = i;
+        }
+    }
+    if(index < 0){
+        return QVector<QPointF>();
+    }
+    QVector<QPointF> res = loops[index];
+    res.append(res.first());
+    return res;
+}
+
+/**
+ * @brief PolygonOffset::maxDeviation
+ * 结果顶点离原多边形的距离不超过该值，零件任意旋转后外包矩形按此值扩大即可包含结果
+ * @param delta 偏移量
+ * @return
+ */
+qreal PolygonOffset::maxDeviation(qreal delta) const
+{
+    if(joinType == RoundJoin){
+        return qAbs(delta);
+    }
+    return qAbs(delta) * qMax(miterLimit, qSqrt(2));
+}
+
+/**
+ * @brief PolygonOffset::rawOffsetCurve
+ * 各边沿外法线平移delta，拐角处：
+ * 1. 向偏移方向外凸时，按joinType连接，斜接长度超过miterLimit时截角(两点，离顶点均为√2倍偏移量)；
+ * 2. 向偏移方向内凹时，依次加入两条平移边的端点与原顶点，多出的部分在求并时去掉
+ * @param points 逆时针排列、首尾不重复的点集
+ * @param delta 偏移量
+ * @return
+ */
+QVector<QPointF> PolygonOffset::rawOffsetCurve(const QVector<QPointF> &points, qreal delta) const
+{
+    QVector<QPointF> curve;
+    int n = points.length();
+    qreal absDelta = qAbs(delta);
+    qreal stepAngle = M_PI / 2;  // 圆弧离散的角度步长
+    if(joinType == RoundJoin && arcTolerance > 0 && arcTolerance < absDelta){
+        stepAngle = 2 * qAcos(1 - arcTolerance / absDelta);
+    }
+    for(int i=0; i<n; i++){
+        const QPointF &prev = points[(i+n-1)%n];
+        const QPointF &cur = points[i];
+        const QPointF &next = points[(i+1)%n];
+        QPointF d1 = cur - prev;
+        QPointF d2 = next - cur;
+        d1 /= length(d1);
+        d2 /= length(d2);
+        QPointF n1(d1.y(), -d1.x());  // 外法线
+        QPointF n2(d2.y(), -d2.x());
+        qreal sinA = crossProduct(d1, d2);
+        qreal cosA = dotProduct(d1, d2);
+        if(qAbs(sinA) < 1e-12 && cosA > 0){  // 共线
+            curve.append(cur + n1 * delta);
+            continue;
+        }
+        if(sinA * delta < 0){  // 内凹
+            curve.append(cur + n1 * delta);
+            curve.append(cur);
+            curve.append(cur + n2 * delta);
+            continue;
+        }
+        qreal angle = qAtan2(sinA, cosA);  // n1转至n2的角度
+        if(joinType == RoundJoin){
+            int steps = qMax(1, qCeil(qAbs(angle) / stepAngle));
+            for(int k=0; k<=steps; k++){
+                qreal a = angle * k / steps;
+                QPointF n(n1.x() * qCos(a) - n1.y() * qSin(a), n1.x() * qSin(a) + n1.y() * qCos(a));
+                curve.append(cur + n * delta);
+            }
+        } else if(qSqrt(2 / (1 + cosA)) <= miterLimit){  // 斜接长度为1/cos(angle/2)倍偏移量
+            curve.append(cur + (n1 + n2) / (1 + cosA) * delta);
+        } else{
+            curve.append(cur + n1 * delta + d1 * absDelta);
+            curve.append(cur + n2 * delta - d2 * absDelta);
+        }
+    }
+    return curve;
+}
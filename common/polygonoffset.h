@@ -0,0 +1,37 @@
+#ifndef POLYGONOFFSET_H
+#define POLYGONOFFSET_H
+
+#include <QVector>
+#include <QPointF>
+
+/**
+ * @brief The PolygonOffset class
+ * 多边形偏移，delta大于0时向外偏移，小于0时向内偏移。
+ * 1. 各边沿法线平移delta，外凸的拐角按斜接或圆弧连接，内凹的拐角插入原顶点，得到自相交的原始偏移曲线；
+ * 2. 求原始偏移曲线各边之间的交点，在交点处打断；
+ * 3. 保留右侧环绕数为0(左侧为1)的边，即环绕数为正的区域的边界，再首尾相连成环。
+ * 结果中外轮廓为逆时针(有向面积为正)，内孔为顺时针
+ */
+class PolygonOffset
+{
+public:
+    enum JoinType{
+        MiterJoin,  // 斜接，斜接长度超过miterLimit倍偏移量时截角
+        RoundJoin  // 圆弧
+    };
+
+    PolygonOffset(JoinType joinType = MiterJoin, qreal miterLimit = 2, qreal arcTolerance = 0.01);
+
+    QVector<QVector<QPointF>> execute(const QVector<QPointF> &polygon, qreal delta) const;  // 偏移，返回首尾不重复的环
+    QVector<QPointF> outerOutline(const QVector<QPointF> &polygon, qreal delta) const;  // 面积最大的外轮廓，首尾相连
+    qreal maxDeviation(qreal delta) const;  // 结果顶点离原多边形距离的上界
+
+private:
+    QVector<QPointF> rawOffsetCurve(const QVector<QPointF> &points, qreal delta) const;  // 原始偏移曲线
+
+    JoinType joinType;  // 拐角连接方式
+    qreal miterLimit;  // 斜接长度上限，为偏移量的倍数
+    qreal arcTolerance;  // 圆弧离散的弦高误差
+};
+
+#endif // POLYGONOFFSET_H
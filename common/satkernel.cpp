@@ -0,0 +1,303 @@
+#include "satkernel.h"
+#include <qmath.h>
+#include <float.h>
+
+#if defined(SAT_SIMD_KERNEL) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64))
+#define SAT_X86_KERNEL
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define SAT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SAT_TARGET_AVX2
+#endif
+#endif
+
+SATKernel::KernelType SATKernel::kernelType()
+{
+#ifdef SAT_X86_KERNEL
+#if defined(__GNUC__)
+    static const KernelType type = __builtin_cpu_supports("avx2") ? AVX2Kernel : SSE2Kernel;
+#elif defined(__AVX2__)
+    static const KernelType type = AVX2Kernel;
+#else
+    static const KernelType type = SSE2Kernel;
+#endif
+    return type;
+#else
+    return ScalarKernel;
+#endif
+}
+
+/**
+ * @brief SATKernel::convexPolygonCollision
+ * 与CollisionDectect::convexPolygonCollision语义一致：
+ * 投影区间重叠量不超过10^-precision时视为分离
+ * @param pList1 凸多边形1，顶点数不超过SAT_MAX_VERTICES
+ * @param pList2 凸多边形2，顶点数不超过SAT_MAX_VERTICES
+ * @param precision 精度
+ * @param offset2 凸多边形2的平移量，载入时加上，不复制点集
+ * @return
+ */
+bool SATKernel::convexPolygonCollision(const QVector<QPointF> &pList1,
+                                       const QVector<QPointF> &pList2,
+                                       short precision,
+                                       const QPointF &offset2)
+{
+    return convexPolygonCollision(pList1, pList2, precision, kernelType(), offset2);
+}
+
+/**
+ * @brief SATKernel::convexPolygonCollision
+ * 使用指定内核检测，容差与上一重载相同，用于向量化内核与标量实现的结果对比；
+ * 指定的内核需为当前CPU支持的内核或ScalarKernel
+ * @param pList1 凸多边形1，顶点数不超过SAT_MAX_VERTICES
+ * @param pList2 凸多边形2，顶点数不超过SAT_MAX_VERTICES
+ * @param precision 精度
+ * @param type 内核类型
+ * @param offset2 凸多边形2的平移量
+ * @return
+ */
+bool SATKernel::convexPolygonCollision(const QVector<QPointF> &pList1,
+                                       const QVector<QPointF> &pList2,
+                                       short precision,
+                                       SATKernel::KernelType type,
+                                       const QPointF &offset2)
+{
+    Polygon poly1, poly2;
+    if(!loadPolygon(pList1, poly1) || !loadPolygon(pList2, poly2, offset2)){
+        return false;
+    }
+
+    // 分离轴个数按4对齐，多余位置重复第一条轴，不影响结果
+    double axisX[2 * SAT_MAX_VERTICES + 4];
+    double axisY[2 * SAT_MAX_VERTICES + 4];
+    int axisCount = appendAxes(poly1, axisX, axisY, 0);
+    axisCount = appendAxes(poly2, axisX, axisY, axisCount);
+    if(axisCount == 0){
+        return false;
+    }
+    while(axisCount % 4 != 0){
+        axisX[axisCount] = axisX[0];
+        axisY[axisCount] = axisY[0];
+        axisCount++;
+    }
+
+    double epsilon = qPow(10.0, -precision);
+    return !separatedFunc(type)(axisX, axisY, axisCount, poly1, poly2, -epsilon);
+}
+
+/**
+ * @brief SATKernel::preparePolygon
+ * 载入平移offset后的凸多边形并计算其分离轴
+ * @param pList 凸多边形
+ * @param prepared 载入结果
+ * @param offset 平移量
+ * @return 顶点数为0或超过SAT_MAX_VERTICES时返回false，由调用者回退到原实现
+ */
+bool SATKernel::preparePolygon(const QVector<QPointF> &pList, SATKernel::PreparedPolygon &prepared,
+                               const QPointF &offset)
+{
+    if(!loadPolygon(pList, prepared.poly, offset)){
+        prepared.axisCount = 0;
+        return false;
+    }
+    prepared.axisCount = appendAxes(prepared.poly, prepared.axisX, prepared.axisY, 0);
+    return true;
+}
+
+/**
+ * @brief SATKernel::convexPolygonCollision
+ * 预载入的凸多边形与平移offset2后的凸多边形的间距检测：
+ * 投影间隔不小于gap-epsilon的轴视为分离轴，gap为0时与上一重载的语义一致
+ * @param prepared 预载入的凸多边形
+ * @param pList2 凸多边形2
+ * @param offset2 凸多边形2的平移量
+ * @param gap 最小间距
+ * @param epsilon 重叠量不超过epsilon时视为接触
+ * @param ok 凸多边形2顶点数超过SAT_MAX_VERTICES时置为false，结果无效
+ * @return
+ */
+bool SATKernel::convexPolygonCollision(const SATKernel::PreparedPolygon &prepared,
+                                       const QVector<QPointF> &pList2,
+                                       const QPointF &offset2,
+                                       double gap,
+                                       double epsilon,
+                                       bool *ok)
+{
+    Polygon poly2;
+    bool loaded = loadPolygon(pList2, poly2, offset2);
+    if(ok){
+        *ok = loaded || pList2.isEmpty();
+    }
+    if(!loaded || prepared.poly.n < 1){
+        return false;
+    }
+
+    double axisX[2 * SAT_MAX_VERTICES + 4];
+    double axisY[2 * SAT_MAX_VERTICES + 4];
+    for(int i=0; i<prepared.axisCount; i++){
+        axisX[i] = prepared.axisX[i];
+        axisY[i] = prepared.axisY[i];
+    }
+    int axisCount = appendAxes(poly2, axisX, axisY, prepared.axisCount);
+    if(axisCount == 0){
+        return false;
+    }
+    while(axisCount % 4 != 0){
+        axisX[axisCount] = axisX[0];
+        axisY[axisCount] = axisY[0];
+        axisCount++;
+    }
+    return !separatedFunc()(axisX, axisY, axisCount, prepared.poly, poly2, gap - epsilon);
+}
+
+bool SATKernel::loadPolygon(const QVector<QPointF> &pList, Polygon &poly, const QPointF &offset)
+{
+    int len = pList.length();
+    if(len > 1 && pList[0] == pList[len-1]){  // 首尾相连时，忽略最后一点
+        len--;
+    }
+    if(len < 1 || len > SAT_MAX_VERTICES){
+        return false;
+    }
+    const QPointF *points = pList.constData();
+    const double ox = offset.x();
+    const double oy = offset.y();
+    for(int i=0; i<len; i++){
+        poly.x[i] = points[i].x() + ox;
+        poly.y[i] = points[i].y() + oy;
+    }
+    poly.n = len;
+    return true;
+}
+
+int SATKernel::appendAxes(const Polygon &poly, double *axisX, double *axisY, int axisCount)
+{
+    int len = poly.n;
+    for(int i=0; i<len; i++){
+        int j = (i + 1) % len;
+        double dx = poly.x[j] - poly.x[i];
+        double dy = poly.y[j] - poly.y[i];
+        double n2 = dx * dx + dy * dy;
+        if(n2 == 0){  // 防止前后两点重复导致错误
+            continue;
+        }
+        double inv = 1.0 / qSqrt(n2);
+        axisX[axisCount] = dy * inv;  // 法线向量
+        axisY[axisCount] = -dx * inv;
+        axisCount++;
+    }
+    return axisCount;
+}
+
+SATKernel::SeparatedFunc SATKernel::separatedFunc(KernelType type)
+{
+    switch (type) {
+    case AVX2Kernel:
+        return separatedAVX2;
+    case SSE2Kernel:
+        return separatedSSE2;
+    default:
+        return separatedScalar;
+    }
+}
+
+bool SATKernel::separatedScalar(const double *axisX, const double *axisY, int axisCount,
+                                const Polygon &poly1, const Polygon &poly2, double threshold)
+{
+    for(int a=0; a<axisCount; a++){
+        double ax = axisX[a];
+        double ay = axisY[a];
+        double min1 = DBL_MAX, max1 = -DBL_MAX;
+        double min2 = DBL_MAX, max2 = -DBL_MAX;
+        for(int i=0; i<poly1.n; i++){
+            double d = ax * poly1.x[i] + ay * poly1.y[i];
+            min1 = d < min1 ? d : min1;
+            max1 = d > max1 ? d : max1;
+        }
+        for(int i=0; i<poly2.n; i++){
+            double d = ax * poly2.x[i] + ay * poly2.y[i];
+            min2 = d < min2 ? d : min2;
+            max2 = d > max2 ? d : max2;
+        }
+        if(min1 >= max2 + threshold || min2 >= max1 + threshold){
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef SAT_X86_KERNEL
+bool SATKernel::separatedSSE2(const double *axisX, const double *axisY, int axisCount,
+                              const Polygon &poly1, const Polygon &poly2, double threshold)
+{
+    const __m128d thr = _mm_set1_pd(threshold);
+    for(int a=0; a<axisCount; a+=2){
+        __m128d ax = _mm_loadu_pd(axisX + a);
+        __m128d ay = _mm_loadu_pd(axisY + a);
+        __m128d min1 = _mm_set1_pd(DBL_MAX), max1 = _mm_set1_pd(-DBL_MAX);
+        __m128d min2 = _mm_set1_pd(DBL_MAX), max2 = _mm_set1_pd(-DBL_MAX);
+        for(int i=0; i<poly1.n; i++){
+            __m128d d = _mm_add_pd(_mm_mul_pd(ax, _mm_set1_pd(poly1.x[i])),
+                                   _mm_mul_pd(ay, _mm_set1_pd(poly1.y[i])));
+            min1 = _mm_min_pd(min1, d);
+            max1 = _mm_max_pd(max1, d);
+        }
+        for(int i=0; i<poly2.n; i++){
+            __m128d d = _mm_add_pd(_mm_mul_pd(ax, _mm_set1_pd(poly2.x[i])),
+                                   _mm_mul_pd(ay, _mm_set1_pd(poly2.y[i])));
+            min2 = _mm_min_pd(min2, d);
+            max2 = _mm_max_pd(max2, d);
+        }
+        __m128d s1 = _mm_cmpge_pd(min1, _mm_add_pd(max2, thr));
+        __m128d s2 = _mm_cmpge_pd(min2, _mm_add_pd(max1, thr));
+        if(_mm_movemask_pd(_mm_or_pd(s1, s2)) != 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+SAT_TARGET_AVX2
+bool SATKernel::separatedAVX2(const double *axisX, const double *axisY, int axisCount,
+                              const Polygon &poly1, const Polygon &poly2, double threshold)
+{
+    const __m256d thr = _mm256_set1_pd(threshold);
+    for(int a=0; a<axisCount; a+=4){
+        __m256d ax = _mm256_loadu_pd(axisX + a);
+        __m256d ay = _mm256_loadu_pd(axisY + a);
+        __m256d min1 = _mm256_set1_pd(DBL_MAX), max1 = _mm256_set1_pd(-DBL_MAX);
+        __m256d min2 = _mm256_set1_pd(DBL_MAX), max2 = _mm256_set1_pd(-DBL_MAX);
+        for(int i=0; i<poly1.n; i++){
+            __m256d d = _mm256_add_pd(_mm256_mul_pd(ax, _mm256_set1_pd(poly1.x[i])),
+                                      _mm256_mul_pd(ay, _mm256_set1_pd(poly1.y[i])));
+            min1 = _mm256_min_pd(min1, d);
+            max1 = _mm256_max_pd(max1, d);
+        }
+        for(int i=0; i<poly2.n; i++){
+            __m256d d = _mm256_add_pd(_mm256_mul_pd(ax, _mm256_set1_pd(poly2.x[i])),
+                                      _mm256_mul_pd(ay, _mm256_set1_pd(poly2.y[i])));
+            min2 = _mm256_min_pd(min2, d);
+            max2 = _mm256_max_pd(max2, d);
+        }
+        __m256d s1 = _mm256_cmp_pd(min1, _mm256_add_pd(max2, thr), _CMP_GE_OQ);
+        __m256d s2 = _mm256_cmp_pd(min2, _mm256_add_pd(max1, thr), _CMP_GE_OQ);
+        if(_mm256_movemask_pd(_mm256_or_pd(s1, s2)) != 0){
+            return true;
+        }
+    }
+    return false;
+}
+#else
+bool SATKernel::separatedSSE2(const double *axisX, const double *axisY, int axisCount,
+                              const Polygon &poly1, const Polygon &poly2, double threshold)
+{
+    return separatedScalar(axisX, axisY, axisCount, poly1, poly2, threshold);
+}
+
+bool SATKernel::separatedAVX2(const double *axisX, const double *axisY, int axisCount,
+                              const Polygon &poly1, const Polygon &poly2, double threshold)
+{
+    return separatedScalar(axisX, axisY, axisCount, poly1, poly2, threshold);
+}
+#endif
@@ -0,0 +1,83 @@
+#ifndef SATKERNEL_H
+#define SATKERNEL_H
+
+#include <QVector>
+#include <QPointF>
+#include "debug.h"
+
+#define SAT_MAX_VERTICES 128  // 内核支持的最大顶点数，超出时由调用者回退到原实现
+
+/**
+ * @brief The SATKernel class
+ * 凸多边形分离轴检测内核
+ * 顶点与分离轴都以结构数组(SoA)形式存放在栈上，检测过程中不分配内存；
+ * 每次同时计算4条(AVX2)或2条(SSE2)分离轴上两多边形的投影区间，
+ * 一组分离轴中只要有一条将两多边形分开，即可提前结束。
+ *
+ * 内核在编译期由debug.h中的SAT_SIMD_KERNEL开关选择，
+ * 运行时根据CPU是否支持AVX2自动选择，不支持时回退到SSE2/标量实现。
+ */
+class SATKernel
+{
+public:
+    enum KernelType{
+        ScalarKernel,
+        SSE2Kernel,
+        AVX2Kernel
+    };
+
+    struct Polygon{
+        double x[SAT_MAX_VERTICES];  // 顶点x坐标
+        double y[SAT_MAX_VERTICES];  // 顶点y坐标
+        int n;  // 顶点个数
+    };
+
+    /**
+     * 预先载入的凸多边形及其分离轴，用于一个多边形与多个多边形的批量检测，
+     * 分离轴只计算一次，检测时不再分配内存
+     */
+    struct PreparedPolygon{
+        Polygon poly;  // 已平移的顶点
+        double axisX[SAT_MAX_VERTICES];  // 各边的单位法线x分量
+        double axisY[SAT_MAX_VERTICES];  // 各边的单位法线y分量
+        int axisCount;  // 分离轴个数
+    };
+
+    static KernelType kernelType();  // 获取当前使用的内核
+    static bool convexPolygonCollision(const QVector<QPointF> &pList1,
+                                       const QVector<QPointF> &pList2,
+                                       short precision = 6,
+                                       const QPointF &offset2 = QPointF());  // 凸多边形碰撞检测，边界接触不算碰撞，凸多边形2平移offset2
+    static bool convexPolygonCollision(const QVector<QPointF> &pList1,
+                                       const QVector<QPointF> &pList2,
+                                       short precision,
+                                       KernelType type,
+                                       const QPointF &offset2 = QPointF());  // 使用指定内核检测，用于各内核结果对比
+    static bool preparePolygon(const QVector<QPointF> &pList, PreparedPolygon &prepared,
+                               const QPointF &offset = QPointF());  // 载入平移后的凸多边形并计算分离轴
+    static bool convexPolygonCollision(const PreparedPolygon &prepared,
+                                       const QVector<QPointF> &pList2,
+                                       const QPointF &offset2,
+                                       double gap,
+                                       double epsilon,
+                                       bool *ok = 0);  // 预载入的凸多边形与平移后的凸多边形间距检测
+
+private:
+    // 某条轴上 min1 >= max2 + threshold 或 min2 >= max1 + threshold 时视为分离
+    typedef bool (*SeparatedFunc)(const double *axisX, const double *axisY, int axisCount,
+                                  const Polygon &poly1, const Polygon &poly2, double threshold);
+
+    static bool loadPolygon(const QVector<QPointF> &pList, Polygon &poly,
+                            const QPointF &offset = QPointF());  // 转为结构数组
+    static int appendAxes(const Polygon &poly, double *axisX, double *axisY, int axisCount);  // 计算分离轴
+    static SeparatedFunc separatedFunc(KernelType type = kernelType());  // 根据内核类型获取检测函数
+
+    static bool separatedScalar(const double *axisX, const double *axisY, int axisCount,
+                                const Polygon &poly1, const Polygon &poly2, double threshold);
+    static bool separatedSSE2(const double *axisX, const double *axisY, int axisCount,
+                              const Polygon &poly1, const Polygon &poly2, double threshold);
+    static bool separatedAVX2(const double *axisX, const double *axisY, int axisCount,
+                              const Polygon &poly1, const Polygon &poly2, double threshold);
+};
+
+#endif // SATKERNEL_H
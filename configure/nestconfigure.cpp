@@ -12,7 +12,11 @@ NestConfigure::NestConfigure(QObject *parent) :
     backgroundColor(Qt::gray),
     showPiecesDistance(false),
     language(Chinese),
-    workPathStr("")
+    workPathStr(""),
+    simplifyTolerance(0),
+    tessellationTolerance(0.01),
+    nfpCollision(false),
+    partInPart(false)
 {
     settings = new QSettings(NEST_CONFG_FILE_PATH, QSettings::IniFormat);
     readConfig(settings);
@@ -154,6 +158,10 @@ void NestConfigure::writeConfigOthers(QSettings *settings)
     settings->setValue("other_showPiecesDistance", QVariant(showPiecesDistance));
     settings->setValue("other_language", QVariant(language));
     settings->setValue("other_workPathStr", QVariant(workPathStr));
+    settings->setValue("other_simplifyTolerance", QVariant(simplifyTolerance));
+    settings->setValue("other_tessellationTolerance", QVariant(tessellationTolerance));
+    settings->setValue("other_nfpCollision", QVariant(nfpCollision));
+    settings->setValue("other_partInPart", QVariant(partInPart));
     settings->endGroup();
 }
 
@@ -166,6 +174,10 @@ void NestConfigure::readConfigOthers(QSettings *settings)
     showPiecesDistance = settings->value("other_allowEntityOutOfSheet").toBool();
     language = (Language)settings->value("other_language").toInt();
     workPathStr = settings->value("other_workPathStr").toString();
+    simplifyTolerance = settings->value("other_simplifyTolerance", 0).toDouble();
+    tessellationTolerance = settings->value("other_tessellationTolerance", 0.01).toDouble();
+    nfpCollision = settings->value("other_nfpCollision", false).toBool();
+    partInPart = settings->value("other_partInPart", false).toBool();
     settings->endGroup();
 }
 
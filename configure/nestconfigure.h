@@ -125,6 +125,10 @@ public:
     bool showPiecesDistance;  // 显示切割件距离
     Language language;  // 语言
     QString workPathStr;  // 工作路径
+    double simplifyTolerance;  // 碰撞检测外轮廓的简化误差，为0时不简化
+    double tessellationTolerance;  // 导入时圆弧、圆、椭圆离散为折线的弦高误差
+    bool nfpCollision;  // 排版时使用临界多边形进行碰撞检测
+    bool partInPart;  // 排版时将零件排入已排零件的内孔
 
     // 配置文件
     QSettings *settings;  // 配置对象
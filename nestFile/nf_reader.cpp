@@ -119,6 +119,7 @@ bool NF_Reader::reader()
             for(int i=0; i<pieceOffsetList.length();i++){
                 qDebug() << "typeId: " << pieceOffsetList[i].typeId;
                 qDebug() << "count: " << pieceOffsetList[i].count;
+                qDebug() << "holeCount: " << pieceOffsetList[i].holeCount;
                 for(int j=0;j<pieceOffsetList[i].count;j++){
                     qDebug() << pieceOffsetList[i].pointsList[j].x << "  "
                              << pieceOffsetList[i].pointsList[j].y << "  "
@@ -370,7 +371,7 @@ bool NF_Reader::readPieceOffsetList(FILE *fp)
                 str2double(pieceOffset.reserve5, lineStr);
                 break;
             case 6:
-                str2int(pieceOffset.reserve6, lineStr);
+                str2int(pieceOffset.holeCount, lineStr);
                 break;
             case 7:
                 str2int(pieceOffset.count, lineStr);
@@ -385,36 +386,29 @@ bool NF_Reader::readPieceOffsetList(FILE *fp)
 
         // 获取点位
         lineTmp = 0;
-        while(lineTmp <= pieceOffset.count){
+        while(lineTmp < pieceOffset.count){
             getStrippedLine(lineStr, NF_TNF_MAXLINE, fp, false);
-            // 代表该字段结束
-            if(lineStr == "\n"){
-                continue;
-            }
-            char *tokenPtr = strtok((char*)lineStr.c_str(),",");
-            int temp = 0;
-            double px, py, pz;
-            while(tokenPtr!=NULL) {
-                if(temp == 0){
-                    str2double(px, tokenPtr);
-                }
-                else if(temp == 1){
-                    str2double(py, tokenPtr);
-                }
-                else if(temp == 2){
-                    str2double(pz, tokenPtr);
-                }
-                tokenPtr=strtok(NULL,",");
-                temp++;
-            }
-<<<<<<< HEAD
-            PiecePointsList points(px, py, pz);
-=======
-            PiecePoint points(px, py, pz);
->>>>>>> Jeremy
-            pieceOffset.pointsList.append(points);
+            pieceOffset.pointsList.append(readPiecePoint(lineStr));
             lineTmp++;
         }
+
+        // 获取内孔点位，每个内孔先是点数再是点位
+        for(int i=0; i<pieceOffset.holeCount; i++){
+            int holePointCount = 0;
+            getStrippedLine(lineStr, NF_TNF_MAXLINE, fp, false);
+            str2int(holePointCount, lineStr);
+            QVector<PiecePoint> hole;
+            for(int j=0; j<holePointCount; j++){
+                getStrippedLine(lineStr, NF_TNF_MAXLINE, fp, false);
+                hole.append(readPiecePoint(lineStr));
+            }
+            pieceOffset.holesList.append(hole);
+            lineTmp += holePointCount + 1;
+        }
+
+        // 代表该字段结束的空行
+        getStrippedLine(lineStr, NF_TNF_MAXLINE, fp, false);
+        lineTmp++;
         pieceOffsetList.append(pieceOffset);
         line += lineTmp;
         count++;
@@ -422,6 +416,33 @@ bool NF_Reader::readPieceOffsetList(FILE *fp)
     return true;
 }
 
+/**
+ * @brief NF_Reader::readPiecePoint
+ * 解析以逗号分隔的点位 x,y,z
+ * @param s 点位所在行
+ * @return 点位
+ */
+PiecePoint NF_Reader::readPiecePoint(std::string s)
+{
+    PiecePoint point;
+    char *tokenPtr = strtok((char*)s.c_str(),",");
+    int temp = 0;
+    while(tokenPtr!=NULL) {
+        if(temp == 0){
+            str2double(point.x, tokenPtr);
+        }
+        else if(temp == 1){
+            str2double(point.y, tokenPtr);
+        }
+        else if(temp == 2){
+            str2double(point.z, tokenPtr);
+        }
+        tokenPtr=strtok(NULL,",");
+        temp++;
+    }
+    return point;
+}
+
 bool NF_Reader::getStrippedLine(std::string &s, unsigned int size, FILE *fp, bool stripSpace)
 {
     if (!feof(fp)) {
@@ -22,6 +22,7 @@ public:
     bool readPieceOffsetHeaderList(FILE *fp);
     bool readPieceOffsetCount(FILE *fp);
     bool readPieceOffsetList(FILE *fp);
+    PiecePoint readPiecePoint(std::string s);  // 解析点位
 
     bool getStrippedLine(std::string& s, unsigned int size,
                                FILE* fp, bool stripSpace = true);
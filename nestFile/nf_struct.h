@@ -100,12 +100,13 @@ struct PieceOffset
     double reserve3;
     std::string reserve4;
     double reserve5;
-    int reserve6;
+    int holeCount;  // 内孔个数，旧文件中为保留值0
     int count;
 <<<<<<< HEAD
     QList<PiecePointsList> pointsList;
 =======
     QVector<PiecePoint> pointsList;
+    QVector<QVector<PiecePoint>> holesList;  // 内孔点列表，点位相对零件中心，与外轮廓相同
 >>>>>>> Jeremy
 
     PieceOffset() :
@@ -115,7 +116,7 @@ struct PieceOffset
         reserve3(0.000),
         reserve4(""),
         reserve5(0.000),
-        reserve6(0),
+        holeCount(0),
         count(0)
     {
 <<<<<<< HEAD
@@ -132,7 +133,9 @@ struct PieceOffset
     PieceOffset(int i, double res1, double res2,
                 double  res3, std::string res4,
                 double res5, int res6,
-                int c, QVector<PiecePoint> list) {
+                int c, QVector<PiecePoint> list,
+                QVector<QVector<PiecePoint>> holes = QVector<QVector<PiecePoint>>()) {
+        holesList = holes;
 >>>>>>> Jeremy
         typeId = i;
         reserve1 = res1;
@@ -140,7 +143,7 @@ struct PieceOffset
         reserve3 = res3;
         reserve4 = res4;
         reserve5 = res5;
-        reserve6 = res6;
+        holeCount = res6;
         count = c;
 <<<<<<< HEAD
         pointsList.append(list);
@@ -115,7 +115,7 @@ void NF_Writer::writePieceOffset(const QList<PieceOffset> &pieceOffsetList)
         m_ofile << pieceOffset.reserve3 << ENDL;
         m_ofile << pieceOffset.reserve4 << ENDL;
         m_ofile << pieceOffset.reserve5 << ENDL;
-        m_ofile << pieceOffset.reserve6 << ENDL;
+        m_ofile << pieceOffset.holesList.length() << ENDL;
         m_ofile << pieceOffset.count << ENDL;
         for(int i=0; i<pieceOffset.pointsList.length(); i++){
             m_ofile << pieceOffset.pointsList[i].x << ","
@@ -123,6 +123,16 @@ void NF_Writer::writePieceOffset(const QList<PieceOffset> &pieceOffsetList)
                     << pieceOffset.pointsList[i].z << ENDL ;
 
         }
+        // 内孔紧跟外轮廓，每个内孔先写点数再写点位
+        for(int i=0; i<pieceOffset.holesList.length(); i++){
+            const QVector<PiecePoint> &hole = pieceOffset.holesList[i];
+            m_ofile << hole.length() << ENDL;
+            for(int j=0; j<hole.length(); j++){
+                m_ofile << hole[j].x << ","
+                        << hole[j].y << ","
+                        << hole[j].z << ENDL ;
+            }
+        }
         m_ofile << ENDL;
     }
 }
@@ -0,0 +1,33 @@
+#-------------------------------------------------
+#
+# 几何与排版算法的单元测试，qmake tests.pro && make check
+#
+#-------------------------------------------------
+
+QT       += core gui testlib
+QT       -= widgets
+
+TARGET = tst_common
+TEMPLATE = app
+CONFIG += testcase console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ../common
+
+SOURCES += \
+    tst_common.cpp \
+    ../common/common.cpp \
+    ../common/nofitpolygon.cpp \
+    ../common/occupancyraster.cpp \
+    ../common/polygonoffset.cpp \
+    ../common/satkernel.cpp
+
+HEADERS += \
+    ../common/debug.h \
+    ../common/common.h \
+    ../common/nofitpolygon.h \
+    ../common/occupancyraster.h \
+    ../common/polygonoffset.h \
+    ../common/satkernel.h
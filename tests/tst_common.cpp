@@ -0,0 +1,404 @@
+#include <QtTest>
+#include "common.h"
+#include "satkernel.h"
+#include "occupancyraster.h"
+
+class TestCommon : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void minimizeRotateAngle_data();
+    void minimizeRotateAngle();
+    void minimizeRotateAngleUpperBound();
+    void satKernelMatchesScalar_data();
+    void satKernelMatchesScalar();
+    void minBoundingRectMatchesBruteForce();
+    void occupancyRasterOverlapImpliesCollision();
+    void polygonContainsPolygon();
+};
+
+// 代表性零件：矩形、三角形、梯形、L形、凹箭头、不规则多边形，首尾相连
+static QVector<QVector<QPointF>> representativePieces()
+{
+    QVector<QVector<QPointF>> pieceList;
+    pieceList.append(QVector<QPointF>() << QPointF(0, 0) << QPointF(100, 0) << QPointF(100, 40)
+                     << QPointF(0, 40) << QPointF(0, 0));
+    pieceList.append(QVector<QPointF>() << QPointF(0, 0) << QPointF(80, 0) << QPointF(0, 50) << QPointF(0, 0));
+    pieceList.append(QVector<QPointF>() << QPointF(0, 0) << QPointF(120, 0) << QPointF(90, 45)
+                     << QPointF(20, 45) << QPointF(0, 0));
+    pieceList.append(QVector<QPointF>() << QPointF(0, 0) << QPointF(90, 0) << QPointF(90, 25)
+                     << QPointF(30, 25) << QPointF(30, 70) << QPointF(0, 70) << QPointF(0, 0));
+    pieceList.append(QVector<QPointF>() << QPointF(0, 20) << QPointF(60, 20) << QPointF(60, 0)
+                     << QPointF(100, 35) << QPointF(60, 70) << QPointF(60, 50) << QPointF(0, 50)
+                     << QPointF(15, 35) << QPointF(0, 20));
+    pieceList.append(QVector<QPointF>() << QPointF(3, 0) << QPointF(71, 8) << QPointF(96, 37)
+                     << QPointF(64, 61) << QPointF(38, 44) << QPointF(11, 58) << QPointF(-6, 27)
+                     << QPointF(3, 0));
+    return pieceList;
+}
+
+// 单排目标值：旋转后外包矩形高度 × 顶点到对边的最大水平距离
+static qreal singleRowObjective(const QVector<QPointF> &points, qreal angle)
+{
+    QVector<QPointF> rotated;
+    foreach (const QPointF &p, points) {
+        rotated.append(transformRotate(QPointF(0, 0), p, angle));
+    }
+    QRectF rect = calculatePolygonBoundingRect(rotated);
+    return rect.height() * calVerToOppSideXDis(rotated);
+}
+
+void TestCommon::minimizeRotateAngle_data()
+{
+    QTest::addColumn<int>("piece");
+    QTest::addColumn<int>("maxAngle");
+    QTest::addColumn<int>("coarseStep");
+    QTest::addColumn<qreal>("relativeTolerance");
+
+    const int maxAngleList[] = {45, 90, 180};  // 含不是10的整数倍的最大角度
+    int count = representativePieces().length();
+    for(int i=0; i<count; i++){
+        for(int maxAngle : maxAngleList){
+            // 1°粗扫描的结果不能差于1°遍历
+            QTest::newRow(qPrintable(QString("piece%1 max%2 step1").arg(i).arg(maxAngle)))
+                    << i << maxAngle << 1 << 0.0;
+            // 10°粗扫描加细化，与1°遍历的差距在细化精度以内
+            QTest::newRow(qPrintable(QString("piece%1 max%2 step10").arg(i).arg(maxAngle)))
+                    << i << maxAngle << 10 << 1e-4;
+        }
+    }
+}
+
+void TestCommon::minimizeRotateAngle()
+{
+    QFETCH(int, piece);
+    QFETCH(int, maxAngle);
+    QFETCH(int, coarseStep);
+    QFETCH(qreal, relativeTolerance);
+
+    const QVector<QPointF> points = representativePieces().at(piece);
+    auto objective = [&points](qreal angle){ return singleRowObjective(points, angle); };
+
+    qreal sweepMinZ = LONG_MAX;
+    for(int i=0; i<=maxAngle; i++){
+        sweepMinZ = qMin(sweepMinZ, objective(i));
+    }
+
+    qreal alpha = 0;
+    int evaluations = 0;
+    qreal minZ = ::minimizeRotateAngle(objective, 0, maxAngle, coarseStep, 0.01, 20, alpha, evaluations);
+    QVERIFY2(minZ <= sweepMinZ * (1 + relativeTolerance),
+             qPrintable(QString("minZ %1 > sweep %2").arg(minZ, 0, 'g', 17).arg(sweepMinZ, 0, 'g', 17)));
+    QVERIFY(alpha >= 0 && alpha <= maxAngle);
+    QCOMPARE(objective(alpha), minZ);
+}
+
+void TestCommon::minimizeRotateAngleUpperBound()
+{
+    // 最大角度不是粗扫描步长的整数倍时，最大角度也必须参与扫描
+    auto objective = [](qreal angle){ return qAbs(angle - 45) < 1e-9 ? 0.0 : 100.0; };
+    qreal alpha = 0;
+    int evaluations = 0;
+    qreal minZ = ::minimizeRotateAngle(objective, 0, 45, 10, 0.01, 0, alpha, evaluations);
+    QCOMPARE(minZ, 0.0);
+    QCOMPARE(alpha, 45.0);
+    QCOMPARE(evaluations, 6);
+}
+
+// 随机凸多边形：圆上随机角度的点按角度排序后做仿射变换，逆时针，首尾不重复
+static QVector<QPointF> randomConvexPolygon(int n)
+{
+    QVector<qreal> angles;
+    for(int i=0; i<n; i++){
+        angles.append(qrand() % 36000 / 18000.0 * M_PI);
+    }
+    std::sort(angles.begin(), angles.end());
+    qreal rx = 5 + qrand() % 100;
+    qreal ry = 5 + qrand() % 100;
+    qreal theta = qrand() % 360 / 180.0 * M_PI;
+    QPointF center(qrand() % 200 - 100, qrand() % 200 - 100);
+    QVector<QPointF> points;
+    for(int i=0; i<n; i++){
+        QPointF p(rx * qCos(angles[i]), ry * qSin(angles[i]));
+        QPointF q(p.x() * qCos(theta) - p.y() * qSin(theta), p.x() * qSin(theta) + p.y() * qCos(theta));
+        if(points.isEmpty() || points.last() != center + q){
+            points.append(center + q);
+        }
+    }
+    return points;
+}
+
+void TestCommon::satKernelMatchesScalar_data()
+{
+    QTest::addColumn<int>("kernel");
+    QTest::addColumn<int>("precision");
+
+    QTest::newRow("sse2 precision6") << int(SATKernel::SSE2Kernel) << 6;
+    QTest::newRow("sse2 precision3") << int(SATKernel::SSE2Kernel) << 3;
+    QTest::newRow("avx2 precision6") << int(SATKernel::AVX2Kernel) << 6;
+    QTest::newRow("avx2 precision3") << int(SATKernel::AVX2Kernel) << 3;
+}
+
+void TestCommon::satKernelMatchesScalar()
+{
+    QFETCH(int, kernel);
+    QFETCH(int, precision);
+
+    if(kernel == SATKernel::AVX2Kernel && SATKernel::kernelType() != SATKernel::AVX2Kernel){
+        QSKIP("CPU不支持AVX2");
+    }
+
+    // 第二个多边形沿第一个多边形的某条边法线平移到刚好接触，再偏移容差附近的距离，
+    // 切向对齐两多边形的投影中心，使该边法线成为唯一可能的分离轴；
+    // 向量化内核与标量内核使用相同的容差，两种参数顺序的结果都必须完全一致；
+    // 以offset2传入平移量时，结果与先平移点集再检测一致
+    const qreal epsilon = qPow(10.0, -precision);
+    const qreal shiftList[] = {-2, -1.5, -1, -0.75, -0.5, 0, 0.5, 1, 2};  // 以容差为单位
+    qsrand(2026 + kernel * 10 + precision);
+    int mismatchCount = 0;
+    int offsetMismatchCount = 0;
+    int collidedCount = 0;
+    int testCount = 0;
+    for(int k=0; k<500; k++){
+        QVector<QPointF> pList1 = randomConvexPolygon(3 + qrand() % 40);
+        QVector<QPointF> pList2 = randomConvexPolygon(3 + qrand() % 40);
+        if(pList1.length() < 3 || pList2.length() < 3){
+            continue;
+        }
+        int edge = qrand() % pList1.length();
+        QPointF d = pList1[(edge+1)%pList1.length()] - pList1[edge];
+        QPointF axis(d.y(), -d.x());  // 逆时针多边形的外法线
+        axis /= qSqrt(axis.x() * axis.x() + axis.y() * axis.y());
+        QPointF tangent(-axis.y(), axis.x());
+        qreal max1 = -LONG_MAX, min2 = LONG_MAX;
+        qreal center1 = 0, center2 = 0;
+        foreach (const QPointF &p, pList1) {
+            max1 = qMax(max1, p.x() * axis.x() + p.y() * axis.y());
+            center1 += (p.x() * tangent.x() + p.y() * tangent.y()) / pList1.length();
+        }
+        foreach (const QPointF &p, pList2) {
+            min2 = qMin(min2, p.x() * axis.x() + p.y() * axis.y());
+            center2 += (p.x() * tangent.x() + p.y() * tangent.y()) / pList2.length();
+        }
+        for(qreal shift : shiftList){
+            QVector<QPointF> moved;
+            QPointF offset = axis * (max1 - min2 + shift * epsilon) + tangent * (center1 - center2);
+            foreach (const QPointF &p, pList2) {
+                moved.append(p + offset);
+            }
+            for(int order=0; order<2; order++){
+                const QVector<QPointF> &a = order == 0 ? pList1 : moved;
+                const QVector<QPointF> &b = order == 0 ? moved : pList1;
+                bool ret = SATKernel::convexPolygonCollision(a, b, precision, SATKernel::KernelType(kernel));
+                bool scalarRet = SATKernel::convexPolygonCollision(a, b, precision, SATKernel::ScalarKernel);
+                if(ret != scalarRet){
+                    mismatchCount++;
+                }
+                if(scalarRet){
+                    collidedCount++;
+                }
+                testCount++;
+            }
+            if(SATKernel::convexPolygonCollision(pList1, pList2, precision, SATKernel::KernelType(kernel), offset)
+                    != SATKernel::convexPolygonCollision(pList1, moved, precision, SATKernel::KernelType(kernel))){
+                offsetMismatchCount++;
+            }
+        }
+    }
+    QVERIFY2(mismatchCount == 0, qPrintable(QString("%1 of %2 mismatched").arg(mismatchCount).arg(testCount)));
+    QVERIFY2(offsetMismatchCount == 0, qPrintable(QString("%1 offset results mismatched").arg(offsetMismatchCount)));
+    QVERIFY(collidedCount > 0 && collidedCount < testCount);  // 接触附近两种结果都要覆盖到
+}
+
+void TestCommon::minBoundingRectMatchesBruteForce()
+{
+    // 最小包络矩形必有一边与凸包的某条边共线，凸包的边由点对确定，
+    // 遍历所有点对方向得到的最小面积即为真值
+    QVector<QVector<QPointF>> pieceList = representativePieces();
+    qsrand(2026);
+    for(int k=0; k<50; k++){
+        QVector<QPointF> points;
+        int n = 3 + qrand() % 40;
+        for(int i=0; i<n; i++){  // 星形多边形，含凹点
+            qreal angle = 2 * M_PI * i / n;
+            qreal r = 10 + qrand() % 90;
+            points.append(QPointF(r * qCos(angle), 0.5 * r * qSin(angle)));
+        }
+        pieceList.append(points);
+    }
+
+    for(int k=0; k<pieceList.length(); k++){
+        const QVector<QPointF> &points = pieceList[k];
+        qreal alpha;
+        QRectF minBoundingRect;
+        double area = calculatePloygonMinBoundingRectArea(points, alpha, minBoundingRect);
+
+        double bruteArea = LONG_MAX;
+        for(int i=0; i<points.length(); i++){
+            for(int j=0; j<points.length(); j++){
+                if(points[i] == points[j]){
+                    continue;
+                }
+                qreal angle = QLineF(points[i], points[j]).angle();
+                QVector<QPointF> rotated;
+                foreach (const QPointF &p, points) {
+                    rotated.append(transformRotate(QPointF(0, 0), p, -angle));
+                }
+                QRectF rect = calculatePolygonBoundingRect(rotated);
+                bruteArea = qMin(bruteArea, rect.width() * rect.height());
+            }
+        }
+        QVERIFY2(qAbs(area - bruteArea) <= 1e-9 * bruteArea,
+                 qPrintable(QString("piece%1: %2 vs %3").arg(k).arg(area, 0, 'g', 17).arg(bruteArea, 0, 'g', 17)));
+
+        // 返回的矩形为点集旋转-alpha度之后的外包矩形
+        QVector<QPointF> rotated;
+        foreach (const QPointF &p, points) {
+            rotated.append(transformRotate(QPointF(0, 0), p, -alpha));
+        }
+        QRectF rect = calculatePolygonBoundingRect(rotated);
+        QVERIFY(qAbs(rect.width() * rect.height() - area) <= 1e-9 * area);
+        QVERIFY(qAbs(minBoundingRect.width() * minBoundingRect.height() - area) <= 1e-9 * area);
+    }
+}
+
+// 点是否在带内孔的多边形内部，各环的交点一起按奇偶规则
+static bool pointInLoops(const QVector<QVector<QPointF>> &loopsList, const QPointF &point)
+{
+    bool inside = false;
+    foreach (const QVector<QPointF> &loop, loopsList) {
+        int len = loop.length();
+        for(int i=0; i<len; i++){
+            const QPointF &p1 = loop[i];
+            const QPointF &p2 = loop[(i+1)%len];
+            if((p1.y() <= point.y() && point.y() < p2.y()) || (p2.y() <= point.y() && point.y() < p1.y())){
+                if(p1.x() + (point.y() - p1.y()) * (p2.x() - p1.x()) / (p2.y() - p1.y()) > point.x()){
+                    inside = !inside;
+                }
+            }
+        }
+    }
+    return inside;
+}
+
+// 带内孔的多边形平移offset
+static QVector<QVector<QPointF>> translatedLoops(const QVector<QVector<QPointF>> &loopsList, const QPointF &offset)
+{
+    QVector<QVector<QPointF>> ret;
+    foreach (const QVector<QPointF> &loop, loopsList) {
+        QVector<QPointF> moved;
+        foreach (const QPointF &p, loop) {
+            moved.append(p + offset);
+        }
+        ret.append(moved);
+    }
+    return ret;
+}
+
+void TestCommon::occupancyRasterOverlapImpliesCollision()
+{
+    // 与PackPointNestEngine的用法一致：已排零件标记到材料栅格，待排零件在原点栅格化，
+    // 按参考点所在的材料栅格整体偏移后求共同标记。
+    // 共同标记的材料栅格同时被两个零件完全覆盖，其中心必在两个零件内部；
+    // 零件放在已排零件的内孔中时不得有共同标记
+    QVector<QVector<QPointF>> pieceList = representativePieces();
+    QVector<QVector<QPointF>> frame;  // 带内孔的方框
+    frame.append(QVector<QPointF>() << QPointF(0, 0) << QPointF(200, 0) << QPointF(200, 200)
+                 << QPointF(0, 200) << QPointF(0, 0));
+    frame.append(QVector<QPointF>() << QPointF(50, 50) << QPointF(150, 50) << QPointF(150, 150)
+                 << QPointF(50, 150) << QPointF(50, 50));
+    QVector<QVector<QPointF>> square;
+    square.append(QVector<QPointF>() << QPointF(0, 0) << QPointF(40, 0) << QPointF(40, 40)
+                  << QPointF(0, 40) << QPointF(0, 0));
+    const QPointF origin(10, 10);  // 材料排版区域左上角
+    const qreal resolutionList[] = {1, 2.5};
+    qsrand(2026);
+    for(qreal resolution : resolutionList){
+        auto overlapsAt = [&](const OccupancyRaster &sheetRaster, const OccupancyRaster &pieceRaster,
+                              const QPointF &pos, int &columnOffset, int &rowOffset){
+            columnOffset = pieceRaster.getOriginColumn() + qFloor((pos.x() - origin.x()) / resolution);
+            rowOffset = pieceRaster.getOriginRow() + qFloor((pos.y() - origin.y()) / resolution);
+            return sheetRaster.overlaps(pieceRaster, columnOffset, rowOffset);
+        };
+        int columnOffset, rowOffset;
+
+        // 方框内孔中的零件不碰撞，压在方框上的零件碰撞
+        OccupancyRaster frameRaster(qCeil(500 / resolution), qCeil(500 / resolution));
+        frameRaster.fillPolygon(translatedLoops(frame, QPointF(100, 100)), origin, resolution);
+        OccupancyRaster squareRaster = OccupancyRaster::fromPolygon(square, resolution);
+        QVERIFY(!overlapsAt(frameRaster, squareRaster, QPointF(180.3, 180.7), columnOffset, rowOffset));
+        QVERIFY(overlapsAt(frameRaster, squareRaster, QPointF(110.3, 180.7), columnOffset, rowOffset));
+
+        int overlapTotal = 0;
+        int wrongCount = 0;
+        for(int k=0; k<200; k++){
+            QVector<QVector<QPointF>> placed;  // 已排零件
+            if(k % 4 == 0){
+                placed = frame;
+            } else{
+                placed.append(pieceList[qrand() % pieceList.length()]);
+            }
+            placed = translatedLoops(placed, QPointF(qrand() % 200, qrand() % 200));
+            OccupancyRaster sheetRaster(qCeil(500 / resolution), qCeil(500 / resolution));
+            sheetRaster.fillPolygon(placed, origin, resolution);
+
+            QVector<QVector<QPointF>> piece;  // 待排零件，参考点位于原点
+            piece.append(pieceList[qrand() % pieceList.length()]);
+            OccupancyRaster pieceRaster = OccupancyRaster::fromPolygon(piece, resolution);
+            QPointF pos(qrand() % 30000 / 100.0, qrand() % 30000 / 100.0);
+            bool overlaps = overlapsAt(sheetRaster, pieceRaster, pos, columnOffset, rowOffset);
+            if(overlaps){
+                overlapTotal++;
+            }
+
+            // 逐个栅格求共同标记，与按字相与的结果一致
+            QVector<QVector<QPointF>> moved = translatedLoops(piece, pos);
+            int sharedCount = 0;
+            for(int r=0; r<pieceRaster.getRows(); r++){
+                for(int c=0; c<pieceRaster.getColumns(); c++){
+                    if(!pieceRaster.testBit(c, r) || !sheetRaster.testBit(c + columnOffset, r + rowOffset)){
+                        continue;
+                    }
+                    sharedCount++;
+                    QPointF center = origin + QPointF(c + columnOffset + 0.5, r + rowOffset + 0.5) * resolution;
+                    if(!pointInLoops(placed, center) || !pointInLoops(moved, center)){
+                        wrongCount++;
+                    }
+                }
+            }
+            QCOMPARE(sheetRaster.overlapCount(pieceRaster, columnOffset, rowOffset), sharedCount);
+            QCOMPARE(overlaps, sharedCount > 0);
+        }
+        QVERIFY2(wrongCount == 0, qPrintable(QString("%1 shared cells outside the pieces").arg(wrongCount)));
+        QVERIFY(overlapTotal > 0 && overlapTotal < 200);  // 碰撞与不碰撞两种结果都要覆盖到
+    }
+}
+
+void TestCommon::polygonContainsPolygon()
+{
+    // L形外轮廓，凹角在(30, 25)
+    QVector<QPointF> outer = representativePieces()[3];
+    // 完全在内部
+    QVERIFY(::polygonContainsPolygon(outer, QVector<QPointF>() << QPointF(5, 5) << QPointF(20, 5)
+                                     << QPointF(20, 60) << QPointF(5, 60) << QPointF(5, 5)));
+    // 与外轮廓共边
+    QVERIFY(::polygonContainsPolygon(outer, QVector<QPointF>() << QPointF(0, 0) << QPointF(30, 0)
+                                     << QPointF(30, 70) << QPointF(0, 70)));
+    // 第一个顶点在内部，其余部分与外轮廓交叉
+    QVERIFY(!::polygonContainsPolygon(outer, QVector<QPointF>() << QPointF(10, 10) << QPointF(120, 10)
+                                      << QPointF(120, 40) << QPointF(10, 40)));
+    // 顶点都在内部，一条边穿过凹入部分
+    QVERIFY(!::polygonContainsPolygon(outer, QVector<QPointF>() << QPointF(10, 10) << QPointF(80, 10)
+                                      << QPointF(20, 60)));
+    // 顶点都在外轮廓上，一条边穿过凹入部分
+    QVERIFY(!::polygonContainsPolygon(outer, QVector<QPointF>() << QPointF(0, 0) << QPointF(90, 25)
+                                      << QPointF(30, 70)));
+    // 外轮廓包含内孔，内孔不包含外轮廓
+    QVector<QPointF> hole = QVector<QPointF>() << QPointF(5, 5) << QPointF(20, 5) << QPointF(20, 20);
+    QVERIFY(!::polygonContainsPolygon(hole, outer));
+}
+
+QTEST_APPLESS_MAIN(TestCommon)
+
+#include "tst_common.moc"